@@ -0,0 +1,287 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Multi-threaded benchmarks for the stats recording and span lifecycle paths.
+// Each benchmark reports, in addition to throughput (items_per_second):
+//  - p50_ns, p99_ns: per-operation latency percentiles, averaged over threads.
+//  - lock_wait_ns: time spent waiting for contended absl::Mutexes (anywhere
+//    in the process) per operation.
+//  - allocs, bytes: heap allocations per operation by the benchmark thread.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/internal/cycleclock.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/stats/stats.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+
+namespace opencensus {
+namespace {
+
+constexpr int kMaxThreads = 16;
+
+int64_t CycleClockNow() { return absl::base_internal::CycleClock::Now(); }
+
+double CyclesToNanos(double cycles) {
+  return cycles * 1e9 / absl::base_internal::CycleClock::Frequency();
+}
+
+// Total cycles spent waiting on contended absl::Mutexes by all threads.
+std::atomic<int64_t> lock_wait_cycles(0);
+
+void RecordLockWait(int64_t wait_cycles) {
+  lock_wait_cycles.fetch_add(wait_cycles, std::memory_order_relaxed);
+}
+
+// A log-linear histogram of latencies in cycles, with 8 sub-buckets per power
+// of two (so percentiles are accurate to within 12.5%). Adding a value does not
+// allocate.
+class LatencyHistogram {
+ public:
+  void Add(int64_t cycles) {
+    ++buckets_[BucketForValue(cycles < 0 ? 0 : cycles)];
+    ++count_;
+  }
+
+  // Returns the upper bound of the bucket containing the given percentile, in
+  // cycles.
+  double Percentile(double percentile) const {
+    const uint64_t rank = static_cast<uint64_t>(count_ * percentile / 100);
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+      seen += buckets_[i];
+      if (seen > rank) return BucketUpperBound(i);
+    }
+    return BucketUpperBound(kNumBuckets - 1);
+  }
+
+ private:
+  static constexpr int kSubBuckets = 8;
+  static constexpr int kNumBuckets = 64 * kSubBuckets;
+
+  static int BucketForValue(uint64_t value) {
+    int shift = 0;
+    while (value >= 2 * kSubBuckets) {
+      value >>= 1;
+      ++shift;
+    }
+    return shift * kSubBuckets + static_cast<int>(value);
+  }
+
+  static double BucketUpperBound(int bucket) {
+    if (bucket < 2 * kSubBuckets) return bucket + 1;
+    const int shift = bucket / kSubBuckets - 1;
+    const uint64_t value = bucket % kSubBuckets + kSubBuckets;
+    return static_cast<double>((value + 1) << shift);
+  }
+
+  uint64_t buckets_[kNumBuckets] = {};
+  uint64_t count_ = 0;
+};
+
+// Measures per-operation latency and process-wide lock wait time for the
+// current benchmark thread, and reports them as counters on destruction.
+// Construct immediately before the benchmark loop, and wrap each operation in
+// Start()/Stop().
+class ContentionReporter {
+ public:
+  explicit ContentionReporter(benchmark::State* state)
+      : state_(state),
+        start_lock_wait_(lock_wait_cycles.load(std::memory_order_relaxed)) {
+    static bool registered = [] {
+      absl::RegisterMutexProfiler(&RecordLockWait);
+      return true;
+    }();
+    (void)registered;
+  }
+
+  ~ContentionReporter() {
+    const int64_t lock_wait =
+        lock_wait_cycles.load(std::memory_order_relaxed) - start_lock_wait_;
+    state_->SetItemsProcessed(state_->iterations());
+    state_->counters["p50_ns"] =
+        benchmark::Counter(CyclesToNanos(latency_.Percentile(50)),
+                           benchmark::Counter::kAvgThreads);
+    state_->counters["p99_ns"] =
+        benchmark::Counter(CyclesToNanos(latency_.Percentile(99)),
+                           benchmark::Counter::kAvgThreads);
+    // Every thread observes the process-wide wait over (roughly) the same
+    // window, so average over threads before dividing by total iterations.
+    state_->counters["lock_wait_ns"] = benchmark::Counter(
+        CyclesToNanos(lock_wait),
+        static_cast<benchmark::Counter::Flags>(
+            benchmark::Counter::kAvgThreads |
+            benchmark::Counter::kAvgIterations));
+  }
+
+  void Start() { start_ = CycleClockNow(); }
+  void Stop() { latency_.Add(CycleClockNow() - start_); }
+
+ private:
+  benchmark::State* const state_;
+  const int64_t start_lock_wait_;
+  int64_t start_ = 0;
+  LatencyHistogram latency_;
+};
+
+// Stats setup shared by all benchmarks: a measure with count, sum and
+// distribution views, registered for export so that scrapes see them.
+struct StatsSetup {
+  StatsSetup()
+      : key1(stats::TagKey::Register("contention_key1")),
+        key2(stats::TagKey::Register("contention_key2")),
+        measure(stats::MeasureDouble::Register("contention_measure", "", "")) {
+    const stats::Aggregation aggregations[] = {
+        stats::Aggregation::Count(), stats::Aggregation::Sum(),
+        stats::Aggregation::Distribution(
+            stats::BucketBoundaries::Exponential(10, 10, 2))};
+    for (int i = 0; i < 3; ++i) {
+      stats::ViewDescriptor()
+          .set_name(absl::StrCat("contention_view", i))
+          .set_measure("contention_measure")
+          .set_aggregation(aggregations[i])
+          .add_column(key1)
+          .add_column(key2)
+          .RegisterForExport();
+    }
+    for (int i = 0; i < 10; ++i) {
+      tag_values.push_back(absl::StrCat("value", i));
+    }
+  }
+
+  static const StatsSetup& Get() {
+    static const StatsSetup* setup = new StatsSetup;
+    return *setup;
+  }
+
+  const stats::TagKey key1;
+  const stats::TagKey key2;
+  const stats::MeasureDouble measure;
+  std::vector<std::string> tag_values;
+};
+
+// A span exporter that drops all spans, so that the cost of the export path
+// (buffering and SpanData conversion) is included.
+class NullSpanExporter : public trace::exporter::SpanExporter::Handler {
+ public:
+  static void Register() {
+    static bool registered = [] {
+      trace::exporter::SpanExporter::RegisterHandler(
+          absl::make_unique<NullSpanExporter>());
+      return true;
+    }();
+    (void)registered;
+  }
+
+  void Export(const std::vector<trace::exporter::SpanData>& spans) override {
+    benchmark::DoNotOptimize(spans.data());
+  }
+};
+
+void RecordOnce(const StatsSetup& setup, int iteration, int thread_index) {
+  stats::Record(
+      {{setup.measure, static_cast<double>(iteration)}},
+      {{setup.key1, setup.tag_values[iteration % setup.tag_values.size()]},
+       {setup.key2, setup.tag_values[thread_index % setup.tag_values.size()]}});
+}
+
+void BM_RecordContended(benchmark::State& state) {
+  const StatsSetup& setup = StatsSetup::Get();
+  int iteration = 0;
+  ContentionReporter reporter(&state);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    reporter.Start();
+    RecordOnce(setup, iteration++, state.thread_index());
+    reporter.Stop();
+  }
+}
+BENCHMARK(BM_RecordContended)->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+// Sampled spans touch the running span store, the local span store and the
+// exporter buffer.
+void BM_StartEndSampledSpanContended(benchmark::State& state) {
+  static trace::AlwaysSampler sampler;
+  NullSpanExporter::Register();
+  ContentionReporter reporter(&state);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    reporter.Start();
+    auto span = trace::Span::StartSpan("SpanName", /*parent=*/nullptr,
+                                       {&sampler});
+    span.End();
+    reporter.Stop();
+  }
+}
+BENCHMARK(BM_StartEndSampledSpanContended)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+// Unsampled spans only generate ids.
+void BM_StartEndUnsampledSpanContended(benchmark::State& state) {
+  static trace::NeverSampler sampler;
+  ContentionReporter reporter(&state);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    reporter.Start();
+    auto span = trace::Span::StartSpan("SpanName", /*parent=*/nullptr,
+                                       {&sampler});
+    span.End();
+    reporter.Stop();
+  }
+}
+BENCHMARK(BM_StartEndUnsampledSpanContended)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+// Each iteration records a sampled span with stats recorded inside it, while
+// spans are exported in the background. Every 256th iteration on each thread
+// also scrapes all registered views, as a pull exporter would.
+void BM_MixedRecordExportScrape(benchmark::State& state) {
+  static trace::AlwaysSampler sampler;
+  const StatsSetup& setup = StatsSetup::Get();
+  NullSpanExporter::Register();
+  int iteration = 0;
+  ContentionReporter reporter(&state);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    reporter.Start();
+    auto span = trace::Span::StartSpan("SpanName", /*parent=*/nullptr,
+                                       {&sampler});
+    RecordOnce(setup, iteration, state.thread_index());
+    span.End();
+    if (++iteration % 256 == 0) {
+      benchmark::DoNotOptimize(stats::StatsExporter::GetViewData());
+    }
+    reporter.Stop();
+  }
+}
+BENCHMARK(BM_MixedRecordExportScrape)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace opencensus
+BENCHMARK_MAIN();
@@ -0,0 +1,174 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/allocation_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "benchmark/benchmark.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+// Per-thread counts are plain integers: they are only ever accessed by their
+// owning thread. thread_local PODs need no dynamic initialization, so they are
+// safe to use from operator new during static initialization.
+thread_local uint64_t thread_allocations = 0;
+thread_local uint64_t thread_deallocations = 0;
+thread_local uint64_t thread_bytes_allocated = 0;
+
+std::atomic<uint64_t> global_allocations(0);
+std::atomic<uint64_t> global_deallocations(0);
+std::atomic<uint64_t> global_bytes_allocated(0);
+std::atomic<int64_t> global_live_bytes(0);
+std::atomic<int64_t> global_peak_live_bytes(0);
+
+// Each allocation is prefixed with its size, so that deallocation can update
+// global_live_bytes. The header is sized to preserve malloc's alignment.
+constexpr std::size_t kHeaderSize = alignof(std::max_align_t);
+
+void UpdatePeak(int64_t live_bytes) {
+  int64_t peak = global_peak_live_bytes.load(std::memory_order_relaxed);
+  while (live_bytes > peak &&
+         !global_peak_live_bytes.compare_exchange_weak(
+             peak, live_bytes, std::memory_order_relaxed)) {
+  }
+}
+
+void* CountedAllocate(std::size_t size) {
+  ++thread_allocations;
+  thread_bytes_allocated += size;
+  global_allocations.fetch_add(1, std::memory_order_relaxed);
+  global_bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+  while (true) {
+    void* ptr = std::malloc(size + kHeaderSize);
+    if (ptr != nullptr) {
+      *static_cast<std::size_t*>(ptr) = size;
+      UpdatePeak(global_live_bytes.fetch_add(size, std::memory_order_relaxed) +
+                 size);
+      return static_cast<char*>(ptr) + kHeaderSize;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) return nullptr;
+    handler();
+  }
+}
+
+void CountedFree(void* ptr) {
+  if (ptr == nullptr) return;
+  ++thread_deallocations;
+  global_deallocations.fetch_add(1, std::memory_order_relaxed);
+  void* block = static_cast<char*>(ptr) - kHeaderSize;
+  global_live_bytes.fetch_sub(*static_cast<std::size_t*>(block),
+                              std::memory_order_relaxed);
+  std::free(block);
+}
+
+}  // namespace
+
+AllocationCounter::AllocationCounter(benchmark::State* state)
+    : state_(state), start_(ThreadCounts()) {}
+
+AllocationCounter::~AllocationCounter() {
+  const Counts end = ThreadCounts();
+  state_->counters["allocs"] =
+      benchmark::Counter(end.allocations - start_.allocations,
+                         benchmark::Counter::kAvgIterations);
+  state_->counters["bytes"] =
+      benchmark::Counter(end.bytes_allocated - start_.bytes_allocated,
+                         benchmark::Counter::kAvgIterations);
+}
+
+// static
+AllocationCounter::Counts AllocationCounter::ThreadCounts() {
+  return Counts{thread_allocations, thread_deallocations,
+                thread_bytes_allocated};
+}
+
+// static
+AllocationCounter::Counts AllocationCounter::GlobalCounts() {
+  return Counts{global_allocations.load(std::memory_order_relaxed),
+                global_deallocations.load(std::memory_order_relaxed),
+                global_bytes_allocated.load(std::memory_order_relaxed)};
+}
+
+// static
+int64_t AllocationCounter::LiveBytes() {
+  return global_live_bytes.load(std::memory_order_relaxed);
+}
+
+// static
+int64_t AllocationCounter::PeakLiveBytes() {
+  return global_peak_live_bytes.load(std::memory_order_relaxed);
+}
+
+// static
+void AllocationCounter::ResetPeakLiveBytes() {
+  global_peak_live_bytes.store(LiveBytes(), std::memory_order_relaxed);
+}
+
+}  // namespace common
+}  // namespace opencensus
+
+// Replacements for the global allocation functions. Over-aligned allocations
+// are not counted.
+
+void* operator new(std::size_t size) {
+  void* ptr = ::opencensus::common::CountedAllocate(size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  void* ptr = ::opencensus::common::CountedAllocate(size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return ::opencensus::common::CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return ::opencensus::common::CountedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  ::opencensus::common::CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  ::opencensus::common::CountedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  ::opencensus::common::CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  ::opencensus::common::CountedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  ::opencensus::common::CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  ::opencensus::common::CountedFree(ptr);
+}
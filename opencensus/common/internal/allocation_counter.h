@@ -0,0 +1,82 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
+#define OPENCENSUS_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+
+namespace opencensus {
+namespace common {
+
+// AllocationCounter counts heap allocations made through the global operator
+// new. Linking the allocation_counter library replaces the global allocation
+// and deallocation functions, so it must only be linked into benchmarks and
+// tests.
+//
+// Constructing an AllocationCounter with a benchmark::State starts counting
+// allocations made by the current thread; on destruction the counts are
+// reported as the per-iteration counters "allocs" and "bytes". Construct it
+// after any setup and immediately before the benchmark loop, e.g.:
+//
+//   void BM_Foo(benchmark::State& state) {
+//     Foo foo;
+//     ::opencensus::common::AllocationCounter allocations(&state);
+//     for (auto _ : state) {
+//       foo.Bar();
+//     }
+//   }
+//
+// Allocations made by other threads (e.g. exporter workers) are not attributed
+// to the benchmark, so that multi-threaded benchmarks report per-iteration
+// allocations correctly.
+class AllocationCounter final {
+ public:
+  struct Counts {
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t bytes_allocated;
+  };
+
+  explicit AllocationCounter(benchmark::State* state);
+  ~AllocationCounter();
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  // Returns the counts accumulated by the calling thread since it started.
+  static Counts ThreadCounts();
+
+  // Returns the counts accumulated by all threads since the process started.
+  static Counts GlobalCounts();
+
+  // Returns the number of bytes currently allocated by all threads.
+  static int64_t LiveBytes();
+
+  // Returns the highest value of LiveBytes() since the process started or the
+  // last call to ResetPeakLiveBytes().
+  static int64_t PeakLiveBytes();
+  static void ResetPeakLiveBytes();
+
+ private:
+  benchmark::State* const state_;
+  const Counts start_;
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_ALLOCATION_COUNTER_H_
@@ -0,0 +1,77 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/allocation_counter.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+
+#include "benchmark/benchmark.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+TEST(AllocationCounterTest, CountsThreadAllocations) {
+  const AllocationCounter::Counts start = AllocationCounter::ThreadCounts();
+  {
+    auto ptr = std::unique_ptr<char[]>(new char[100]);
+    benchmark::DoNotOptimize(ptr.get());
+  }
+  const AllocationCounter::Counts end = AllocationCounter::ThreadCounts();
+  EXPECT_EQ(1, end.allocations - start.allocations);
+  EXPECT_EQ(1, end.deallocations - start.deallocations);
+  EXPECT_EQ(100, end.bytes_allocated - start.bytes_allocated);
+}
+
+TEST(AllocationCounterTest, OtherThreadsOnlyCountGlobally) {
+  const AllocationCounter::Counts thread_start =
+      AllocationCounter::ThreadCounts();
+  const AllocationCounter::Counts global_start =
+      AllocationCounter::GlobalCounts();
+  std::thread t([]() {
+    auto ptr = std::unique_ptr<char[]>(new char[100]);
+    benchmark::DoNotOptimize(ptr.get());
+  });
+  t.join();
+  const AllocationCounter::Counts thread_end =
+      AllocationCounter::ThreadCounts();
+  const AllocationCounter::Counts global_end =
+      AllocationCounter::GlobalCounts();
+  EXPECT_GE(global_end.allocations - global_start.allocations, 1);
+  EXPECT_GE(global_end.bytes_allocated - global_start.bytes_allocated, 100);
+  // Starting the thread may itself allocate on this thread, but the
+  // allocation inside the thread is not counted here.
+  EXPECT_LT(thread_end.bytes_allocated - thread_start.bytes_allocated,
+            global_end.bytes_allocated - global_start.bytes_allocated);
+}
+
+TEST(AllocationCounterTest, TracksPeakLiveBytes) {
+  AllocationCounter::ResetPeakLiveBytes();
+  const int64_t start = AllocationCounter::LiveBytes();
+  {
+    auto ptr = std::unique_ptr<char[]>(new char[1000]);
+    benchmark::DoNotOptimize(ptr.get());
+    EXPECT_EQ(1000, AllocationCounter::LiveBytes() - start);
+  }
+  EXPECT_EQ(start, AllocationCounter::LiveBytes());
+  EXPECT_EQ(1000, AllocationCounter::PeakLiveBytes() - start);
+  AllocationCounter::ResetPeakLiveBytes();
+  EXPECT_EQ(start, AllocationCounter::PeakLiveBytes());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
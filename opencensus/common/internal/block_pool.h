@@ -0,0 +1,189 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_BLOCK_POOL_H_
+#define OPENCENSUS_COMMON_INTERNAL_BLOCK_POOL_H_
+
+#include <cstddef>
+#include <new>
+
+#include "absl/base/attributes.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace opencensus {
+namespace common {
+
+// BlockPool recycles memory blocks of kBlockSize bytes, for objects that are
+// allocated and freed at a high rate, possibly on different threads. Each
+// thread keeps a small cache of free blocks, so most allocations and frees
+// take no lock. Caches exchange blocks with a shared free list in batches.
+//
+// Blocks have the alignment of ::operator new. BlockPool is thread-safe.
+template <size_t kBlockSize>
+class BlockPool final {
+ public:
+  BlockPool() = delete;
+
+  // Returns a block of kBlockSize bytes.
+  static void* Allocate() {
+    ThreadCache& cache = GetThreadCache();
+    if (cache.head == nullptr) {
+      if (cache.exited) return ::operator new(kBlockSize);
+      if (!cache.flusher_registered) RegisterFlusher(&cache);
+      Global().Take(&cache);
+      if (cache.head == nullptr) return ::operator new(kBlockSize);
+    }
+    FreeBlock* block = cache.head;
+    cache.head = block->next;
+    --cache.size;
+    return block;
+  }
+
+  // Returns a block obtained from Allocate() to the pool.
+  static void Free(void* ptr) {
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    ThreadCache& cache = GetThreadCache();
+    if (cache.exited) {
+      // The thread's cache has already been flushed.
+      Global().Put(block, block, 1);
+      return;
+    }
+    if (cache.head == nullptr && !cache.flusher_registered) {
+      RegisterFlusher(&cache);
+    }
+    block->next = cache.head;
+    cache.head = block;
+    if (++cache.size > kMaxThreadCacheSize) {
+      // Move a batch to the shared list, so that blocks freed on one thread
+      // (e.g. an exporter) can be reused by the threads that allocate.
+      FreeBlock* last = cache.head;
+      for (size_t i = 1; i < kBatchSize; ++i) last = last->next;
+      FreeBlock* first = cache.head;
+      cache.head = last->next;
+      cache.size -= kBatchSize;
+      Global().Put(first, last, kBatchSize);
+    }
+  }
+
+ private:
+  // The number of blocks moved between a thread cache and the shared list at
+  // a time.
+  static constexpr size_t kBatchSize = 32;
+  static constexpr size_t kMaxThreadCacheSize = 2 * kBatchSize;
+  // Blocks beyond this many on the shared list are returned to the heap.
+  static constexpr size_t kMaxGlobalSize = 64 * kBatchSize;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  static_assert(kBlockSize >= sizeof(FreeBlock), "Block is too small.");
+
+  struct ThreadCache {
+    FreeBlock* head;
+    size_t size;
+    // Set once the cache first holds blocks, which must then be flushed when
+    // the thread exits.
+    bool flusher_registered;
+    bool exited;
+  };
+
+  class GlobalList {
+   public:
+    // Moves up to kBatchSize blocks into the (empty) cache.
+    void Take(ThreadCache* cache) LOCKS_EXCLUDED(mu_) {
+      absl::MutexLock l(&mu_);
+      FreeBlock* block = head_;
+      size_t taken = 0;
+      FreeBlock* last = nullptr;
+      while (block != nullptr && taken < kBatchSize) {
+        last = block;
+        block = block->next;
+        ++taken;
+      }
+      if (taken == 0) return;
+      last->next = nullptr;
+      cache->head = head_;
+      cache->size = taken;
+      head_ = block;
+      size_ -= taken;
+    }
+
+    // Adds the chain of 'count' blocks from first to last.
+    void Put(FreeBlock* first, FreeBlock* last, size_t count)
+        LOCKS_EXCLUDED(mu_) {
+      {
+        absl::MutexLock l(&mu_);
+        if (size_ + count <= kMaxGlobalSize) {
+          last->next = head_;
+          head_ = first;
+          size_ += count;
+          return;
+        }
+      }
+      last->next = nullptr;
+      while (first != nullptr) {
+        FreeBlock* next = first->next;
+        ::operator delete(first);
+        first = next;
+      }
+    }
+
+   private:
+    absl::Mutex mu_;
+    FreeBlock* head_ GUARDED_BY(mu_) = nullptr;
+    size_t size_ GUARDED_BY(mu_) = 0;
+  };
+
+  // Flushes the thread cache to the shared list when the thread exits.
+  struct ThreadCacheFlusher {
+    ~ThreadCacheFlusher() {
+      ThreadCache& cache = GetThreadCache();
+      cache.exited = true;
+      if (cache.head == nullptr) return;
+      FreeBlock* last = cache.head;
+      while (last->next != nullptr) last = last->next;
+      Global().Put(cache.head, last, cache.size);
+      cache.head = nullptr;
+      cache.size = 0;
+    }
+  };
+
+  static GlobalList& Global() {
+    static GlobalList* global = new GlobalList;
+    return *global;
+  }
+
+  static ThreadCache& GetThreadCache() {
+    // A trivially destructible thread_local remains usable while other
+    // thread_locals are destroyed, unlike the flusher, and needs no
+    // initialization check on each access.
+    static thread_local ThreadCache cache = {nullptr, 0, false, false};
+    return cache;
+  }
+
+  // Constructs the thread's flusher. Called only when the cache goes from
+  // empty to holding blocks, so Allocate() and Free() do not pay for the
+  // flusher's initialization check.
+  ABSL_ATTRIBUTE_NOINLINE static void RegisterFlusher(ThreadCache* cache) {
+    cache->flusher_registered = true;
+    static thread_local ThreadCacheFlusher flusher;
+    (void)flusher;
+  }
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_BLOCK_POOL_H_
@@ -0,0 +1,66 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/block_pool.h"
+
+#include <cstring>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+TEST(BlockPoolTest, ReusesFreedBlocks) {
+  using Pool = BlockPool<48>;
+  void* block = Pool::Allocate();
+  memset(block, 0xff, 48);
+  Pool::Free(block);
+  EXPECT_EQ(block, Pool::Allocate());
+  Pool::Free(block);
+}
+
+TEST(BlockPoolTest, BlocksAreDistinct) {
+  using Pool = BlockPool<64>;
+  std::vector<void*> blocks;
+  std::set<void*> unique;
+  for (int i = 0; i < 1000; ++i) {
+    blocks.push_back(Pool::Allocate());
+    unique.insert(blocks.back());
+  }
+  EXPECT_EQ(blocks.size(), unique.size());
+  for (void* block : blocks) Pool::Free(block);
+}
+
+TEST(BlockPoolTest, BlocksFreedOnOtherThreadsAreReused) {
+  using Pool = BlockPool<80>;
+  std::vector<void*> blocks;
+  for (int i = 0; i < 1000; ++i) blocks.push_back(Pool::Allocate());
+  // Free everything on another thread, whose cache is flushed to the shared
+  // list when it exits.
+  std::thread([&blocks] {
+    for (void* block : blocks) Pool::Free(block);
+  }).join();
+  const std::set<void*> freed(blocks.begin(), blocks.end());
+  void* block = Pool::Allocate();
+  EXPECT_EQ(1, freed.count(block));
+  Pool::Free(block);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
@@ -0,0 +1,165 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_EXPORT_WORKER_H_
+#define OPENCENSUS_COMMON_INTERNAL_EXPORT_WORKER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace common {
+
+// ExportWorker calls an export function on its own thread for each queued
+// item, in order, so that a slow exporter delays only its own exports. Items
+// are shared, so several workers can export the same one.
+//
+// When max_queued items are already waiting, either the oldest queued item or
+// the new one is dropped. Items that have waited longer than 'deadline' since
+// their timestamp when the worker gets to them are dropped too.
+//
+// ExportWorker is thread-safe.
+template <typename T>
+class ExportWorker final {
+ public:
+  struct Options {
+    // The maximum number of items waiting while an export is in progress. At
+    // least 1.
+    int max_queued = 1;
+    // Whether a full queue drops its oldest item (true) or the new one.
+    bool drop_oldest = true;
+    absl::Duration deadline = absl::InfiniteDuration();
+  };
+
+  // Called on the worker thread to export an item.
+  using ExportFunction = std::function<void(const T&)>;
+  // Called whenever an item is dropped, without the worker's lock held.
+  using DropFunction = std::function<void()>;
+
+  ExportWorker(ExportFunction export_function, DropFunction drop_function,
+               const Options& options)
+      : export_function_(std::move(export_function)),
+        drop_function_(std::move(drop_function)),
+        options_(options),
+        thread_(&ExportWorker::RunWorkerLoop, this) {}
+
+  // Stops the worker after any in-progress export completes. Queued items are
+  // discarded without being counted as dropped.
+  ~ExportWorker() {
+    {
+      absl::MutexLock l(&mu_);
+      shutdown_ = true;
+    }
+    thread_.join();
+  }
+
+  ExportWorker(const ExportWorker&) = delete;
+  ExportWorker& operator=(const ExportWorker&) = delete;
+
+  // Queues 'item', which was produced at 'time', dropping an item if the queue
+  // is full.
+  void Enqueue(std::shared_ptr<const T> item, absl::Time time)
+      LOCKS_EXCLUDED(mu_) {
+    {
+      absl::MutexLock l(&mu_);
+      if (static_cast<int>(queue_.size()) < std::max(options_.max_queued, 1)) {
+        queue_.push_back({std::move(item), time});
+        return;
+      }
+      ++dropped_count_;
+      if (options_.drop_oldest) {
+        queue_.pop_front();
+        queue_.push_back({std::move(item), time});
+      }
+    }
+    if (drop_function_) drop_function_();
+  }
+
+  // Blocks until the queue is empty and no export is in progress.
+  void WaitUntilIdle() LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(this, &ExportWorker::IsIdle));
+  }
+
+  // Returns the number of items dropped so far.
+  uint64_t dropped_count() const LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    return dropped_count_;
+  }
+
+ private:
+  struct Entry {
+    std::shared_ptr<const T> item;
+    absl::Time time;
+  };
+
+  bool HasWork() const SHARED_LOCKS_REQUIRED(mu_) {
+    return shutdown_ || !queue_.empty();
+  }
+  bool IsIdle() const SHARED_LOCKS_REQUIRED(mu_) {
+    return queue_.empty() && !exporting_;
+  }
+
+  void RunWorkerLoop() LOCKS_EXCLUDED(mu_) {
+    while (true) {
+      Entry entry;
+      bool expired;
+      {
+        absl::MutexLock l(&mu_);
+        exporting_ = false;
+        mu_.Await(absl::Condition(this, &ExportWorker::HasWork));
+        if (shutdown_) return;
+        entry = std::move(queue_.front());
+        queue_.pop_front();
+        expired = absl::Now() - entry.time > options_.deadline;
+        if (expired) ++dropped_count_;
+        exporting_ = true;
+      }
+      if (expired) {
+        if (drop_function_) drop_function_();
+        continue;
+      }
+      export_function_(*entry.item);
+    }
+  }
+
+  const ExportFunction export_function_;
+  const DropFunction drop_function_;
+  const Options options_;
+
+  mutable absl::Mutex mu_;
+  std::deque<Entry> queue_ GUARDED_BY(mu_);
+  bool exporting_ GUARDED_BY(mu_) = false;
+  bool shutdown_ GUARDED_BY(mu_) = false;
+  uint64_t dropped_count_ GUARDED_BY(mu_) = 0;
+
+  // Declared last so that the thread starts after all other members are
+  // initialized.
+  std::thread thread_;
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_EXPORT_WORKER_H_
@@ -0,0 +1,151 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/export_worker.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+// Records exported items. Exports block while the exporter is paused.
+class Exporter {
+ public:
+  void Export(int item) {
+    absl::MutexLock l(&mu_);
+    ++started_;
+    mu_.Await(absl::Condition(
+        +[](bool* paused) { return !*paused; }, &paused_));
+    items_.push_back(item);
+  }
+
+  void Pause() {
+    absl::MutexLock l(&mu_);
+    paused_ = true;
+  }
+
+  void Resume() {
+    absl::MutexLock l(&mu_);
+    paused_ = false;
+  }
+
+  // Blocks until 'count' exports have started.
+  void WaitForStarted(int count) {
+    absl::MutexLock l(&mu_);
+    wanted_ = count;
+    mu_.Await(absl::Condition(this, &Exporter::HasStarted));
+  }
+
+  std::vector<int> items() {
+    absl::MutexLock l(&mu_);
+    return items_;
+  }
+
+ private:
+  bool HasStarted() const SHARED_LOCKS_REQUIRED(mu_) {
+    return started_ >= wanted_;
+  }
+
+  absl::Mutex mu_;
+  bool paused_ GUARDED_BY(mu_) = false;
+  int started_ GUARDED_BY(mu_) = 0;
+  int wanted_ GUARDED_BY(mu_) = 0;
+  std::vector<int> items_ GUARDED_BY(mu_);
+};
+
+class ExportWorkerTest : public ::testing::Test {
+ protected:
+  void Start(const ExportWorker<int>::Options& options) {
+    worker_ = absl::make_unique<ExportWorker<int>>(
+        [this](const int& item) { exporter_.Export(item); },
+        [this] { ++dropped_; }, options);
+  }
+
+  void Enqueue(int item, absl::Time time = absl::Now()) {
+    worker_->Enqueue(std::make_shared<const int>(item), time);
+  }
+
+  Exporter exporter_;
+  std::atomic<int> dropped_{0};
+  std::unique_ptr<ExportWorker<int>> worker_;
+};
+
+TEST_F(ExportWorkerTest, ExportsInOrder) {
+  ExportWorker<int>::Options options;
+  options.max_queued = 10;
+  Start(options);
+  for (int i = 0; i < 5; ++i) Enqueue(i);
+  worker_->WaitUntilIdle();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), exporter_.items());
+  EXPECT_EQ(0, worker_->dropped_count());
+  EXPECT_EQ(0, dropped_);
+}
+
+TEST_F(ExportWorkerTest, DropsOldest) {
+  ExportWorker<int>::Options options;
+  options.max_queued = 2;
+  options.drop_oldest = true;
+  Start(options);
+  exporter_.Pause();
+  Enqueue(0);
+  exporter_.WaitForStarted(1);
+  for (int i = 1; i < 5; ++i) Enqueue(i);
+  exporter_.Resume();
+  worker_->WaitUntilIdle();
+  EXPECT_EQ(std::vector<int>({0, 3, 4}), exporter_.items());
+  EXPECT_EQ(2, worker_->dropped_count());
+  EXPECT_EQ(2, dropped_);
+}
+
+TEST_F(ExportWorkerTest, DropsNewest) {
+  ExportWorker<int>::Options options;
+  options.max_queued = 2;
+  options.drop_oldest = false;
+  Start(options);
+  exporter_.Pause();
+  Enqueue(0);
+  exporter_.WaitForStarted(1);
+  for (int i = 1; i < 5; ++i) Enqueue(i);
+  exporter_.Resume();
+  worker_->WaitUntilIdle();
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), exporter_.items());
+  EXPECT_EQ(2, worker_->dropped_count());
+  EXPECT_EQ(2, dropped_);
+}
+
+TEST_F(ExportWorkerTest, DropsItemsPastDeadline) {
+  ExportWorker<int>::Options options;
+  options.max_queued = 10;
+  options.deadline = absl::Seconds(10);
+  Start(options);
+  Enqueue(0, absl::Now() - absl::Minutes(1));
+  Enqueue(1);
+  worker_->WaitUntilIdle();
+  EXPECT_EQ(std::vector<int>({1}), exporter_.items());
+  EXPECT_EQ(1, worker_->dropped_count());
+  EXPECT_EQ(1, dropped_);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
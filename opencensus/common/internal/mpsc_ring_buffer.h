@@ -0,0 +1,139 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_MPSC_RING_BUFFER_H_
+#define OPENCENSUS_COMMON_INTERNAL_MPSC_RING_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/base/optimization.h"
+
+namespace opencensus {
+namespace common {
+
+// MpscRingBuffer is a fixed-capacity, lock-free FIFO queue. Any number of
+// threads may push concurrently. Pops are also safe from any thread, so that
+// producers can make room by discarding the oldest element, but the queue is
+// intended to be drained by a single consumer.
+//
+// Each slot carries a sequence number that tells pushers and poppers whether
+// the slot is free for the current lap of the ring (see Vyukov's bounded MPMC
+// queue), so neither operation ever blocks or allocates.
+template <typename T>
+class MpscRingBuffer final {
+ public:
+  // The capacity is rounded up to a power of two, and is at least 2.
+  explicit MpscRingBuffer(size_t capacity)
+      : mask_(CapacityFor(capacity) - 1),
+        slots_(new Slot[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscRingBuffer(const MpscRingBuffer&) = delete;
+  MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+  // Appends value and returns true, or returns false if the buffer is full. On
+  // failure value is left unchanged.
+  bool TryPush(T&& value) {
+    size_t pos = push_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots_[pos & mask_];
+      const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (push_pos_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = push_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    slot->value = std::move(value);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the oldest element into *value and returns true, or returns false if
+  // the buffer is empty.
+  bool TryPop(T* value) {
+    size_t pos = pop_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots_[pos & mask_];
+      const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (pop_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = pop_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    *value = std::move(slot->value);
+    slot->value = T();
+    slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the number of elements in the buffer. This is approximate while
+  // other threads are pushing or popping.
+  size_t size() const {
+    const size_t pop_pos = pop_pos_.load(std::memory_order_relaxed);
+    const size_t push_pos = push_pos_.load(std::memory_order_relaxed);
+    return push_pos > pop_pos ? push_pos - pop_pos : 0;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Returns the capacity of a buffer constructed with the given capacity.
+  static size_t CapacityFor(size_t capacity) {
+    size_t result = 2;
+    while (result < capacity) result <<= 1;
+    return result;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  const size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  // Pushers and poppers update different positions; keep them on separate
+  // cache lines.
+  ABSL_CACHELINE_ALIGNED std::atomic<size_t> push_pos_{0};
+  ABSL_CACHELINE_ALIGNED std::atomic<size_t> pop_pos_{0};
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_MPSC_RING_BUFFER_H_
@@ -0,0 +1,106 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/mpsc_ring_buffer.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+TEST(MpscRingBufferTest, CapacityIsRoundedUpToPowerOfTwo) {
+  EXPECT_EQ(2, MpscRingBuffer<int>(0).capacity());
+  EXPECT_EQ(8, MpscRingBuffer<int>(5).capacity());
+  EXPECT_EQ(64, MpscRingBuffer<int>(64).capacity());
+}
+
+TEST(MpscRingBufferTest, PushAndPopInOrder) {
+  MpscRingBuffer<int> buffer(4);
+  int value;
+  EXPECT_FALSE(buffer.TryPop(&value));
+  // Go around the ring a few times.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(buffer.TryPush(lap * 4 + i));
+    }
+    EXPECT_EQ(4, buffer.size());
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(buffer.TryPop(&value));
+      EXPECT_EQ(lap * 4 + i, value);
+    }
+    EXPECT_EQ(0, buffer.size());
+  }
+}
+
+TEST(MpscRingBufferTest, FailedPushLeavesValue) {
+  MpscRingBuffer<std::unique_ptr<int>> buffer(2);
+  EXPECT_TRUE(buffer.TryPush(std::unique_ptr<int>(new int(1))));
+  EXPECT_TRUE(buffer.TryPush(std::unique_ptr<int>(new int(2))));
+  std::unique_ptr<int> value(new int(3));
+  EXPECT_FALSE(buffer.TryPush(std::move(value)));
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(3, *value);
+}
+
+TEST(MpscRingBufferTest, PopReleasesSlot) {
+  MpscRingBuffer<std::shared_ptr<int>> buffer(2);
+  auto element = std::make_shared<int>(1);
+  EXPECT_TRUE(buffer.TryPush(std::shared_ptr<int>(element)));
+  EXPECT_EQ(2, element.use_count());
+  std::shared_ptr<int> popped;
+  EXPECT_TRUE(buffer.TryPop(&popped));
+  popped.reset();
+  EXPECT_EQ(1, element.use_count());
+}
+
+TEST(MpscRingBufferTest, ConcurrentProducers) {
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 10000;
+  MpscRingBuffer<int> buffer(64);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&buffer, t] {
+      for (int i = 0; i < kPerThread; ++i) {
+        while (!buffer.TryPush(t * kPerThread + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  // Each producer's elements must be popped in the order they were pushed.
+  std::vector<int> next(kThreads, 0);
+  int popped = 0;
+  while (popped < kThreads * kPerThread) {
+    int value;
+    if (!buffer.TryPop(&value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    const int thread = value / kPerThread;
+    EXPECT_EQ(next[thread], value % kPerThread);
+    next[thread] = value % kPerThread + 1;
+    ++popped;
+  }
+  for (auto& producer : producers) producer.join();
+  EXPECT_EQ(0, buffer.size());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
@@ -14,16 +14,92 @@
 
 #include "opencensus/common/internal/random.h"
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
+#include <random>
 
-#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#define OPENCENSUS_HAVE_FORK 1
+#endif
 
 namespace opencensus {
 namespace common {
+namespace {
+
+// splitmix64, used to expand seeds into generator state.
+uint64_t SplitMix64(uint64_t* state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+// Each new thread generator is seeded with the next value of seed_sequence.
+std::atomic<uint64_t> seed_sequence(0);
+// Incremented in the child after each fork(). Thread generators seeded in an
+// earlier generation are reseeded on their next use.
+std::atomic<uint64_t> fork_generation(1);
+
+#ifdef OPENCENSUS_HAVE_FORK
+void OnForkInChild() {
+  // The child inherits seed_sequence, so also mix in values that differ from
+  // the parent.
+  seed_sequence.fetch_xor(
+      (static_cast<uint64_t>(getpid()) << 32) ^ absl::GetCurrentTimeNanos(),
+      std::memory_order_relaxed);
+  fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+void InitializeEntropy() {
+  static const bool initialized = [] {
+    std::random_device device;
+    const uint64_t entropy =
+        (static_cast<uint64_t>(device()) << 32) ^ device() ^
+        static_cast<uint64_t>(absl::GetCurrentTimeNanos());
+    seed_sequence.fetch_xor(entropy, std::memory_order_relaxed);
+#ifdef OPENCENSUS_HAVE_FORK
+    pthread_atfork(nullptr, nullptr, &OnForkInChild);
+#endif
+    return true;
+  }();
+  (void)initialized;
+}
+
+struct ThreadGeneratorState {
+  // The fork_generation the generator was seeded in, or 0 if unseeded.
+  uint64_t generation;
+  Generator generator;
+};
 
-uint64_t Generator::Random64() {
-  absl::MutexLock l(&mu_);
-  return rng_();
+}  // namespace
+
+void Generator::Seed(uint64_t seed) {
+  uint64_t state = seed;
+  for (auto& word : s_) {
+    word = SplitMix64(&state);
+  }
+}
+
+// static
+Generator* Random::ThreadGenerator() {
+  // Constant-initialized, so access is cheap and safe during thread exit.
+  static thread_local ThreadGeneratorState state = {0, Generator()};
+  const uint64_t generation = fork_generation.load(std::memory_order_relaxed);
+  if (state.generation != generation) {
+    InitializeEntropy();
+    // Space the seeds so that no two threads share a splitmix64 stream.
+    state.generator.Seed(
+        seed_sequence.fetch_add(0x9e3779b97f4a7c15 * 8,
+                                std::memory_order_relaxed));
+    state.generation = generation;
+  }
+  return &state.generator;
 }
 
 Random* Random::GetRandom() {
@@ -31,22 +107,24 @@ Random* Random::GetRandom() {
   return global_random;
 }
 
-uint32_t Random::GenerateRandom32() { return gen_.Random64(); }
+uint32_t Random::GenerateRandom32() { return ThreadGenerator()->Random64(); }
 
-uint64_t Random::GenerateRandom64() { return gen_.Random64(); }
+uint64_t Random::GenerateRandom64() { return ThreadGenerator()->Random64(); }
 
 float Random::GenerateRandomFloat() {
-  return static_cast<float>(gen_.Random64()) / static_cast<float>(UINT64_MAX);
+  return static_cast<float>(ThreadGenerator()->Random64()) /
+         static_cast<float>(UINT64_MAX);
 }
 
 double Random::GenerateRandomDouble() {
-  return static_cast<double>(gen_.Random64()) / static_cast<double>(UINT64_MAX);
+  return static_cast<double>(ThreadGenerator()->Random64()) /
+         static_cast<double>(UINT64_MAX);
 }
 
 void Random::GenerateRandomBuffer(uint8_t* buf, size_t buf_size) {
-  absl::MutexLock l(&gen_.mu_);
+  Generator* generator = ThreadGenerator();
   for (size_t i = 0; i < buf_size; i += sizeof(uint64_t)) {
-    uint64_t value = gen_.rng_();
+    uint64_t value = generator->Random64();
     if (i + sizeof(uint64_t) <= buf_size) {
       memcpy(&buf[i], &value, sizeof(uint64_t));
     } else {
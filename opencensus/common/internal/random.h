@@ -15,32 +15,49 @@
 #ifndef OPENCENSUS_COMMON_INTERNAL_RANDOM_H_
 #define OPENCENSUS_COMMON_INTERNAL_RANDOM_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <cstring>
-#include <memory>
-#include <random>
-#include <vector>
-
-#include "absl/synchronization/mutex.h"
-#include "absl/time/clock.h"
 
 namespace opencensus {
 namespace common {
 
+// Generator is a xoshiro256** pseudo-random number generator: fast, with good
+// statistical properties, but not cryptographically secure. Generator is
+// thread-compatible.
 class Generator {
  public:
-  Generator() : rng_(absl::GetCurrentTimeNanos()) {}
-  explicit Generator(uint64_t seed) : rng_(seed) {}
-
-  uint64_t Random64() LOCKS_EXCLUDED(mu_);
+  // The generator must be seeded before use.
+  constexpr Generator() : s_{0, 0, 0, 0} {}
+  explicit Generator(uint64_t seed) { Seed(seed); }
+
+  // Resets the state from seed. Distinct seeds give unrelated sequences.
+  void Seed(uint64_t seed);
+
+  uint64_t Random64() {
+    const uint64_t result = RotateLeft(s_[1] * 5, 7) * 9;
+    const uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = RotateLeft(s_[3], 45);
+    return result;
+  }
 
  private:
-  friend class Random;
+  static uint64_t RotateLeft(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
 
-  absl::Mutex mu_;
-  std::mt19937_64 rng_ GUARDED_BY(mu_);
+  uint64_t s_[4];
 };
 
+// Random generates random numbers using a separate Generator for each thread,
+// so that concurrent callers do not contend. Each thread's generator is seeded
+// from a process-wide entropy source on first use, and reseeded in a child
+// process after fork() so that parent and child do not produce the same
+// sequence. Random is thread-safe.
 class Random {
  public:
   // Initializes and returns a singleton Random generator.
@@ -68,8 +85,8 @@ class Random {
   Random& operator=(const Random&) = delete;
   Random& operator=(Random&&) = delete;
 
-  uint64_t GenerateValue();
-  Generator gen_;
+  // Returns the calling thread's generator, seeding it if needed.
+  static Generator* ThreadGenerator();
 };
 
 }  // namespace common
@@ -16,11 +16,13 @@
 #include <vector>
 
 #include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
 #include "opencensus/common/internal/random.h"
 
 namespace {
 
 void BM_GetRandom(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
   for (auto _ : state) {
     ::opencensus::common::Random::GetRandom();
   }
@@ -28,15 +30,29 @@ void BM_GetRandom(benchmark::State& state) {
 BENCHMARK(BM_GetRandom);
 
 void BM_Random64(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
   for (auto _ : state) {
     ::opencensus::common::Random::GetRandom()->GenerateRandom64();
   }
 }
 BENCHMARK(BM_Random64);
 
+// Each thread uses its own generator, so throughput should scale linearly with
+// the number of threads.
+void BM_Random64MultiThreaded(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ::opencensus::common::Random::GetRandom()->GenerateRandom64());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Random64MultiThreaded)->ThreadRange(1, 16)->UseRealTime();
+
 void BM_RandomBuffer(benchmark::State& state) {
   const size_t size = state.range(0);
   std::vector<uint8_t> buffer(size);
+  ::opencensus::common::AllocationCounter allocations(&state);
   for (auto _ : state) {
     ::opencensus::common::Random::GetRandom()->GenerateRandomBuffer(
         buffer.data(), size);
@@ -44,5 +60,17 @@ void BM_RandomBuffer(benchmark::State& state) {
 }
 BENCHMARK(BM_RandomBuffer)->Range(1, 16);
 
+void BM_RandomBufferMultiThreaded(benchmark::State& state) {
+  uint8_t buffer[16];
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    ::opencensus::common::Random::GetRandom()->GenerateRandomBuffer(
+        buffer, sizeof(buffer));
+    benchmark::DoNotOptimize(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RandomBufferMultiThreaded)->ThreadRange(1, 16)->UseRealTime();
+
 }  // namespace
 BENCHMARK_MAIN();
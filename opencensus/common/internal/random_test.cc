@@ -13,8 +13,19 @@
 // limitations under the License.
 
 #include "opencensus/common/internal/random.h"
+
+#include <cstdint>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "gtest/gtest.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 namespace opencensus {
 namespace common {
 
@@ -33,5 +44,53 @@ TEST(RandomTest, GenerateValues) {
   }
 }
 
+TEST(RandomTest, GeneratorIsDeterministic) {
+  Generator a(1234);
+  Generator b(1234);
+  Generator c(1235);
+  for (int i = 0; i < 100; ++i) {
+    const uint64_t value = a.Random64();
+    EXPECT_EQ(value, b.Random64());
+    EXPECT_NE(value, c.Random64());
+  }
+}
+
+TEST(RandomTest, ThreadsGenerateDistinctValues) {
+  constexpr int kThreads = 8;
+  std::vector<uint64_t> values(kThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&values, i] {
+      values[i] = Random::GetRandom()->GenerateRandom64();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(kThreads, std::set<uint64_t>(values.begin(), values.end()).size());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST(RandomTest, ReseedsAfterFork) {
+  Random* rand = Random::GetRandom();
+  rand->GenerateRandom64();  // Make sure this thread's generator is seeded.
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    const uint64_t value = rand->GenerateRandom64();
+    _exit(write(fds[1], &value, sizeof(value)) == sizeof(value) ? 0 : 1);
+  }
+  const uint64_t parent_value = rand->GenerateRandom64();
+  uint64_t child_value = 0;
+  ASSERT_EQ(sizeof(child_value),
+            read(fds[0], &child_value, sizeof(child_value)));
+  int status;
+  waitpid(pid, &status, 0);
+  close(fds[0]);
+  close(fds[1]);
+  EXPECT_NE(parent_value, child_value);
+}
+#endif
+
 }  // namespace common
 }  // namespace opencensus
@@ -0,0 +1,169 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/rcu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/config.h"
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+// A registered reader thread. Each is on its own cache line, so that readers
+// do not contend.
+struct ThreadRecord {
+  // The global epoch seen when the thread last left a read-side critical
+  // section.
+  std::atomic<uint64_t> epoch;
+  char padding[ABSL_CACHELINE_SIZE - sizeof(std::atomic<uint64_t>)];
+};
+
+// Per-thread state. It is trivially destructible, so that it remains usable
+// while other thread_locals are destroyed.
+struct ThreadState {
+  ThreadRecord* record;
+  // The read-side critical section nesting depth.
+  int depth;
+  bool exited;
+};
+
+thread_local ThreadState thread_state = {nullptr, 0, false};
+
+struct RetiredValue {
+  uint64_t epoch;
+  const void* ptr;
+  void (*deleter)(const void*);
+};
+
+// These are constant-initialized globals rather than Domain members, so that
+// readers don't check for the Domain's initialization.
+std::atomic<uint64_t> global_epoch(1);
+// Threads that have already exited (and unregistered) may still run
+// thread_local destructors that read; they are counted here, and nothing is
+// reclaimed while any are reading.
+std::atomic<int> exited_readers(0);
+
+class Domain {
+ public:
+  absl::Mutex mu;
+  std::vector<ThreadRecord*> records GUARDED_BY(mu);
+  std::vector<RetiredValue> retired GUARDED_BY(mu);
+};
+
+Domain& GetDomain() {
+  static Domain* domain = new Domain;
+  return *domain;
+}
+
+// Unregisters the thread's record when the thread exits.
+struct ThreadExitHandler {
+  ~ThreadExitHandler() {
+    ThreadState& state = thread_state;
+    state.exited = true;
+    if (state.record == nullptr) return;
+    Domain& domain = GetDomain();
+    absl::MutexLock l(&domain.mu);
+    domain.records.erase(std::find(domain.records.begin(),
+                                   domain.records.end(), state.record));
+    delete state.record;
+    state.record = nullptr;
+  }
+};
+
+void RegisterThread(ThreadState* state) {
+  static thread_local ThreadExitHandler exit_handler;
+  (void)exit_handler;
+  Domain& domain = GetDomain();
+  ThreadRecord* record = new ThreadRecord;
+  absl::MutexLock l(&domain.mu);
+  // Values retired up to the current epoch were replaced before the thread
+  // started reading, so it does not hold them up.
+  record->epoch.store(global_epoch.load(std::memory_order_acquire),
+                      std::memory_order_relaxed);
+  domain.records.push_back(record);
+  state->record = record;
+}
+
+}  // namespace
+
+RcuReadLock::RcuReadLock() {
+  ThreadState& state = thread_state;
+  if (state.depth++ > 0) return;
+  if (ABSL_PREDICT_FALSE(state.record == nullptr)) {
+    if (state.exited) {
+      exited_readers.fetch_add(1);
+      return;
+    }
+    RegisterThread(&state);
+  }
+}
+
+RcuReadLock::~RcuReadLock() {
+  ThreadState& state = thread_state;
+  if (--state.depth > 0) return;
+  if (ABSL_PREDICT_FALSE(state.record == nullptr)) {
+    exited_readers.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+  // Publishes that the thread no longer uses any value retired up to the
+  // current epoch.
+  state.record->epoch.store(global_epoch.load(std::memory_order_acquire),
+                            std::memory_order_release);
+}
+
+// static
+void Rcu::Retire(const void* ptr, void (*deleter)(const void*)) {
+  ThreadState& state = thread_state;
+  Domain& domain = GetDomain();
+  std::vector<RetiredValue> reclaimable;
+  {
+    absl::MutexLock l(&domain.mu);
+    // The pointer has already been replaced, so readers that see the new
+    // epoch see the new pointer.
+    const uint64_t epoch = global_epoch.fetch_add(1) + 1;
+    domain.retired.push_back({epoch, ptr, deleter});
+    if (state.record != nullptr && state.depth == 0) {
+      // This thread is not reading, so it has passed every epoch.
+      state.record->epoch.store(epoch, std::memory_order_relaxed);
+    }
+    if (exited_readers.load() > 0) return;
+    uint64_t min_epoch = epoch;
+    for (const ThreadRecord* record : domain.records) {
+      min_epoch = std::min(min_epoch,
+                           record->epoch.load(std::memory_order_acquire));
+    }
+    auto it = std::partition(
+        domain.retired.begin(), domain.retired.end(),
+        [min_epoch](const RetiredValue& value) {
+          return value.epoch > min_epoch;
+        });
+    reclaimable.assign(it, domain.retired.end());
+    domain.retired.erase(it, domain.retired.end());
+  }
+  // Deleters run outside the lock, since they may run arbitrary destructors.
+  for (const RetiredValue& value : reclaimable) {
+    value.deleter(value.ptr);
+  }
+}
+
+}  // namespace common
+}  // namespace opencensus
@@ -0,0 +1,93 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_RCU_H_
+#define OPENCENSUS_COMMON_INTERNAL_RCU_H_
+
+#include <atomic>
+#include <memory>
+
+namespace opencensus {
+namespace common {
+
+// RcuReadLock marks a read-side critical section, during which values read
+// from an RcuPtr remain valid. Taking and releasing it never blocks: it costs
+// a thread-local counter update and, when the outermost lock is released, one
+// store to a per-thread slot. Read-side critical sections may be nested, and
+// should be short, since they delay the reclamation of replaced values.
+class RcuReadLock final {
+ public:
+  RcuReadLock();
+  ~RcuReadLock();
+
+  RcuReadLock(const RcuReadLock&) = delete;
+  RcuReadLock& operator=(const RcuReadLock&) = delete;
+};
+
+// Rcu reclaims values replaced in an RcuPtr. It uses quiescent-state based
+// reclamation: each thread records the global epoch when it leaves a read-side
+// critical section, and a value retired in epoch E is deleted once every thread
+// has recorded an epoch of at least E. Reclamation happens on later updates, so
+// a thread that read a value and then stopped reading delays it until it reads
+// again or exits.
+class Rcu final {
+ public:
+  Rcu() = delete;
+
+ private:
+  template <typename T>
+  friend class RcuPtr;
+
+  // Schedules deleter(ptr) for when no read-side critical section that may
+  // have seen ptr is still running, and deletes any earlier values for which
+  // that is already the case.
+  static void Retire(const void* ptr, void (*deleter)(const void*));
+};
+
+// RcuPtr publishes an immutable value of type T. Readers load it with a single
+// acquire load under an RcuReadLock; writers replace it atomically, and the
+// previous value is deleted once no reader can be using it. RcuPtr is
+// thread-safe, but concurrent updates are not ordered with respect to each
+// other.
+template <typename T>
+class RcuPtr final {
+ public:
+  explicit RcuPtr(std::unique_ptr<const T> value) : ptr_(value.release()) {}
+
+  // There must be no concurrent readers.
+  ~RcuPtr() { delete ptr_.load(std::memory_order_relaxed); }
+
+  RcuPtr(const RcuPtr&) = delete;
+  RcuPtr& operator=(const RcuPtr&) = delete;
+
+  // Returns the current value. It remains valid until lock is released.
+  const T* Read(const RcuReadLock& /*lock*/) const {
+    return ptr_.load(std::memory_order_acquire);
+  }
+
+  // Publishes value, and retires the previous value.
+  void Update(std::unique_ptr<const T> value) {
+    const T* previous = ptr_.exchange(value.release());
+    Rcu::Retire(previous,
+                [](const void* ptr) { delete static_cast<const T*>(ptr); });
+  }
+
+ private:
+  std::atomic<const T*> ptr_;
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_RCU_H_
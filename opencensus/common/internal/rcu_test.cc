@@ -0,0 +1,126 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/rcu.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+// Counts its destruction.
+struct Value {
+  Value(int value, std::atomic<int>* destroyed)
+      : value(value), destroyed(destroyed) {}
+  ~Value() { destroyed->fetch_add(1); }
+
+  const int value;
+  std::atomic<int>* const destroyed;
+};
+
+TEST(RcuTest, ReadReturnsLatestValue) {
+  std::atomic<int> destroyed(0);
+  RcuPtr<Value> ptr(absl::make_unique<Value>(1, &destroyed));
+  {
+    RcuReadLock lock;
+    EXPECT_EQ(1, ptr.Read(lock)->value);
+  }
+  ptr.Update(absl::make_unique<Value>(2, &destroyed));
+  {
+    RcuReadLock lock;
+    EXPECT_EQ(2, ptr.Read(lock)->value);
+  }
+  // This thread was not reading, so the first value is deleted immediately.
+  EXPECT_EQ(1, destroyed);
+}
+
+TEST(RcuTest, ValueIsNotDeletedWhileRead) {
+  std::atomic<int> destroyed(0);
+  RcuPtr<Value> ptr(absl::make_unique<Value>(1, &destroyed));
+  absl::Notification read;
+  absl::Notification updated;
+  std::thread reader([&] {
+    RcuReadLock lock;
+    const Value* value = ptr.Read(lock);
+    read.Notify();
+    updated.WaitForNotification();
+    EXPECT_EQ(1, value->value);
+  });
+  read.WaitForNotification();
+  ptr.Update(absl::make_unique<Value>(2, &destroyed));
+  EXPECT_EQ(0, destroyed);
+  updated.Notify();
+  reader.join();
+  // The reader has exited, so the next update reclaims both values.
+  ptr.Update(absl::make_unique<Value>(3, &destroyed));
+  EXPECT_EQ(2, destroyed);
+}
+
+TEST(RcuTest, NestedReadLocks) {
+  std::atomic<int> destroyed(0);
+  RcuPtr<Value> ptr(absl::make_unique<Value>(1, &destroyed));
+  {
+    RcuReadLock outer;
+    const Value* value = ptr.Read(outer);
+    {
+      RcuReadLock inner;
+      EXPECT_EQ(value, ptr.Read(inner));
+    }
+    // The outer lock is still held.
+    ptr.Update(absl::make_unique<Value>(2, &destroyed));
+    EXPECT_EQ(0, destroyed);
+    EXPECT_EQ(1, value->value);
+  }
+  ptr.Update(absl::make_unique<Value>(3, &destroyed));
+  EXPECT_EQ(2, destroyed);
+}
+
+TEST(RcuTest, ConcurrentReadersAndWriters) {
+  std::atomic<int> destroyed(0);
+  RcuPtr<Value> ptr(absl::make_unique<Value>(0, &destroyed));
+  std::atomic<bool> running(true);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      int last = 0;
+      while (running) {
+        RcuReadLock lock;
+        const int value = ptr.Read(lock)->value;
+        // Values are published in increasing order.
+        EXPECT_LE(last, value);
+        last = value;
+      }
+    });
+  }
+  constexpr int kUpdates = 10000;
+  for (int i = 1; i <= kUpdates; ++i) {
+    ptr.Update(absl::make_unique<Value>(i, &destroyed));
+  }
+  running = false;
+  for (auto& thread : threads) thread.join();
+  ptr.Update(absl::make_unique<Value>(kUpdates + 1, &destroyed));
+  EXPECT_EQ(kUpdates + 1, destroyed);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
@@ -0,0 +1,97 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "opencensus/common/internal/string_interner.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace opencensus {
+namespace common {
+
+constexpr size_t StringInterner::kMaxStrings;
+constexpr size_t StringInterner::kMaxLength;
+constexpr size_t StringInterner::kNumSlots;
+
+// static
+StringInterner* StringInterner::Get(Table table) {
+  static StringInterner* global_string_interner = new StringInterner;
+  static StringInterner* attribute_key_interner = new StringInterner;
+  return table == Table::kAttributeKeys ? attribute_key_interner
+                                        : global_string_interner;
+}
+
+std::atomic<const std::string*>& StringInterner::FindSlot(
+    absl::string_view str, size_t hash) {
+  for (size_t i = hash % kNumSlots;; i = (i + 1) % kNumSlots) {
+    const std::string* entry = slots_[i].load(std::memory_order_acquire);
+    if (entry == nullptr || *entry == str) return slots_[i];
+  }
+}
+
+// static
+absl::string_view StringInterner::Intern(absl::string_view str,
+                                         Table table) {
+  if (str.size() > kMaxLength) return absl::string_view();
+  StringInterner* interner = Get(table);
+  const size_t hash = absl::Hash<absl::string_view>()(str);
+  const std::string* entry =
+      interner->FindSlot(str, hash).load(std::memory_order_acquire);
+  if (entry != nullptr) return *entry;
+  if (interner->full_.load(std::memory_order_relaxed)) {
+    return absl::string_view();
+  }
+
+  absl::MutexLock l(&interner->mu_);
+  // Look again: another thread may have added it.
+  std::atomic<const std::string*>& slot = interner->FindSlot(str, hash);
+  entry = slot.load(std::memory_order_relaxed);
+  if (entry != nullptr) return *entry;
+  if (interner->size_ >= kMaxStrings) return absl::string_view();
+  entry = new std::string(str);
+  slot.store(entry, std::memory_order_release);
+  if (++interner->size_ == kMaxStrings) {
+    interner->full_.store(true, std::memory_order_relaxed);
+  }
+  return *entry;
+}
+
+// static
+absl::string_view StringInterner::Find(absl::string_view str, Table table) {
+  if (str.size() > kMaxLength) return absl::string_view();
+  const std::string* entry =
+      Get(table)
+          ->FindSlot(str, absl::Hash<absl::string_view>()(str))
+          .load(std::memory_order_acquire);
+  if (entry == nullptr) return absl::string_view();
+  return *entry;
+}
+
+InternedString::InternedString(absl::string_view str,
+                               StringInterner::Table table)
+    : view_(StringInterner::Intern(str, table)) {
+  if (view_.data() == nullptr) {
+    owned_.reset(new char[str.size()]);
+    memcpy(owned_.get(), str.data(), str.size());
+    view_ = absl::string_view(owned_.get(), str.size());
+  }
+}
+
+}  // namespace common
+}  // namespace opencensus
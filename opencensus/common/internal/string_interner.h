@@ -0,0 +1,116 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef OPENCENSUS_COMMON_INTERNAL_STRING_INTERNER_H_
+#define OPENCENSUS_COMMON_INTERNAL_STRING_INTERNER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace opencensus {
+namespace common {
+
+// StringInterner keeps a single copy of strings that recur throughout the
+// process, such as span names and attribute keys, for the life of the process.
+// Interned copies can be compared by address.
+//
+// Each table has a fixed capacity, so that high-cardinality strings cannot
+// grow it without bound; once it is full, strings that are not already in it
+// are not interned. Attribute keys have their own table, so that many distinct
+// keys cannot crowd out span names.
+//
+// Lookups do not lock. StringInterner is thread-safe; there is one instance
+// per table.
+class StringInterner final {
+ public:
+  enum class Table { kDefault, kAttributeKeys };
+
+  // The most strings that are interned in each table.
+  static constexpr size_t kMaxStrings = 4096;
+  // Longer strings are not interned.
+  static constexpr size_t kMaxLength = 1024;
+
+  // Returns the interned copy of str, interning it if it is new and fits.
+  // Returns a string_view with a null data() if it is not interned.
+  static absl::string_view Intern(absl::string_view str,
+                                  Table table = Table::kDefault);
+
+  // Returns the interned copy of str, without interning it. Returns a
+  // string_view with a null data() if it is not interned.
+  static absl::string_view Find(absl::string_view str,
+                                Table table = Table::kDefault);
+
+ private:
+  // Open addressing with linear probing, at most half full. Slots are filled
+  // once and never change, so lookups can read them without locking.
+  static constexpr size_t kNumSlots = 2 * kMaxStrings;
+
+  StringInterner() = default;
+  static StringInterner* Get(Table table);
+
+  // Returns the slot that holds str, or the empty slot where it would go.
+  std::atomic<const std::string*>& FindSlot(absl::string_view str,
+                                           size_t hash);
+
+  std::atomic<const std::string*> slots_[kNumSlots] = {};
+  // Set when the table is full, so that misses need not lock.
+  std::atomic<bool> full_{false};
+
+  absl::Mutex mu_;
+  size_t size_ GUARDED_BY(mu_) = 0;
+};
+
+// InternedString holds a string in a StringInterner table if it can be
+// interned, and a private copy otherwise. The view is stable across moves.
+// Only strings from the same table compare by address.
+class InternedString final {
+ public:
+  explicit InternedString(
+      absl::string_view str,
+      StringInterner::Table table = StringInterner::Table::kDefault);
+
+  InternedString(InternedString&&) = default;
+  InternedString& operator=(InternedString&&) = default;
+
+  absl::string_view view() const { return view_; }
+
+  // Returns true if the string is interned, and so can be compared by address
+  // with other interned copies.
+  bool interned() const { return owned_ == nullptr; }
+
+  // Interned strings compare by address.
+  bool operator==(const InternedString& other) const {
+    if (interned() && other.interned()) {
+      return view_.data() == other.view_.data();
+    }
+    return view_ == other.view_;
+  }
+  bool operator!=(const InternedString& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  std::unique_ptr<char[]> owned_;
+  absl::string_view view_;
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_STRING_INTERNER_H_
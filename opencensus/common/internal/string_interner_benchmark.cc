@@ -0,0 +1,66 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/common/internal/string_interner.h"
+
+namespace {
+
+constexpr char kName[] = "/opencensus.example.Service/Method";
+
+void BM_Intern(benchmark::State& state) {
+  ::opencensus::common::StringInterner::Intern(kName);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ::opencensus::common::StringInterner::Intern(kName));
+  }
+}
+BENCHMARK(BM_Intern);
+
+void BM_InternMultiThreaded(benchmark::State& state) {
+  ::opencensus::common::StringInterner::Intern(kName);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ::opencensus::common::StringInterner::Intern(kName));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_InternMultiThreaded)->ThreadRange(1, 16)->UseRealTime();
+
+void BM_InternedString(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    ::opencensus::common::InternedString name(kName);
+    benchmark::DoNotOptimize(name);
+  }
+}
+BENCHMARK(BM_InternedString);
+
+// For comparison with BM_InternedString.
+void BM_CopyString(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    std::string name(kName);
+    benchmark::DoNotOptimize(name);
+  }
+}
+BENCHMARK(BM_CopyString);
+
+}  // namespace
+BENCHMARK_MAIN();
@@ -0,0 +1,133 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/string_interner.h"
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+namespace {
+
+TEST(StringInternerTest, InternReturnsOneCopy) {
+  const std::string a = "interner_test_name";
+  const std::string b = "interner_test_name";
+  const absl::string_view interned = StringInterner::Intern(a);
+  EXPECT_EQ(a, interned);
+  EXPECT_NE(a.data(), interned.data());
+  EXPECT_EQ(interned.data(), StringInterner::Intern(b).data());
+  EXPECT_EQ(interned.data(), StringInterner::Find(b).data());
+}
+
+TEST(StringInternerTest, InternsEmptyString) {
+  const absl::string_view interned = StringInterner::Intern("");
+  EXPECT_NE(nullptr, interned.data());
+  EXPECT_TRUE(interned.empty());
+}
+
+TEST(StringInternerTest, FindDoesNotIntern) {
+  EXPECT_EQ(nullptr, StringInterner::Find("interner_test_not_found").data());
+  EXPECT_EQ(nullptr, StringInterner::Find("interner_test_not_found").data());
+}
+
+TEST(StringInternerTest, DoesNotInternLongStrings) {
+  const std::string long_string(StringInterner::kMaxLength + 1, 'x');
+  EXPECT_EQ(nullptr, StringInterner::Intern(long_string).data());
+  const InternedString interned(long_string);
+  EXPECT_FALSE(interned.interned());
+  EXPECT_EQ(long_string, interned.view());
+}
+
+TEST(StringInternerTest, ConcurrentIntern) {
+  std::vector<std::thread> threads;
+  std::vector<const char*> results(4);
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([i, &results] {
+      for (int j = 0; j < 100; ++j) {
+        StringInterner::Intern(absl::StrCat("interner_test_concurrent_", j));
+      }
+      results[i] = StringInterner::Intern("interner_test_concurrent_7").data();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (const char* result : results) EXPECT_EQ(results[0], result);
+}
+
+TEST(InternedStringTest, ComparesInternedByAddress) {
+  const InternedString a("interned_string_test");
+  const InternedString b("interned_string_test");
+  const InternedString c("interned_string_test_other");
+  EXPECT_TRUE(a.interned());
+  EXPECT_EQ(a.view().data(), b.view().data());
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+}
+
+TEST(InternedStringTest, ComparesOwnedByValue) {
+  const std::string long_string(StringInterner::kMaxLength + 1, 'x');
+  const InternedString a(long_string);
+  const InternedString b(long_string);
+  EXPECT_NE(a.view().data(), b.view().data());
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, InternedString("interned_string_test"));
+}
+
+TEST(InternedStringTest, MoveKeepsView) {
+  const std::string long_string(StringInterner::kMaxLength + 1, 'x');
+  InternedString a(long_string);
+  const char* data = a.view().data();
+  InternedString b(std::move(a));
+  EXPECT_EQ(data, b.view().data());
+  EXPECT_EQ(long_string, b.view());
+}
+
+TEST(StringInternerTest, TablesAreSeparate) {
+  const absl::string_view key = StringInterner::Intern(
+      "interner_test_key", StringInterner::Table::kAttributeKeys);
+  EXPECT_NE(nullptr, key.data());
+  EXPECT_EQ(key.data(),
+            StringInterner::Find("interner_test_key",
+                                 StringInterner::Table::kAttributeKeys)
+                .data());
+  EXPECT_EQ(nullptr, StringInterner::Find("interner_test_key").data());
+}
+
+// In its own suite, which runs last, since it fills the table.
+TEST(StringInternerFullTest, StopsInterningWhenFull) {
+  for (size_t i = 0; i < StringInterner::kMaxStrings; ++i) {
+    StringInterner::Intern(absl::StrCat("interner_test_fill_", i));
+  }
+  const std::string name = "interner_test_after_full";
+  EXPECT_EQ(nullptr, StringInterner::Intern(name).data());
+  const InternedString interned(name);
+  EXPECT_FALSE(interned.interned());
+  EXPECT_EQ(name, interned.view());
+  // Strings interned earlier are still found.
+  EXPECT_NE(nullptr, StringInterner::Intern("interner_test_name").data());
+  // Other tables are not full.
+  EXPECT_NE(nullptr, StringInterner::Intern(
+                         name, StringInterner::Table::kAttributeKeys)
+                         .data());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
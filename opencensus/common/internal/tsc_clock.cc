@@ -0,0 +1,236 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/common/internal/tsc_clock.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/rcu.h"
+
+#ifdef OPENCENSUS_HAVE_RDTSC
+#include <cpuid.h>
+#endif
+
+namespace opencensus {
+namespace common {
+namespace {
+
+// How long the first calibration measures the rate for. The rate is refined
+// over longer intervals later.
+constexpr int64_t kInitialCalibrationNanos = 1000 * 1000;
+// How stale the calibration may get before it is refined.
+constexpr int64_t kResyncIntervalNanos = 1000 * 1000 * 1000;
+
+// A reading of the counter, the monotonic clock and the wall clock.
+struct Sample {
+  int64_t ticks;
+  int64_t steady_nanos;
+  int64_t nanos;
+};
+
+#ifdef OPENCENSUS_HAVE_RDTSC
+// Returns true if the time-stamp counter runs at a constant rate in all power
+// states, per CPUID leaf 0x80000007.
+bool HasInvariantTsc() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) {
+    return false;
+  }
+  __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+  return (edx & (1u << 8)) != 0;
+}
+
+// Reads the monotonic clock, which the rate is measured against.
+int64_t SteadyNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Reads all clocks. The other clocks are read between two reads of the
+// counter, and the closest of a few attempts is kept, so that a preemption
+// between the reads does not skew the calibration.
+Sample TakeSample() {
+  Sample best = {0, 0, 0};
+  int64_t best_window = std::numeric_limits<int64_t>::max();
+  for (int i = 0; i < 5; ++i) {
+    const int64_t before = static_cast<int64_t>(__rdtsc());
+    const int64_t steady_nanos = SteadyNanos();
+    const int64_t nanos = absl::GetCurrentTimeNanos();
+    const int64_t after = static_cast<int64_t>(__rdtsc());
+    if (after - before < best_window) {
+      best_window = after - before;
+      best = {before + (after - before) / 2, steady_nanos, nanos};
+    }
+  }
+  return best;
+}
+#endif
+
+// How ticks convert to wall-clock time.
+struct Calibration {
+  int64_t base_ticks;
+  int64_t base_nanos;
+  double nanos_per_tick;
+};
+
+// Calibrator owns the conversion from ticks to wall-clock time, and decides
+// whether ticks are counter cycles. Readers do not lock: the calibration is
+// replaced, not modified.
+class Calibrator {
+ public:
+  static Calibrator* Get() {
+    static Calibrator* global_calibrator = new Calibrator;
+    return global_calibrator;
+  }
+
+  // Copies the calibration, refining it first if it is older than
+  // kResyncIntervalNanos and no other thread is already doing so.
+  Calibration Read() LOCKS_EXCLUDED(mu_) {
+    RcuReadLock lock;
+    const Calibration* calibration = calibration_.Read(lock);
+    if (uses_tsc_ &&
+        (TscClock::Now() - calibration->base_ticks) *
+                calibration->nanos_per_tick >
+            kResyncIntervalNanos &&
+        mu_.TryLock()) {
+      Resync();
+      mu_.Unlock();
+      calibration = calibration_.Read(lock);
+    }
+    return *calibration;
+  }
+
+  void ResyncForTesting() LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    if (uses_tsc_) Resync();
+  }
+
+  bool uses_tsc() const { return uses_tsc_; }
+
+  // The rate from the latest calibration.
+  double nanos_per_tick() const {
+    return nanos_per_tick_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  Calibrator();
+
+  // Measures the rate against the monotonic clock since the first sample,
+  // which grows more accurate as the interval grows and is not skewed by steps
+  // of the wall clock, and rebases on the newest sample's wall-clock time so
+  // that wall-clock adjustments are picked up.
+  void Resync() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  bool uses_tsc_ = false;
+  Sample first_ = {0, 0, 0};
+  RcuPtr<Calibration> calibration_;
+  std::atomic<double> nanos_per_tick_{1};
+  // Serializes Resync().
+  absl::Mutex mu_;
+};
+
+// Without a counter, ticks are nanoseconds. The base is recent so that the
+// offsets converted through a double stay exact.
+std::unique_ptr<const Calibration> NanosCalibration() {
+  const int64_t now = absl::GetCurrentTimeNanos();
+  return absl::make_unique<const Calibration>(Calibration{now, now, 1});
+}
+
+Calibrator::Calibrator() : calibration_(NanosCalibration()) {
+#ifdef OPENCENSUS_HAVE_RDTSC
+  if (HasInvariantTsc()) {
+    first_ = TakeSample();
+    Sample sample;
+    do {
+      sample = TakeSample();
+    } while (sample.steady_nanos - first_.steady_nanos <
+             kInitialCalibrationNanos);
+    if (sample.ticks > first_.ticks) {
+      uses_tsc_ = true;
+      absl::MutexLock l(&mu_);
+      Resync();
+    }
+  }
+#endif
+}
+
+void Calibrator::Resync() {
+#ifdef OPENCENSUS_HAVE_RDTSC
+  const Sample sample = TakeSample();
+  if (sample.ticks <= first_.ticks) return;
+  const double nanos_per_tick =
+      static_cast<double>(sample.steady_nanos - first_.steady_nanos) /
+      static_cast<double>(sample.ticks - first_.ticks);
+  calibration_.Update(absl::make_unique<const Calibration>(
+      Calibration{sample.ticks, sample.nanos, nanos_per_tick}));
+  nanos_per_tick_.store(nanos_per_tick, std::memory_order_relaxed);
+#endif
+}
+
+}  // namespace
+
+std::atomic<TscClock::Mode> TscClock::mode_(TscClock::Mode::kUninitialized);
+
+TscClock::Converter::Converter() {
+  const Calibration calibration = Calibrator::Get()->Read();
+  base_ticks_ = calibration.base_ticks;
+  base_nanos_ = calibration.base_nanos;
+  nanos_per_tick_ = calibration.nanos_per_tick;
+}
+
+absl::Time TscClock::Converter::ToTime(int64_t ticks) const {
+  return absl::FromUnixNanos(base_nanos_ +
+                             std::llround((ticks - base_ticks_) *
+                                          nanos_per_tick_));
+}
+
+absl::Duration TscClock::Converter::ToDuration(int64_t ticks) const {
+  return absl::Nanoseconds(std::llround(ticks * nanos_per_tick_));
+}
+
+// static
+absl::Duration TscClock::ToDuration(int64_t ticks) {
+  return absl::Nanoseconds(
+      std::llround(ticks * Calibrator::Get()->nanos_per_tick()));
+}
+
+// static
+bool TscClock::UsesTsc() { return Calibrator::Get()->uses_tsc(); }
+
+// static
+int64_t TscClock::NowSlow() {
+  const bool uses_tsc = Calibrator::Get()->uses_tsc();
+  mode_.store(uses_tsc ? Mode::kTsc : Mode::kNanos, std::memory_order_relaxed);
+#ifdef OPENCENSUS_HAVE_RDTSC
+  if (uses_tsc) return static_cast<int64_t>(__rdtsc());
+#endif
+  return absl::GetCurrentTimeNanos();
+}
+
+// static
+void TscClock::ResyncForTesting() { Calibrator::Get()->ResyncForTesting(); }
+
+}  // namespace common
+}  // namespace opencensus
@@ -0,0 +1,107 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_COMMON_INTERNAL_TSC_CLOCK_H_
+#define OPENCENSUS_COMMON_INTERNAL_TSC_CLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/optimization.h"
+#include "absl/time/time.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#define OPENCENSUS_HAVE_RDTSC 1
+#endif
+
+namespace opencensus {
+namespace common {
+
+// TscClock is a clock for timestamps that are taken often and read rarely,
+// such as the times of Span events. Now() returns ticks, which are cheap to
+// take and to store; ToTime() converts them to wall-clock time.
+//
+// Where the CPU has an invariant time-stamp counter, ticks are cycles of that
+// counter, and are converted using a rate that is calibrated against the
+// monotonic clock when the clock is first used and refined at most once a
+// second afterwards, each time rebasing on the wall clock. Elsewhere, ticks are
+// nanoseconds since the Unix epoch.
+//
+// Ticks are only meaningful within the process that took them.
+//
+// TscClock is thread-safe.
+class TscClock final {
+ public:
+  TscClock() = delete;
+
+  // Returns the current time in ticks.
+  static int64_t Now() {
+#ifdef OPENCENSUS_HAVE_RDTSC
+    if (ABSL_PREDICT_TRUE(mode_.load(std::memory_order_relaxed) ==
+                          Mode::kTsc)) {
+      return static_cast<int64_t>(__rdtsc());
+    }
+#endif
+    return NowSlow();
+  }
+
+  // Converts ticks with a single calibration, so that converted times keep the
+  // order and spacing of the ticks. Make one per batch of related ticks, such
+  // as the timestamps of one Span.
+  class Converter final {
+   public:
+    // Copies the current calibration, refining it first if it is stale.
+    Converter();
+
+    absl::Time ToTime(int64_t ticks) const;
+
+    // Converts a difference between two tick values.
+    absl::Duration ToDuration(int64_t ticks) const;
+
+   private:
+    int64_t base_ticks_;
+    int64_t base_nanos_;
+    double nanos_per_tick_;
+  };
+
+  // Converts ticks from Now() to wall-clock time.
+  static absl::Time ToTime(int64_t ticks) { return Converter().ToTime(ticks); }
+
+  // Converts a difference between two values of Now() to a Duration. This is
+  // cheaper than a Converter, and suits measuring latencies.
+  static absl::Duration ToDuration(int64_t ticks);
+
+  // Returns true if ticks are time-stamp counter cycles.
+  static bool UsesTsc();
+
+ private:
+  friend class TscClockTestPeer;
+
+  enum class Mode : int { kUninitialized, kTsc, kNanos };
+
+  // Picks the mode if it has not been picked, and returns the current time in
+  // ticks.
+  static int64_t NowSlow();
+
+  // Calibrates the rate now, instead of waiting for the next resync.
+  static void ResyncForTesting();
+
+  static std::atomic<Mode> mode_;
+};
+
+}  // namespace common
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_COMMON_INTERNAL_TSC_CLOCK_H_
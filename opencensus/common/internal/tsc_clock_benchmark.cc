@@ -0,0 +1,60 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <cstdint>
+
+#include "absl/time/clock.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/common/internal/tsc_clock.h"
+
+namespace {
+
+void BM_TscClockNow(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(::opencensus::common::TscClock::Now());
+  }
+}
+BENCHMARK(BM_TscClockNow);
+
+// For comparison with BM_TscClockNow.
+void BM_AbslNow(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(absl::Now());
+  }
+}
+BENCHMARK(BM_AbslNow);
+
+void BM_TscClockToTime(benchmark::State& state) {
+  const int64_t ticks = ::opencensus::common::TscClock::Now();
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(::opencensus::common::TscClock::ToTime(ticks));
+  }
+}
+BENCHMARK(BM_TscClockToTime);
+
+void BM_TscClockConverterToTime(benchmark::State& state) {
+  const int64_t ticks = ::opencensus::common::TscClock::Now();
+  const ::opencensus::common::TscClock::Converter converter;
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(converter.ToTime(ticks));
+  }
+}
+BENCHMARK(BM_TscClockConverterToTime);
+
+}  // namespace
+BENCHMARK_MAIN();
@@ -0,0 +1,85 @@
+// Copyright 2017, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "opencensus/common/internal/tsc_clock.h"
+
+#include <cstdint>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace common {
+
+class TscClockTestPeer {
+ public:
+  static void ResyncForTesting() { TscClock::ResyncForTesting(); }
+};
+
+namespace {
+
+TEST(TscClockTest, NowIsMonotonic) {
+  int64_t previous = TscClock::Now();
+  for (int i = 0; i < 1000; ++i) {
+    const int64_t now = TscClock::Now();
+    EXPECT_LE(previous, now);
+    previous = now;
+  }
+}
+
+TEST(TscClockTest, ToTimeMatchesWallClock) {
+  const absl::Time before = absl::Now();
+  const int64_t ticks = TscClock::Now();
+  const absl::Time after = absl::Now();
+  const absl::Time time = TscClock::ToTime(ticks);
+  // Allows for the error of a calibration over a millisecond.
+  EXPECT_LE(before - absl::Milliseconds(1), time);
+  EXPECT_GE(after + absl::Milliseconds(1), time);
+}
+
+TEST(TscClockTest, ToDurationMatchesWallClock) {
+  const int64_t start_ticks = TscClock::Now();
+  const absl::Time start = absl::Now();
+  absl::SleepFor(absl::Milliseconds(20));
+  const int64_t end_ticks = TscClock::Now();
+  const absl::Time end = absl::Now();
+  const absl::Duration duration = TscClock::ToDuration(end_ticks - start_ticks);
+  EXPECT_LE(absl::Milliseconds(20) - absl::Microseconds(500), duration);
+  EXPECT_GE(end - start + absl::Milliseconds(1), duration);
+}
+
+TEST(TscClockTest, ConverterKeepsOrder) {
+  const int64_t first = TscClock::Now();
+  const int64_t second = TscClock::Now();
+  const TscClock::Converter converter;
+  EXPECT_LE(converter.ToTime(first), converter.ToTime(second));
+  // Each conversion rounds to a nanosecond.
+  EXPECT_LE(absl::AbsDuration(converter.ToTime(second) -
+                              converter.ToTime(first) -
+                              converter.ToDuration(second - first)),
+            absl::Nanoseconds(1));
+}
+
+TEST(TscClockTest, ResyncKeepsEarlierTicks) {
+  const int64_t ticks = TscClock::Now();
+  const absl::Time time = TscClock::ToTime(ticks);
+  absl::SleepFor(absl::Milliseconds(20));
+  TscClockTestPeer::ResyncForTesting();
+  EXPECT_LE(absl::AbsDuration(TscClock::ToTime(ticks) - time),
+            absl::Milliseconds(1));
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace opencensus
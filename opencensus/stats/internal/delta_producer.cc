@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <tuple>
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
@@ -25,17 +26,18 @@
 #include "opencensus/stats/bucket_boundaries.h"
 #include "opencensus/stats/internal/measure_data.h"
 #include "opencensus/stats/internal/measure_registry_impl.h"
+#include "opencensus/stats/internal/self_stats_impl.h"
 #include "opencensus/stats/internal/stats_manager.h"
 
 namespace opencensus {
 namespace stats {
 
 void Delta::Record(std::initializer_list<Measurement> measurements,
-                   TagSet tags) {
+                   const TagSet& tags) {
   auto it = delta_.find(tags);
   if (it == delta_.end()) {
     it = delta_.emplace_hint(it, std::piecewise_construct,
-                             std::make_tuple(std::move(tags)),
+                             std::forward_as_tuple(tags),
                              std::make_tuple(std::vector<MeasureData>()));
     it->second.reserve(registered_boundaries_.size());
     for (const auto& boundaries_for_measure : registered_boundaries_) {
@@ -101,17 +103,51 @@ void DeltaProducer::AddBoundaries(uint64_t index,
 }
 
 void DeltaProducer::Record(std::initializer_list<Measurement> measurements,
-                           TagSet tags) {
-  absl::MutexLock l(&delta_mu_);
-  active_delta_.Record(measurements, std::move(tags));
+                           const TagSet& tags) {
+  bool reached_max;
+  {
+    absl::MutexLock l(&delta_mu_);
+    active_delta_.Record(measurements, tags);
+    // The limit may have been lowered below the current size, so compare with
+    // >=, but ask for an early harvest only once per delta.
+    const int64_t max_tag_sets =
+        max_delta_tag_sets_.load(std::memory_order_relaxed);
+    reached_max = max_tag_sets > 0 && !early_harvest_pending_ &&
+                  static_cast<int64_t>(active_delta_.delta().size()) >=
+                      max_tag_sets;
+    if (reached_max) early_harvest_pending_ = true;
+  }
+  if (reached_max) RequestEarlyHarvest();
+}
+
+void DeltaProducer::RecordInternal(
+    std::initializer_list<Measurement> measurements, TagSet tags) {
+  absl::MutexLock l(&internal_mu_);
+  internal_delta_.Record(measurements, tags);
 }
 
 void DeltaProducer::Flush() {
-  delta_mu_.Lock();
-  absl::MutexLock harvester_lock(&harvester_mu_);
-  SwapDeltas();
-  delta_mu_.Unlock();
-  ConsumeLastDelta();
+  const absl::Time start = absl::Now();
+  {
+    delta_mu_.Lock();
+    absl::MutexLock harvester_lock(&harvester_mu_);
+    SwapDeltas();
+    delta_mu_.Unlock();
+    ConsumeLastDelta();
+  }
+  SelfStatsImpl::Get()->RecordHarvest(absl::Now() - start);
+}
+
+void DeltaProducer::SetHarvestInterval(absl::Duration interval) {
+  // A non-positive interval would make the harvester loop without waiting.
+  if (interval <= absl::ZeroDuration()) return;
+  absl::MutexLock l(&harvest_control_mu_);
+  harvest_interval_ = interval;
+  interval_changed_ = true;
+}
+
+void DeltaProducer::SetMaxDeltaTagSets(int64_t max_tag_sets) {
+  max_delta_tag_sets_.store(max_tag_sets, std::memory_order_relaxed);
 }
 
 DeltaProducer::DeltaProducer()
@@ -120,21 +156,51 @@ DeltaProducer::DeltaProducer()
 void DeltaProducer::SwapDeltas() {
   ABSL_ASSERT(last_delta_.delta().empty() && "Last delta was not consumed.");
   active_delta_.SwapAndReset(registered_boundaries_, &last_delta_);
+  early_harvest_pending_ = false;
+  absl::MutexLock l(&internal_mu_);
+  internal_delta_.SwapAndReset(registered_boundaries_, &last_internal_delta_);
 }
 
 void DeltaProducer::ConsumeLastDelta() {
+  const absl::Time start = absl::Now();
+  const int64_t tag_sets = last_delta_.delta().size();
   StatsManager::Get()->MergeDelta(last_delta_);
   last_delta_.clear();
+  const absl::Duration merge_latency = absl::Now() - start;
+  StatsManager::Get()->MergeDelta(last_internal_delta_);
+  last_internal_delta_.clear();
+  SelfStatsImpl::Get()->RecordMerge(merge_latency, tag_sets);
+}
+
+void DeltaProducer::RequestEarlyHarvest() {
+  absl::MutexLock l(&harvest_control_mu_);
+  early_harvest_requested_ = true;
+}
+
+bool DeltaProducer::ShouldWakeHarvester() const {
+  return early_harvest_requested_ || interval_changed_;
 }
 
 void DeltaProducer::RunHarvesterLoop() {
-  absl::Time next_harvest_time = absl::Now() + harvest_interval_;
+  absl::Time last_harvest_time = absl::Now();
   while (true) {
-    const absl::Time now = absl::Now();
-    absl::SleepFor(next_harvest_time - now);
-    // Account for the possibility that the last harvest took longer than
-    // harvest_interval_ and we are already past next_harvest_time.
-    next_harvest_time = std::max(next_harvest_time, now) + harvest_interval_;
+    {
+      absl::MutexLock l(&harvest_control_mu_);
+      while (!early_harvest_requested_) {
+        // Recomputed on each wakeup, since the interval may have changed.
+        const absl::Time next_harvest_time =
+            last_harvest_time + harvest_interval_;
+        if (absl::Now() >= next_harvest_time) break;
+        interval_changed_ = false;
+        harvest_control_mu_.AwaitWithDeadline(
+            absl::Condition(this, &DeltaProducer::ShouldWakeHarvester),
+            next_harvest_time);
+      }
+      early_harvest_requested_ = false;
+    }
+    // If the last harvest took longer than harvest_interval_ the next one
+    // starts immediately.
+    last_harvest_time = absl::Now();
     Flush();
   }
 }
@@ -15,6 +15,7 @@
 #ifndef OPENCENSUS_STATS_INTERNAL_DELTA_PRODUCER_H_
 #define OPENCENSUS_STATS_INTERNAL_DELTA_PRODUCER_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <thread>
@@ -35,7 +36,9 @@ namespace stats {
 // Delta is thread-compatible.
 class Delta final {
  public:
-  void Record(std::initializer_list<Measurement> measurements, TagSet tags);
+  // Copies tags only if they are new to the delta.
+  void Record(std::initializer_list<Measurement> measurements,
+              const TagSet& tags);
 
   // Swaps registered_boundaries_ and delta_ with *other, clears delta_, and
   // updates registered_boundaries_.
@@ -74,12 +77,28 @@ class DeltaProducer final {
   // exist.
   void AddBoundaries(uint64_t index, const BucketBoundaries& boundaries);
 
-  void Record(std::initializer_list<Measurement> measurements, TagSet tags)
-      LOCKS_EXCLUDED(delta_mu_);
+  void Record(std::initializer_list<Measurement> measurements,
+              const TagSet& tags) LOCKS_EXCLUDED(delta_mu_);
+
+  // Records measurements about the stats library itself. These are kept apart
+  // from data recorded with Record(), and are merged into views after each
+  // harvest without being counted by it, so that recording them from within
+  // the harvest does not change what is being measured.
+  void RecordInternal(std::initializer_list<Measurement> measurements,
+                      TagSet tags) LOCKS_EXCLUDED(internal_mu_);
 
   // Flushes the active delta and blocks until it is harvested.
   void Flush() LOCKS_EXCLUDED(delta_mu_, harvester_mu_);
 
+  // Sets the maximum time between harvests. Non-positive intervals are
+  // ignored.
+  void SetHarvestInterval(absl::Duration interval)
+      LOCKS_EXCLUDED(harvest_control_mu_);
+
+  // Sets the number of distinct tag sets in the active delta at which the
+  // harvester is woken early. 0 disables early harvests.
+  void SetMaxDeltaTagSets(int64_t max_tag_sets);
+
  private:
   DeltaProducer();
 
@@ -92,11 +111,25 @@ class DeltaProducer final {
   void ConsumeLastDelta() EXCLUSIVE_LOCKS_REQUIRED(harvester_mu_)
       LOCKS_EXCLUDED(delta_mu_);
 
+  // Wakes the harvester to flush without waiting for harvest_interval_.
+  void RequestEarlyHarvest() LOCKS_EXCLUDED(harvest_control_mu_);
+
+  bool ShouldWakeHarvester() const SHARED_LOCKS_REQUIRED(harvest_control_mu_);
+
   // Loops flushing the active delta (calling SwapDeltas and ConsumeLastDelta())
-  // every harvest_interval_.
-  void RunHarvesterLoop();
+  // every harvest_interval_, or sooner when the active delta reaches
+  // max_delta_tag_sets_.
+  void RunHarvesterLoop() LOCKS_EXCLUDED(harvest_control_mu_);
+
+  // Read without locking by Record().
+  std::atomic<int64_t> max_delta_tag_sets_{10000};
 
-  const absl::Duration harvest_interval_ = absl::Seconds(5);
+  // Guards scheduling of the harvester; never held while harvesting.
+  mutable absl::Mutex harvest_control_mu_ ACQUIRED_AFTER(delta_mu_);
+  absl::Duration harvest_interval_ GUARDED_BY(harvest_control_mu_) =
+      absl::Seconds(5);
+  bool early_harvest_requested_ GUARDED_BY(harvest_control_mu_) = false;
+  bool interval_changed_ GUARDED_BY(harvest_control_mu_) = false;
 
   // Guards the active delta and its configuration. Anything that changes the
   // delta configuration (e.g. adding a measure or BucketBoundaries) must
@@ -110,6 +143,9 @@ class DeltaProducer final {
   std::vector<std::vector<BucketBoundaries>> registered_boundaries_
       GUARDED_BY(delta_mu_);
   Delta active_delta_ GUARDED_BY(delta_mu_);
+  // Set once active_delta_ has asked for an early harvest, so that it asks
+  // only once.
+  bool early_harvest_pending_ GUARDED_BY(delta_mu_) = false;
 
   // Guards the last_delta_; acquired by the main thread when triggering a
   // flush.
@@ -117,6 +153,15 @@ class DeltaProducer final {
   // TODO: consider making this a lockless queue to avoid blocking the main
   // thread when calling a flush during harvesting.
   Delta last_delta_ GUARDED_BY(harvester_mu_);
+  Delta last_internal_delta_ GUARDED_BY(harvester_mu_);
+
+  // Guards internal_delta_, which collects RecordInternal() data. Swapped to
+  // last_internal_delta_ alongside active_delta_.
+  mutable absl::Mutex internal_mu_ ACQUIRED_AFTER(harvester_mu_);
+  Delta internal_delta_ GUARDED_BY(internal_mu_);
+
+  // Declared last so that the harvester starts after all other members are
+  // initialized.
   std::thread harvester_thread_ GUARDED_BY(harvester_mu_);
 };
 
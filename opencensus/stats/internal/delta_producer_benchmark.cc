@@ -0,0 +1,92 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/stats/aggregation.h"
+#include "opencensus/stats/internal/delta_producer.h"
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/recording.h"
+#include "opencensus/stats/stats_config.h"
+#include "opencensus/stats/tag_key.h"
+#include "opencensus/stats/tag_set.h"
+#include "opencensus/stats/view.h"
+#include "opencensus/stats/view_descriptor.h"
+
+namespace opencensus {
+namespace stats {
+namespace {
+
+constexpr int kBurstTagSets = 100000;
+
+// Records a burst of kBurstTagSets distinct TagSets, as happens when a
+// high-cardinality tag sees a spike of traffic. The argument is the early
+// harvest threshold (see StatsConfig::SetMaxDeltaTagSets), with 0 meaning
+// harvests only happen on the interval.
+//
+// Reports peak_bytes: the highest heap usage during a burst and its harvest,
+// relative to that before the burst.
+void BM_RecordBurst(benchmark::State& state) {
+  const TagKey key = TagKey::Register("burst_key");
+  static const MeasureDouble measure =
+      MeasureDouble::Register("burst_measure", "", "");
+  // Holds the merged data, as a real view would, so that the peak includes
+  // both buffered and merged data.
+  View view(ViewDescriptor()
+                .set_name("burst_view")
+                .set_measure("burst_measure")
+                .set_aggregation(Aggregation::Sum())
+                .add_column(key));
+  std::vector<TagSet> tag_sets;
+  tag_sets.reserve(kBurstTagSets);
+  for (int i = 0; i < kBurstTagSets; ++i) {
+    tag_sets.push_back(TagSet({{key, absl::StrCat("value", i)}}));
+  }
+  StatsConfig::SetMaxDeltaTagSets(state.range(0));
+
+  int64_t peak_bytes = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    DeltaProducer::Get()->Flush();
+    common::AllocationCounter::ResetPeakLiveBytes();
+    const int64_t start_bytes = common::AllocationCounter::LiveBytes();
+    state.ResumeTiming();
+
+    for (const auto& tag_set : tag_sets) {
+      Record({{measure, 1.0}}, tag_set);
+    }
+    DeltaProducer::Get()->Flush();
+
+    peak_bytes = std::max(
+        peak_bytes, common::AllocationCounter::PeakLiveBytes() - start_bytes);
+  }
+  state.counters["peak_bytes"] = peak_bytes;
+  state.SetItemsProcessed(state.iterations() * kBurstTagSets);
+  StatsConfig::SetMaxDeltaTagSets(10000);
+}
+BENCHMARK(BM_RecordBurst)
+    ->Arg(0)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace stats
+}  // namespace opencensus
+BENCHMARK_MAIN();
@@ -22,8 +22,9 @@
 namespace opencensus {
 namespace stats {
 
-void Record(std::initializer_list<Measurement> measurements, TagSet tags) {
-  DeltaProducer::Get()->Record(measurements, std::move(tags));
+void Record(std::initializer_list<Measurement> measurements,
+            const TagSet& tags) {
+  DeltaProducer::Get()->Record(measurements, tags);
 }
 
 }  // namespace stats
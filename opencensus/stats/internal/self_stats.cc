@@ -0,0 +1,231 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/stats/self_stats.h"
+#include "opencensus/stats/internal/self_stats_impl.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/stats/aggregation.h"
+#include "opencensus/stats/bucket_boundaries.h"
+#include "opencensus/stats/internal/delta_producer.h"
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/tag_key.h"
+#include "opencensus/stats/view_data.h"
+#include "opencensus/stats/view_descriptor.h"
+
+namespace opencensus {
+namespace stats {
+
+namespace {
+
+constexpr char kPrefix[] = "opencensus.io/internal/stats/";
+
+// Approximate per-entry overhead of a node in an unordered_map.
+constexpr int64_t kMapNodeOverhead = 2 * sizeof(void*);
+
+template <typename MeasureT>
+Measure<MeasureT> RegisterWithView(absl::string_view name,
+                                   absl::string_view description,
+                                   absl::string_view units,
+                                   const Aggregation& aggregation,
+                                   const std::vector<TagKey>& columns) {
+  const std::string full_name = absl::StrCat(kPrefix, name);
+  const Measure<MeasureT> measure =
+      Measure<MeasureT>::Register(full_name, description, units);
+  ViewDescriptor descriptor = ViewDescriptor()
+                                  .set_name(full_name)
+                                  .set_measure(full_name)
+                                  .set_aggregation(aggregation)
+                                  .set_description(description);
+  for (const auto& column : columns) {
+    descriptor.add_column(column);
+  }
+  descriptor.RegisterForExport();
+  return measure;
+}
+
+template <typename DataValueT>
+int64_t EstimateRowsBytes(const ViewData::DataMap<DataValueT>& rows) {
+  int64_t bytes = 0;
+  for (const auto& row : rows) {
+    bytes += kMapNodeOverhead + sizeof(row);
+    for (const auto& tag_value : row.first) {
+      bytes += sizeof(std::string) + tag_value.capacity();
+    }
+  }
+  return bytes;
+}
+
+void RecordInternal(std::initializer_list<Measurement> measurements,
+                    TagSet tags = TagSet({})) {
+  DeltaProducer::Get()->RecordInternal(measurements, std::move(tags));
+}
+
+}  // namespace
+
+struct SelfStatsImpl::Measures {
+  Measures()
+      : view_key(TagKey::Register("view")),
+        handler_key(TagKey::Register("handler")),
+        harvest_latency(RegisterWithView<double>(
+            "harvest_latency", "Time taken to harvest recorded stats.", "ms",
+            Aggregation::Distribution(
+                BucketBoundaries::Exponential(20, 0.01, 2)),
+            {})),
+        merge_latency(RegisterWithView<double>(
+            "merge_latency",
+            "Time taken to merge harvested stats into views.", "ms",
+            Aggregation::Distribution(
+                BucketBoundaries::Exponential(20, 0.01, 2)),
+            {})),
+        delta_tag_sets(RegisterWithView<int64_t>(
+            "delta_tag_sets", "Number of distinct tag sets per harvest.", "1",
+            Aggregation::Distribution(BucketBoundaries::Exponential(20, 1, 2)),
+            {})),
+        view_rows(RegisterWithView<int64_t>(
+            "view_rows", "Number of rows in each exported view.", "1",
+            Aggregation::LastValue(), {view_key})),
+        view_bytes(RegisterWithView<int64_t>(
+            "view_bytes", "Estimated memory used by each exported view.", "By",
+            Aggregation::LastValue(), {view_key})),
+        export_latency(RegisterWithView<double>(
+            "export_latency", "Time taken by each push handler to export.",
+            "ms",
+            Aggregation::Distribution(
+                BucketBoundaries::Exponential(20, 0.01, 2)),
+            {handler_key})),
+        skipped_exports(RegisterWithView<int64_t>(
+            "skipped_exports",
+            "Snapshots skipped by each push handler because it fell behind.",
+            "1", Aggregation::Count(), {handler_key})),
+        snapshot_bytes(RegisterWithView<int64_t>(
+            "snapshot_bytes",
+            "Estimated bytes copied when snapshotting exported views.", "By",
+            Aggregation::Distribution(
+                BucketBoundaries::Exponential(24, 64, 2)),
+            {})) {}
+
+  const TagKey view_key;
+  const TagKey handler_key;
+  const MeasureDouble harvest_latency;
+  const MeasureDouble merge_latency;
+  const MeasureInt64 delta_tag_sets;
+  const MeasureInt64 view_rows;
+  const MeasureInt64 view_bytes;
+  const MeasureDouble export_latency;
+  const MeasureInt64 skipped_exports;
+  const MeasureInt64 snapshot_bytes;
+};
+
+// static
+SelfStatsImpl* SelfStatsImpl::Get() {
+  static SelfStatsImpl* global_self_stats_impl = new SelfStatsImpl;
+  return global_self_stats_impl;
+}
+
+void SelfStatsImpl::Enable() {
+  absl::MutexLock l(&enable_mu_);
+  if (enabled()) return;
+  measures_.store(new Measures, std::memory_order_release);
+}
+
+void SelfStatsImpl::RecordHarvest(absl::Duration latency) {
+  const Measures* measures = measures_.load(std::memory_order_acquire);
+  if (measures == nullptr) return;
+  RecordInternal(
+      {{measures->harvest_latency, absl::ToDoubleMilliseconds(latency)}});
+}
+
+void SelfStatsImpl::RecordMerge(absl::Duration latency, int64_t tag_sets) {
+  const Measures* measures = measures_.load(std::memory_order_acquire);
+  if (measures == nullptr) return;
+  RecordInternal(
+      {{measures->merge_latency, absl::ToDoubleMilliseconds(latency)},
+       {measures->delta_tag_sets, tag_sets}});
+}
+
+int64_t SelfStatsImpl::RecordViewSize(absl::string_view view_name,
+                                      const ViewData& data) {
+  const Measures* measures = measures_.load(std::memory_order_acquire);
+  if (measures == nullptr) return 0;
+  int64_t rows = 0;
+  switch (data.type()) {
+    case ViewData::Type::kDouble:
+      rows = data.double_data().size();
+      break;
+    case ViewData::Type::kInt64:
+      rows = data.int_data().size();
+      break;
+    case ViewData::Type::kDistribution:
+      rows = data.distribution_data().size();
+      break;
+  }
+  const int64_t bytes = EstimateBytes(data);
+  RecordInternal({{measures->view_rows, rows}, {measures->view_bytes, bytes}},
+                 {{measures->view_key, view_name}});
+  return bytes;
+}
+
+void SelfStatsImpl::RecordSnapshotBytes(int64_t bytes) {
+  const Measures* measures = measures_.load(std::memory_order_acquire);
+  if (measures == nullptr) return;
+  RecordInternal({{measures->snapshot_bytes, bytes}});
+}
+
+void SelfStatsImpl::RecordExport(int handler_index, absl::Duration latency) {
+  const Measures* measures = measures_.load(std::memory_order_acquire);
+  if (measures == nullptr) return;
+  RecordInternal(
+      {{measures->export_latency, absl::ToDoubleMilliseconds(latency)}},
+      {{measures->handler_key, absl::StrCat(handler_index)}});
+}
+
+void SelfStatsImpl::RecordSkippedExport(int handler_index) {
+  const Measures* measures = measures_.load(std::memory_order_acquire);
+  if (measures == nullptr) return;
+  RecordInternal({{measures->skipped_exports, 1}},
+                 {{measures->handler_key, absl::StrCat(handler_index)}});
+}
+
+// static
+int64_t SelfStatsImpl::EstimateBytes(const ViewData& data) {
+  int64_t bytes = sizeof(ViewData);
+  switch (data.type()) {
+    case ViewData::Type::kDouble:
+      bytes += EstimateRowsBytes(data.double_data());
+      break;
+    case ViewData::Type::kInt64:
+      bytes += EstimateRowsBytes(data.int_data());
+      break;
+    case ViewData::Type::kDistribution:
+      bytes += EstimateRowsBytes(data.distribution_data());
+      for (const auto& row : data.distribution_data()) {
+        bytes += row.second.bucket_counts().capacity() * sizeof(uint64_t);
+      }
+      break;
+  }
+  return bytes;
+}
+
+void SelfStats::Enable() { SelfStatsImpl::Get()->Enable(); }
+
+}  // namespace stats
+}  // namespace opencensus
@@ -0,0 +1,86 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_STATS_INTERNAL_SELF_STATS_IMPL_H_
+#define OPENCENSUS_STATS_INTERNAL_SELF_STATS_IMPL_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/stats/view_data.h"
+
+namespace opencensus {
+namespace stats {
+
+// SelfStatsImpl implements SelfStats, and provides the hooks that the rest of
+// the library calls to record stats about itself. All Record*() functions are
+// no-ops until Enable() is called.
+//
+// Measurements are recorded with DeltaProducer::RecordInternal() rather than
+// Record(), so they never enter the delta whose harvest they measure.
+//
+// SelfStatsImpl is thread-safe and a singleton.
+class SelfStatsImpl final {
+ public:
+  static SelfStatsImpl* Get();
+
+  void Enable() LOCKS_EXCLUDED(enable_mu_);
+
+  bool enabled() const {
+    return measures_.load(std::memory_order_acquire) != nullptr;
+  }
+
+  // Records the duration of a complete harvest.
+  void RecordHarvest(absl::Duration latency);
+
+  // Records the time spent merging a harvested delta containing 'tag_sets'
+  // distinct tag sets.
+  void RecordMerge(absl::Duration latency, int64_t tag_sets);
+
+  // Records the size of a snapshot of the view 'view_name'. Returns the
+  // estimated size, for aggregating into RecordSnapshotBytes().
+  int64_t RecordViewSize(absl::string_view view_name, const ViewData& data);
+
+  // Records the total estimated size of the views snapshotted for one export.
+  void RecordSnapshotBytes(int64_t bytes);
+
+  // Records the duration of an export by the handler registered at
+  // 'handler_index'.
+  void RecordExport(int handler_index, absl::Duration latency);
+
+  // Records that the handler registered at 'handler_index' skipped a snapshot.
+  void RecordSkippedExport(int handler_index);
+
+  // Returns an estimate of the memory used by 'data'.
+  static int64_t EstimateBytes(const ViewData& data);
+
+ private:
+  // The measures and tag keys used for recording. Created once by Enable().
+  struct Measures;
+
+  SelfStatsImpl() = default;
+
+  // Serializes Enable().
+  absl::Mutex enable_mu_;
+  // Null until Enable() has registered all measures and views.
+  std::atomic<const Measures*> measures_{nullptr};
+};
+
+}  // namespace stats
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_STATS_INTERNAL_SELF_STATS_IMPL_H_
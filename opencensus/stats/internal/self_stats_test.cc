@@ -0,0 +1,155 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/stats/self_stats.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+#include "opencensus/stats/internal/delta_producer.h"
+#include "opencensus/stats/internal/self_stats_impl.h"
+#include "opencensus/stats/internal/stats_exporter_impl.h"
+#include "opencensus/stats/stats.h"
+
+namespace opencensus {
+namespace stats {
+namespace {
+
+constexpr char kMeasureName[] = "test_measure";
+constexpr char kViewName[] = "test_view";
+constexpr char kPrefix[] = "opencensus.io/internal/stats/";
+
+class NoopExporter : public StatsExporter::Handler {
+ public:
+  void ExportViewData(
+      const std::vector<std::pair<ViewDescriptor, ViewData>>& data) override {}
+};
+
+// Returns the exported data for the view 'name', or nullptr if it is not
+// exported.
+std::unique_ptr<ViewData> GetExportedView(absl::string_view name) {
+  for (auto& view : StatsExporter::GetViewData()) {
+    if (view.first.name() == name) {
+      return absl::make_unique<ViewData>(view.second);
+    }
+  }
+  return nullptr;
+}
+
+std::string InternalName(absl::string_view name) {
+  return std::string(kPrefix) + std::string(name);
+}
+
+void Flush() { DeltaProducer::Get()->Flush(); }
+
+TEST(SelfStatsTest, RecordsPipelineStats) {
+  const TagKey key = TagKey::Register("key");
+  const MeasureDouble measure =
+      MeasureDouble::Register(kMeasureName, "", "1");
+  ViewDescriptor()
+      .set_name(kViewName)
+      .set_measure(kMeasureName)
+      .set_aggregation(Aggregation::Count())
+      .add_column(key)
+      .RegisterForExport();
+  EXPECT_EQ(nullptr, GetExportedView(InternalName("harvest_latency")));
+
+  SelfStats::Enable();
+  SelfStats::Enable();
+  EXPECT_TRUE(SelfStatsImpl::Get()->enabled());
+  StatsExporter::RegisterPushHandler(absl::make_unique<NoopExporter>());
+
+  Record({{measure, 1.0}}, {{key, "value1"}});
+  Record({{measure, 1.0}}, {{key, "value2"}});
+  Flush();
+  StatsExporterImpl::Get()->Export();
+  StatsExporterImpl::Get()->WaitForExportsForTesting();
+  // Internal measurements are merged by the harvest after they are recorded.
+  Flush();
+  Flush();
+
+  const auto harvest_latency = GetExportedView(InternalName("harvest_latency"));
+  ASSERT_NE(nullptr, harvest_latency);
+  ASSERT_EQ(1, harvest_latency->distribution_data().size());
+  EXPECT_LE(2, harvest_latency->distribution_data().begin()->second.count());
+
+  const auto merge_latency = GetExportedView(InternalName("merge_latency"));
+  ASSERT_NE(nullptr, merge_latency);
+  EXPECT_EQ(1, merge_latency->distribution_data().size());
+
+  const auto tag_sets = GetExportedView(InternalName("delta_tag_sets"));
+  ASSERT_NE(nullptr, tag_sets);
+  ASSERT_EQ(1, tag_sets->distribution_data().size());
+  EXPECT_LE(2, tag_sets->distribution_data().begin()->second.max());
+
+  const auto view_rows = GetExportedView(InternalName("view_rows"));
+  ASSERT_NE(nullptr, view_rows);
+  const auto rows = view_rows->int_data().find({kViewName});
+  ASSERT_NE(view_rows->int_data().end(), rows);
+  EXPECT_EQ(2, rows->second);
+
+  const auto view_bytes = GetExportedView(InternalName("view_bytes"));
+  ASSERT_NE(nullptr, view_bytes);
+  const auto bytes = view_bytes->int_data().find({kViewName});
+  ASSERT_NE(view_bytes->int_data().end(), bytes);
+  EXPECT_LT(0, bytes->second);
+
+  const auto export_latency = GetExportedView(InternalName("export_latency"));
+  ASSERT_NE(nullptr, export_latency);
+  const auto handler = export_latency->distribution_data().find({"0"});
+  ASSERT_NE(export_latency->distribution_data().end(), handler);
+  EXPECT_EQ(1, handler->second.count());
+
+  const auto snapshot_bytes = GetExportedView(InternalName("snapshot_bytes"));
+  ASSERT_NE(nullptr, snapshot_bytes);
+  ASSERT_EQ(1, snapshot_bytes->distribution_data().size());
+  EXPECT_LT(0, snapshot_bytes->distribution_data().begin()->second.min());
+
+  StatsExporterImpl::Get()->ClearHandlersForTesting();
+}
+
+TEST(SelfStatsTest, InternalMeasurementsAreNotHarvested) {
+  SelfStats::Enable();
+  // Drain any pending measurements.
+  Flush();
+  Flush();
+  Flush();
+  const auto before = GetExportedView(InternalName("delta_tag_sets"));
+  ASSERT_NE(nullptr, before);
+  ASSERT_EQ(1, before->distribution_data().size());
+  const Distribution& before_data = before->distribution_data().begin()->second;
+
+  // Each flush records self-stats, which must not appear as tag sets in the
+  // following harvest.
+  Flush();
+  Flush();
+  const auto after = GetExportedView(InternalName("delta_tag_sets"));
+  ASSERT_NE(nullptr, after);
+  ASSERT_EQ(1, after->distribution_data().size());
+  const Distribution& after_data = after->distribution_data().begin()->second;
+
+  const uint64_t new_harvests = after_data.count() - before_data.count();
+  EXPECT_LE(2, new_harvests);
+  // All new harvests were empty, so fall in the [0, 1) bucket.
+  EXPECT_EQ(new_harvests,
+            after_data.bucket_counts()[1] - before_data.bucket_counts()[1]);
+}
+
+}  // namespace
+}  // namespace stats
+}  // namespace opencensus
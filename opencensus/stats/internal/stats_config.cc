@@ -0,0 +1,34 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/stats/stats_config.h"
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+#include "opencensus/stats/internal/delta_producer.h"
+
+namespace opencensus {
+namespace stats {
+
+void StatsConfig::SetHarvestInterval(absl::Duration interval) {
+  DeltaProducer::Get()->SetHarvestInterval(interval);
+}
+
+void StatsConfig::SetMaxDeltaTagSets(int64_t max_tag_sets) {
+  DeltaProducer::Get()->SetMaxDeltaTagSets(max_tag_sets);
+}
+
+}  // namespace stats
+}  // namespace opencensus
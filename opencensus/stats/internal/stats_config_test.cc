@@ -0,0 +1,69 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/stats/stats_config.h"
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/stats/internal/delta_producer.h"
+#include "opencensus/stats/stats.h"
+
+namespace opencensus {
+namespace stats {
+namespace {
+
+// Returns the number of rows in the view once it has at least 'rows', or after
+// a timeout.
+size_t WaitForRows(View& view, size_t rows) {
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  size_t size = 0;
+  while ((size = view.GetData().int_data().size()) < rows &&
+         absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  return size;
+}
+
+TEST(StatsConfigTest, LoweringMaxDeltaTagSetsHarvestsEarly) {
+  const TagKey key = TagKey::Register("key");
+  const MeasureDouble measure =
+      MeasureDouble::Register("stats_config_test_measure", "", "1");
+  View view(ViewDescriptor()
+                .set_name("stats_config_test_view")
+                .set_measure("stats_config_test_measure")
+                .set_aggregation(Aggregation::Count())
+                .add_column(key));
+  // Non-positive intervals are ignored, so this keeps the hour.
+  StatsConfig::SetHarvestInterval(absl::Hours(1));
+  StatsConfig::SetHarvestInterval(absl::ZeroDuration());
+  StatsConfig::SetMaxDeltaTagSets(0);
+  DeltaProducer::Get()->Flush();
+
+  Record({{measure, 1.0}}, {{key, "value1"}});
+  Record({{measure, 1.0}}, {{key, "value2"}});
+  Record({{measure, 1.0}}, {{key, "value3"}});
+  // The delta is already larger than the new limit, so the next record
+  // triggers a harvest.
+  StatsConfig::SetMaxDeltaTagSets(2);
+  Record({{measure, 1.0}}, {{key, "value1"}});
+  EXPECT_EQ(3, WaitForRows(view, 3));
+
+  StatsConfig::SetMaxDeltaTagSets(10000);
+  StatsConfig::SetHarvestInterval(absl::Seconds(5));
+}
+
+}  // namespace
+}  // namespace stats
+}  // namespace opencensus
@@ -15,6 +15,9 @@
 #include "opencensus/stats/stats_exporter.h"
 #include "opencensus/stats/internal/stats_exporter_impl.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <thread>  // NOLINT
 #include <utility>
 #include <vector>
@@ -23,7 +26,9 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/export_worker.h"
 #include "opencensus/stats/internal/aggregation_window.h"
+#include "opencensus/stats/internal/self_stats_impl.h"
 #include "opencensus/stats/view_data.h"
 #include "opencensus/stats/view_descriptor.h"
 
@@ -48,55 +53,108 @@ void StatsExporterImpl::RemoveView(absl::string_view name) {
 }
 
 void StatsExporterImpl::RegisterPushHandler(
-    std::unique_ptr<StatsExporter::Handler> handler) {
+    std::unique_ptr<StatsExporter::Handler> handler,
+    const StatsExporter::HandlerOptions& options) {
   absl::MutexLock l(&mu_);
-  handlers_.push_back(std::move(handler));
+  // The index identifies the handler in self-stats.
+  const int index = workers_.size();
+  std::shared_ptr<StatsExporter::Handler> shared_handler = std::move(handler);
+  common::ExportWorker<ExportSnapshot>::Options worker_options;
+  worker_options.max_queued = options.max_queued_exports;
+  worker_options.drop_oldest =
+      options.overflow_policy ==
+      StatsExporter::HandlerOptions::OverflowPolicy::kSkipOldest;
+  worker_options.deadline = options.deadline;
+  workers_.push_back(absl::make_unique<common::ExportWorker<ExportSnapshot>>(
+      [shared_handler, index](const ExportSnapshot& snapshot) {
+        const absl::Time start = absl::Now();
+        shared_handler->ExportViewData(snapshot.data);
+        SelfStatsImpl::Get()->RecordExport(index, absl::Now() - start);
+      },
+      [index] { SelfStatsImpl::Get()->RecordSkippedExport(index); },
+      worker_options));
   if (!thread_started_) {
     StartExportThread();
   }
 }
 
+void StatsExporterImpl::SetInterval(absl::Duration interval) {
+  // A non-positive interval would make the export thread loop without waiting.
+  if (interval <= absl::ZeroDuration()) return;
+  absl::MutexLock l(&mu_);
+  export_interval_ = interval;
+  interval_changed_ = true;
+}
+
 std::vector<std::pair<ViewDescriptor, ViewData>>
 StatsExporterImpl::GetViewData() {
   absl::ReaderMutexLock l(&mu_);
-  std::vector<std::pair<ViewDescriptor, ViewData>> data;
-  data.reserve(views_.size());
-  for (const auto& view : views_) {
-    data.emplace_back(view.second->descriptor(), view.second->GetData());
-  }
-  return data;
+  return Snapshot();
 }
 
 void StatsExporterImpl::Export() {
   absl::ReaderMutexLock l(&mu_);
+  if (workers_.empty()) return;
+  auto snapshot = std::make_shared<ExportSnapshot>();
+  snapshot->time = absl::Now();
+  snapshot->data = Snapshot();
+  for (auto& worker : workers_) {
+    worker->Enqueue(snapshot, snapshot->time);
+  }
+}
+
+void StatsExporterImpl::WaitForExportsForTesting() {
+  absl::ReaderMutexLock l(&mu_);
+  for (auto& worker : workers_) {
+    worker->WaitUntilIdle();
+  }
+}
+
+std::vector<std::pair<ViewDescriptor, ViewData>>
+StatsExporterImpl::Snapshot() {
   std::vector<std::pair<ViewDescriptor, ViewData>> data;
   data.reserve(views_.size());
   for (const auto& view : views_) {
     data.emplace_back(view.second->descriptor(), view.second->GetData());
   }
-  for (auto& handler : handlers_) {
-    handler->ExportViewData(data);
+  SelfStatsImpl* self_stats = SelfStatsImpl::Get();
+  if (self_stats->enabled()) {
+    int64_t bytes = 0;
+    for (const auto& view : data) {
+      bytes += self_stats->RecordViewSize(view.first.name(), view.second);
+    }
+    self_stats->RecordSnapshotBytes(bytes);
   }
+  return data;
 }
 
 void StatsExporterImpl::ClearHandlersForTesting() {
   absl::MutexLock l(&mu_);
-  handlers_.clear();
+  workers_.clear();
 }
 
 void StatsExporterImpl::StartExportThread() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-  t_ = std::thread(&StatsExporterImpl::RunWorkerLoop, this);
+  t_ = std::thread(&StatsExporterImpl::RunExportLoop, this);
   thread_started_ = true;
 }
 
-void StatsExporterImpl::RunWorkerLoop() {
-  absl::Time next_export_time = absl::Now() + export_interval_;
+void StatsExporterImpl::RunExportLoop() {
+  absl::Time last_export_time = absl::Now();
   while (true) {
-    // SleepFor() returns immediately when given a negative duration.
-    absl::SleepFor(next_export_time - absl::Now());
+    {
+      absl::MutexLock l(&mu_);
+      while (true) {
+        // Recomputed on each wakeup, since the interval may have changed.
+        const absl::Time next_export_time = last_export_time + export_interval_;
+        if (absl::Now() >= next_export_time) break;
+        interval_changed_ = false;
+        mu_.AwaitWithDeadline(absl::Condition(&interval_changed_),
+                              next_export_time);
+      }
+    }
     // In case the last export took longer than the export interval, we
     // calculate the next time from now.
-    next_export_time = absl::Now() + export_interval_;
+    last_export_time = absl::Now();
     Export();
   }
 }
@@ -106,14 +164,27 @@ void StatsExporter::RemoveView(absl::string_view name) {
 }
 
 void StatsExporter::RegisterPushHandler(std::unique_ptr<Handler> handler) {
-  StatsExporterImpl::Get()->RegisterPushHandler(std::move(handler));
+  StatsExporterImpl::Get()->RegisterPushHandler(std::move(handler),
+                                                HandlerOptions());
+}
+
+void StatsExporter::RegisterPushHandler(std::unique_ptr<Handler> handler,
+                                        const HandlerOptions& options) {
+  StatsExporterImpl::Get()->RegisterPushHandler(std::move(handler), options);
+}
+
+void StatsExporter::SetInterval(absl::Duration interval) {
+  StatsExporterImpl::Get()->SetInterval(interval);
 }
 
 std::vector<std::pair<ViewDescriptor, ViewData>> StatsExporter::GetViewData() {
   return StatsExporterImpl::Get()->GetViewData();
 }
 
-void StatsExporter::ExportForTesting() { StatsExporterImpl::Get()->Export(); }
+void StatsExporter::ExportForTesting() {
+  StatsExporterImpl::Get()->Export();
+  StatsExporterImpl::Get()->WaitForExportsForTesting();
+}
 
 void StatsExporter::ClearHandlersForTesting() {
   StatsExporterImpl::Get()->ClearHandlersForTesting();
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <thread>  // NOLINT
 #include <utility>
 #include <vector>
@@ -19,6 +20,7 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/export_worker.h"
 #include "opencensus/stats/internal/aggregation_window.h"
 #include "opencensus/stats/stats_exporter.h"
 #include "opencensus/stats/view_data.h"
@@ -27,6 +29,12 @@
 namespace opencensus {
 namespace stats {
 
+// An immutable snapshot of all exported views, shared between handlers.
+struct ExportSnapshot {
+  absl::Time time;
+  std::vector<std::pair<ViewDescriptor, ViewData>> data;
+};
+
 class StatsExporterImpl {
  public:
   static StatsExporterImpl* Get();
@@ -38,27 +46,41 @@ class StatsExporterImpl {
   // Adds a handler, which cannot be subsequently removed (except by
   // ClearHandlersForTesting()). The background thread is started when the
   // first handler is registered.
-  void RegisterPushHandler(std::unique_ptr<StatsExporter::Handler> handler);
+  void RegisterPushHandler(std::unique_ptr<StatsExporter::Handler> handler,
+                           const StatsExporter::HandlerOptions& options);
+
+  void SetInterval(absl::Duration interval);
 
   std::vector<std::pair<ViewDescriptor, ViewData>> GetViewData();
 
+  // Snapshots all views and queues the snapshot for each handler.
   void Export();
 
+  // Blocks until every handler has processed all queued snapshots.
+  void WaitForExportsForTesting();
+
   void ClearHandlersForTesting();
 
  private:
   StatsExporterImpl() {}
 
+  // Returns a snapshot of all registered views.
+  std::vector<std::pair<ViewDescriptor, ViewData>> Snapshot()
+      SHARED_LOCKS_REQUIRED(mu_);
+
   void StartExportThread() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // Loops forever, calling Export() every export_interval_.
-  void RunWorkerLoop();
-
-  const absl::Duration export_interval_ = absl::Seconds(10);
+  void RunExportLoop();
 
   mutable absl::Mutex mu_;
 
-  std::vector<std::unique_ptr<StatsExporter::Handler>> handlers_
+  absl::Duration export_interval_ GUARDED_BY(mu_) = absl::Seconds(10);
+  // Set when export_interval_ changes, to wake the worker thread.
+  bool interval_changed_ GUARDED_BY(mu_) = false;
+
+  // One per push handler, which it owns.
+  std::vector<std::unique_ptr<common::ExportWorker<ExportSnapshot>>> workers_
       GUARDED_BY(mu_);
   std::unordered_map<std::string, std::unique_ptr<View>> views_ GUARDED_BY(mu_);
 
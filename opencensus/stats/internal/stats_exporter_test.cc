@@ -19,11 +19,13 @@
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "opencensus/stats/internal/set_aggregation_window.h"
+#include "opencensus/stats/internal/stats_exporter_impl.h"
 #include "opencensus/stats/measure.h"
 #include "opencensus/stats/measure_descriptor.h"
 #include "opencensus/stats/view_descriptor.h"
@@ -40,6 +42,13 @@ class MockExporter : public StatsExporter::Handler {
         absl::make_unique<MockExporter>(output));
   }
 
+  static void Register(
+      std::vector<std::pair<ViewDescriptor, ViewData>>* output,
+      const StatsExporter::HandlerOptions& options) {
+    opencensus::stats::StatsExporter::RegisterPushHandler(
+        absl::make_unique<MockExporter>(output), options);
+  }
+
   MockExporter(std::vector<std::pair<ViewDescriptor, ViewData>>* output)
       : output_(output) {}
 
@@ -56,6 +65,40 @@ class MockExporter : public StatsExporter::Handler {
   std::vector<std::pair<ViewDescriptor, ViewData>>* output_;
 };
 
+// An exporter that records the number of views in each export, blocking in
+// each export until released.
+class BlockingExporter : public StatsExporter::Handler {
+ public:
+  void ExportViewData(
+      const std::vector<std::pair<ViewDescriptor, ViewData>>& data) override {
+    absl::MutexLock l(&mu_);
+    started_ = true;
+    mu_.Await(absl::Condition(&released_));
+    export_sizes_.push_back(data.size());
+  }
+
+  void WaitUntilStarted() {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(&started_));
+  }
+
+  void Release() {
+    absl::MutexLock l(&mu_);
+    released_ = true;
+  }
+
+  std::vector<int> export_sizes() {
+    absl::MutexLock l(&mu_);
+    return export_sizes_;
+  }
+
+ private:
+  absl::Mutex mu_;
+  bool started_ GUARDED_BY(mu_) = false;
+  bool released_ GUARDED_BY(mu_) = false;
+  std::vector<int> export_sizes_ GUARDED_BY(mu_);
+};
+
 constexpr char kMeasureId[] = "test_measure_id";
 
 MeasureDouble TestMeasure() {
@@ -78,19 +121,53 @@ class StatsExporterTest : public ::testing::Test {
     descriptor2_.set_measure(kMeasureId);
     descriptor2_.set_aggregation(
         Aggregation::Distribution(BucketBoundaries::Explicit({0})));
+    descriptor3_.set_name("id3");
+    descriptor3_.set_measure(kMeasureId);
+    descriptor3_.set_aggregation(Aggregation::Sum());
   }
 
   void TearDown() {
     StatsExporter::RemoveView(descriptor1_.name());
     StatsExporter::RemoveView(descriptor2_.name());
+    StatsExporter::RemoveView(descriptor3_.name());
     StatsExporter::ClearHandlersForTesting();
   }
 
   static void Export() { StatsExporter::ExportForTesting(); }
 
+  // Queues an export without waiting for handlers.
+  static void ExportAsync() { StatsExporterImpl::Get()->Export(); }
+  static void WaitForExports() {
+    StatsExporterImpl::Get()->WaitForExportsForTesting();
+  }
+
+  // Registers a BlockingExporter, owned by the StatsExporter.
+  static BlockingExporter* RegisterBlockingExporter(
+      const StatsExporter::HandlerOptions& options) {
+    auto exporter = absl::make_unique<BlockingExporter>();
+    BlockingExporter* ptr = exporter.get();
+    StatsExporter::RegisterPushHandler(std::move(exporter), options);
+    return ptr;
+  }
+
+  // Exports 3 snapshots (with 1, 2, and 3 views) to 'exporter', which blocks
+  // in the first, then releases it.
+  void ExportThreeSnapshots(BlockingExporter* exporter) {
+    descriptor1_.RegisterForExport();
+    ExportAsync();
+    exporter->WaitUntilStarted();
+    descriptor2_.RegisterForExport();
+    ExportAsync();
+    descriptor3_.RegisterForExport();
+    ExportAsync();
+    exporter->Release();
+    WaitForExports();
+  }
+
   ViewDescriptor descriptor1_;
   ViewDescriptor descriptor1_edited_;
   ViewDescriptor descriptor2_;
+  ViewDescriptor descriptor3_;
 };
 
 TEST_F(StatsExporterTest, AddView) {
@@ -149,6 +226,67 @@ TEST_F(StatsExporterTest, MultipleExporters) {
               ::testing::UnorderedElementsAre(::testing::Key(descriptor1_)));
 }
 
+TEST_F(StatsExporterTest, SlowExporterDoesNotBlockOthers) {
+  BlockingExporter* blocking_exporter =
+      RegisterBlockingExporter(StatsExporter::HandlerOptions());
+  std::vector<std::pair<ViewDescriptor, ViewData>> exported_data;
+  // Room for both snapshots, in case the first is still queued when the
+  // second arrives.
+  StatsExporter::HandlerOptions options;
+  options.max_queued_exports = 2;
+  MockExporter::Register(&exported_data, options);
+  descriptor1_.RegisterForExport();
+  ExportAsync();
+  blocking_exporter->WaitUntilStarted();
+  // Registering a view must not wait for the blocked export either.
+  descriptor2_.RegisterForExport();
+  ExportAsync();
+  // The blocked exporter has not finished its first export.
+  EXPECT_TRUE(blocking_exporter->export_sizes().empty());
+  blocking_exporter->Release();
+  WaitForExports();
+  EXPECT_THAT(blocking_exporter->export_sizes(), ::testing::ElementsAre(1, 2));
+  EXPECT_THAT(exported_data,
+              ::testing::UnorderedElementsAre(::testing::Key(descriptor1_),
+                                              ::testing::Key(descriptor1_),
+                                              ::testing::Key(descriptor2_)));
+}
+
+TEST_F(StatsExporterTest, OverflowSkipsOldest) {
+  StatsExporter::HandlerOptions options;
+  options.max_queued_exports = 1;
+  options.overflow_policy =
+      StatsExporter::HandlerOptions::OverflowPolicy::kSkipOldest;
+  BlockingExporter* exporter = RegisterBlockingExporter(options);
+  ExportThreeSnapshots(exporter);
+  EXPECT_THAT(exporter->export_sizes(), ::testing::ElementsAre(1, 3));
+}
+
+TEST_F(StatsExporterTest, OverflowSkipsNewest) {
+  StatsExporter::HandlerOptions options;
+  options.max_queued_exports = 1;
+  options.overflow_policy =
+      StatsExporter::HandlerOptions::OverflowPolicy::kSkipNewest;
+  BlockingExporter* exporter = RegisterBlockingExporter(options);
+  ExportThreeSnapshots(exporter);
+  EXPECT_THAT(exporter->export_sizes(), ::testing::ElementsAre(1, 2));
+}
+
+TEST_F(StatsExporterTest, DeadlineSkipsStaleSnapshots) {
+  StatsExporter::HandlerOptions options;
+  options.max_queued_exports = 2;
+  options.deadline = absl::Milliseconds(10);
+  BlockingExporter* exporter = RegisterBlockingExporter(options);
+  descriptor1_.RegisterForExport();
+  ExportAsync();
+  exporter->WaitUntilStarted();
+  ExportAsync();
+  absl::SleepFor(absl::Milliseconds(20));
+  exporter->Release();
+  WaitForExports();
+  EXPECT_THAT(exporter->export_sizes(), ::testing::ElementsAre(1));
+}
+
 TEST_F(StatsExporterTest, IntervalViewRejected) {
   std::vector<std::pair<ViewDescriptor, ViewData>> exported_data;
   MockExporter::Register(&exported_data);
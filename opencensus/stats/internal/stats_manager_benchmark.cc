@@ -18,6 +18,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
 #include "opencensus/stats/aggregation.h"
 #include "opencensus/stats/internal/aggregation_window.h"
 #include "opencensus/stats/internal/set_aggregation_window.h"
@@ -98,6 +99,7 @@ void BM_Record(benchmark::State& state) {
     tag_values[i] = absl::StrCat("value", i);
   }
   int iteration = 0;
+  common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     Record({{measure, static_cast<double>(iteration)}},
            {{tag_key_1, tag_values[iteration % tag_values.size()]},
@@ -161,6 +163,7 @@ void BM_RecordBatched(benchmark::State& state) {
     tag_values[i] = absl::StrCat("value", i);
   }
   int iteration = 0;
+  common::AllocationCounter allocations(&state);
   for (auto _ : state) {
     Record({{measures[0], static_cast<double>(iteration)},
             {measures[1], static_cast<double>(iteration)},
@@ -34,8 +34,11 @@ namespace stats {
 // integral values against MeasureInt64s, to prevent silent loss of precision.
 // If a record call fails to compile, ensure that all types match (using
 // static_cast to double or int64_t if necessary).
+//
+// 'tags' is taken by reference, so a TagSet constructed once (e.g. per RPC
+// method) can be recorded under repeatedly without being copied.
 void Record(std::initializer_list<Measurement> measurements,
-            TagSet tags = TagSet({}));
+            const TagSet& tags = TagSet({}));
 
 }  // namespace stats
 }  // namespace opencensus
@@ -0,0 +1,52 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_STATS_SELF_STATS_H_
+#define OPENCENSUS_STATS_SELF_STATS_H_
+
+namespace opencensus {
+namespace stats {
+
+// SelfStats controls recording of stats about the stats library itself. When
+// enabled, the following measures are recorded and exported through views of
+// the same name (all under "opencensus.io/internal/stats/"):
+//  - harvest_latency (ms): the duration of each harvest of recorded data.
+//  - merge_latency (ms): the time spent merging each harvest into views.
+//  - delta_tag_sets: the number of distinct tag sets in each harvest.
+//  - view_rows (tagged by view): the number of rows in each exported view.
+//  - view_bytes (tagged by view): the estimated memory used by each exported
+//    view.
+//  - export_latency (ms, tagged by handler index): the duration of each push
+//    handler's export.
+//  - skipped_exports (tagged by handler index): the number of snapshots each
+//    push handler skipped because it fell behind.
+//  - snapshot_bytes: the estimated bytes copied when snapshotting all exported
+//    views.
+//
+// These measurements are merged directly into views rather than through the
+// recording path, so they do not affect the data they describe.
+// SelfStats is thread-safe.
+class SelfStats final {
+ public:
+  // Registers the measures and views above and starts recording. Calling this
+  // more than once has no further effect.
+  static void Enable();
+
+  SelfStats() = delete;
+};
+
+}  // namespace stats
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_STATS_SELF_STATS_H_
@@ -23,6 +23,8 @@
 #include "opencensus/stats/measure_descriptor.h"  // IWYU pragma: export
 #include "opencensus/stats/measure_registry.h"    // IWYU pragma: export
 #include "opencensus/stats/recording.h"           // IWYU pragma: export
+#include "opencensus/stats/self_stats.h"          // IWYU pragma: export
+#include "opencensus/stats/stats_config.h"        // IWYU pragma: export
 #include "opencensus/stats/stats_exporter.h"      // IWYU pragma: export
 #include "opencensus/stats/tag_key.h"             // IWYU pragma: export
 #include "opencensus/stats/tag_set.h"             // IWYU pragma: export
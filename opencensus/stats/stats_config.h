@@ -0,0 +1,48 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_STATS_STATS_CONFIG_H_
+#define OPENCENSUS_STATS_STATS_CONFIG_H_
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace opencensus {
+namespace stats {
+
+// StatsConfig controls how often recorded data is harvested into views.
+// Recorded data is buffered, by distinct TagSet, until the next harvest; a
+// shorter interval or a lower tag set limit bounds the buffer's memory use and
+// spreads the cost of harvesting more evenly, at the cost of harvesting more
+// often.
+// StatsConfig is thread-safe.
+class StatsConfig final {
+ public:
+  // Sets the maximum time between harvests. Defaults to 5 seconds.
+  // Non-positive intervals are ignored.
+  static void SetHarvestInterval(absl::Duration interval);
+
+  // Sets the number of distinct TagSets recorded since the last harvest at
+  // which a harvest is started early. 0 disables early harvests. Defaults to
+  // 10000.
+  static void SetMaxDeltaTagSets(int64_t max_tag_sets);
+
+  StatsConfig() = delete;
+};
+
+}  // namespace stats
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_STATS_STATS_CONFIG_H_
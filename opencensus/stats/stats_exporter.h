@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "opencensus/stats/view.h"
 #include "opencensus/stats/view_data.h"
 #include "opencensus/stats/view_descriptor.h"
@@ -49,10 +50,41 @@ class StatsExporter final {
         const std::vector<std::pair<ViewDescriptor, ViewData>>& data) = 0;
   };
 
+  // Options controlling how data is delivered to a push handler. Each handler
+  // runs on its own thread, so a slow handler delays only its own exports.
+  // Data for all views is snapshotted once per export interval and queued for
+  // each handler.
+  struct HandlerOptions {
+    // What to do with a new snapshot when max_queued_exports snapshots are
+    // already waiting for the handler.
+    enum class OverflowPolicy {
+      // Skip the oldest queued snapshot, so that the handler catches up to the
+      // most recent data.
+      kSkipOldest,
+      // Skip the new snapshot, so that the handler exports every snapshot it
+      // has already accepted.
+      kSkipNewest,
+    };
+
+    // The maximum number of snapshots waiting for the handler while it is
+    // exporting.
+    int max_queued_exports = 1;
+    OverflowPolicy overflow_policy = OverflowPolicy::kSkipOldest;
+    // Snapshots that the handler does not start exporting within 'deadline' of
+    // their being taken are skipped.
+    absl::Duration deadline = absl::InfiniteDuration();
+  };
+
   // Registers a new handler. Every few seconds, each registered handler will be
   // called with the present data for each registered view. This should only be
   // called by push exporters' Register() methods.
   static void RegisterPushHandler(std::unique_ptr<Handler> handler);
+  static void RegisterPushHandler(std::unique_ptr<Handler> handler,
+                                  const HandlerOptions& options);
+
+  // Sets the interval between pushes to registered handlers. Defaults to 10
+  // seconds. Non-positive intervals are ignored.
+  static void SetInterval(absl::Duration interval);
 
   // Retrieves current data for all registered views, for implementing pull
   // exporters.
@@ -61,7 +93,8 @@ class StatsExporter final {
  private:
   friend class StatsExporterTest;
 
-  // Forces immediate export of data.
+  // Forces immediate export of data, and blocks until all handlers have
+  // exported it.
   static void ExportForTesting();
   static void ClearHandlersForTesting();
 };
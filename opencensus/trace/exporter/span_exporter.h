@@ -15,9 +15,11 @@
 #ifndef OPENCENSUS_TRACE_EXPORTER_SPAN_EXPORTER_H_
 #define OPENCENSUS_TRACE_EXPORTER_SPAN_EXPORTER_H_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "opencensus/trace/exporter/span_data.h"
 
 namespace opencensus {
@@ -37,8 +39,119 @@ class SpanExporter final {
     virtual void Export(const std::vector<SpanData>& spans) = 0;
   };
 
+  // Options controlling how batches of spans are delivered to a handler. Each
+  // handler runs on its own thread with its own queue, so a slow handler delays
+  // only its own exports.
+  struct HandlerOptions {
+    // What to do with a new batch when max_queued_batches batches are already
+    // waiting for the handler.
+    enum class OverflowPolicy {
+      // Drop the oldest queued batch.
+      kDropOldest,
+      // Drop the new batch.
+      kDropNewest,
+    };
+
+    // The maximum number of batches waiting for the handler while it is
+    // exporting.
+    int max_queued_batches = 4;
+    OverflowPolicy overflow_policy = OverflowPolicy::kDropOldest;
+  };
+
   // This should only be called by Handler's Register() method.
   static void RegisterHandler(std::unique_ptr<Handler> handler);
+  static void RegisterHandler(std::unique_ptr<Handler> handler,
+                              const HandlerOptions& options);
+
+  // Sets the number of threads, including the export thread, that convert
+  // ended spans to SpanData. Large batches are split between them. Defaults to
+  // 1.
+  static void SetConversionThreads(int threads);
+
+  // Ended spans are buffered until the export thread picks them up. The buffer
+  // has a fixed capacity; when it is full, spans are dropped according to the
+  // overflow policy.
+  struct BufferOptions {
+    enum class OverflowPolicy {
+      // Discard the oldest buffered span to make room for the new one.
+      kDropOldest,
+      // Discard the span being ended.
+      kDropNewest,
+    };
+
+    // The maximum number of buffered spans. Rounded up to a power of two.
+    int capacity = 2048;
+    OverflowPolicy overflow_policy = OverflowPolicy::kDropOldest;
+  };
+
+  // Replaces the buffer options. Spans already buffered are still exported.
+  static void SetBufferOptions(const BufferOptions& options);
+
+  // Returns the number of spans dropped because the buffer was full, since the
+  // process started.
+  static uint64_t DroppedSpanCount();
+
+  // Returns the number of batches that handlers dropped because they fell
+  // more than HandlerOptions::max_queued_batches behind, since the process
+  // started. Each batch is counted once per handler that dropped it.
+  static uint64_t DroppedBatchCount();
+
+  // Tail-based sampling decides whether to export a trace after its local
+  // root Span ends, when its latency and status are known. While it is
+  // enabled, Spans that the Sampler does not sample are still recorded, and
+  // when they end they are buffered by TraceId. When the local root Span of a
+  // trace (one with no parent, or a remote parent) ends, the trace's buffered
+  // Spans are exported if:
+  // - the root Span took at least latency_threshold, or
+  // - any of its Spans ended with an error status, or
+  // - a ProbabilitySampler with keep_probability samples the TraceId.
+  // Otherwise they are dropped. Spans that end after the decision follow it.
+  // Exported Spans keep their SpanContext, which is not marked as sampled.
+  // Sampled Spans are exported as usual. Spans recorded only for tail sampling
+  // are not added to the running and local span stores.
+  //
+  // Recording every Span costs more than head sampling alone. Ended Spans are
+  // buffered as SpanData, and the buffer's memory use is bounded by the
+  // options below.
+  struct TailSamplingOptions {
+    absl::Duration latency_threshold = absl::Milliseconds(500);
+    double keep_probability = 0.01;
+
+    // The approximate maximum number of bytes of SpanData buffered while
+    // waiting for local roots to end. When it is exceeded, the oldest pending
+    // traces are dropped.
+    int64_t max_buffered_bytes = 8 << 20;
+    // The maximum number of traces tracked, including recently decided ones.
+    // When it is exceeded, the oldest are forgotten.
+    int max_traces = 4096;
+    // Further Spans of a pending trace are dropped.
+    int max_spans_per_trace = 256;
+    // Traces are forgotten this long after their first Span ended. Pending
+    // traces, whose local root never ended here, are dropped. Expired traces
+    // are swept about once a second while Spans are ending.
+    absl::Duration trace_timeout = absl::Seconds(30);
+  };
+
+  // Enables tail-based sampling with the given options, or updates them.
+  static void EnableTailSampling(const TailSamplingOptions& options);
+
+  // Stops recording unsampled Spans. Buffered traces are discarded; pending
+  // ones are counted as evicted. Unsampled Spans that end afterwards are
+  // dropped.
+  static void DisableTailSampling();
+
+  // Tail sampling counts, since the process started.
+  struct TailSamplingStats {
+    // Traces exported or dropped when their local root ended.
+    uint64_t kept_traces = 0;
+    uint64_t dropped_traces = 0;
+    // Pending traces dropped because of the memory limits or the timeout.
+    uint64_t evicted_traces = 0;
+    // Spans dropped because their trace had max_spans_per_trace Spans.
+    uint64_t dropped_spans = 0;
+  };
+
+  static TailSamplingStats GetTailSamplingStats();
 
  private:
   friend class SpanExporterTestPeer;
@@ -14,6 +14,8 @@
 
 #include "opencensus/trace/internal/attribute_list.h"
 
+#include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "absl/strings/string_view.h"
@@ -31,25 +33,62 @@ uint32_t AttributeList::num_attributes_added() const {
 
 void AttributeList::AddAttribute(absl::string_view key,
                                  exporter::AttributeValue&& value) {
+  Add(key, std::move(value), /*evict=*/true);
+}
+
+void AttributeList::AddAttributeIfRoom(absl::string_view key,
+                                       exporter::AttributeValue&& value) {
+  Add(key, std::move(value), /*evict=*/false);
+}
+
+void AttributeList::Add(absl::string_view key,
+                        exporter::AttributeValue&& value, bool evict) {
   // Blank span has 0 max attributes.
   if (max_attributes_ == 0) {
     return;
   }
 
-  std::string key_string(key);
-  auto it = attributes_.find(key_string);
-  if (it != attributes_.end()) {
-    it->second = std::move(value);
-    return;
+  // Keys are compared by value so that updates need not intern the key.
+  for (auto& attribute : attributes_) {
+    if (attribute.first.view() == key) {
+      attribute.second = std::move(value);
+      return;
+    }
   }
 
+  total_recorded_attributes_++;
   if (attributes_.size() >= max_attributes_) {
-    // TODO: This should be changed to a LRU mechanism.  Just remove
-    // first element for now.
+    // Counted as dropped.
+    if (!evict) return;
     attributes_.erase(attributes_.begin());
   }
-  attributes_.insert({key_string, std::move(value)});
-  total_recorded_attributes_++;
+  attributes_.emplace_back(
+      common::InternedString(key,
+                             common::StringInterner::Table::kAttributeKeys),
+      std::move(value));
+}
+
+std::unordered_map<std::string, exporter::AttributeValue>
+AttributeList::CopyAttributes() const {
+  std::unordered_map<std::string, exporter::AttributeValue> attributes(
+      attributes_.size());
+  for (const auto& attribute : attributes_) {
+    attributes.emplace(std::string(attribute.first.view()), attribute.second);
+  }
+  return attributes;
+}
+
+std::unordered_map<std::string, exporter::AttributeValue>
+AttributeList::TakeAttributes() {
+  total_recorded_attributes_ -= attributes_.size();
+  std::unordered_map<std::string, exporter::AttributeValue> attributes(
+      attributes_.size());
+  for (auto& attribute : attributes_) {
+    attributes.emplace(std::string(attribute.first.view()),
+                       std::move(attribute.second));
+  }
+  attributes_.clear();
+  return attributes;
 }
 
 }  // namespace trace
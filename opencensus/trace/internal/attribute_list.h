@@ -18,16 +18,22 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/strings/string_view.h"
+#include "opencensus/common/internal/string_interner.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 
 namespace opencensus {
 namespace trace {
 
-// Stores a list of AttributesValues that are recorded within a span. The
-// AttributeValues are stored in an unordered fashion and accessed with a
-// string key. AttributeList is thread-compatible.
+// Stores a list of AttributesValues that are recorded within a span, accessed
+// with a string key. AttributeList is thread-compatible.
+//
+// Spans have few attributes, so they are stored in insertion order in a flat
+// vector, the first few inline, and looked up by linear search. Keys are
+// interned, so they are compared by address and not copied per span.
 class AttributeList final {
  public:
   explicit AttributeList(uint32_t max_attributes = 0)
@@ -40,21 +46,36 @@ class AttributeList final {
   uint32_t num_attributes_added() const;
 
   // Adds an AttributeValue to the list or updates an existing AttributeValue.
-  // If max_attributes_ is exceeded, it will evict one of the previous
-  // AttributeValues.
+  // If max_attributes_ is exceeded, the oldest attribute is evicted.
   void AddAttribute(absl::string_view key, exporter::AttributeValue&& value);
 
+  // Like AddAttribute(), but if max_attributes_ is reached and the key is new,
+  // drops the new attribute instead of evicting one.
+  void AddAttributeIfRoom(absl::string_view key,
+                          exporter::AttributeValue&& value);
+
   // Returns an unordered map of all the attributes that are currently contained
   // within the list.
-  const std::unordered_map<std::string, exporter::AttributeValue>& attributes()
-      const {
-    return attributes_;
-  }
+  std::unordered_map<std::string, exporter::AttributeValue> CopyAttributes()
+      const;
+
+  // Moves all the attributes out of the list, leaving it empty.
+  // num_attributes_dropped() is unchanged.
+  std::unordered_map<std::string, exporter::AttributeValue> TakeAttributes();
 
  private:
+  void Add(absl::string_view key, exporter::AttributeValue&& value,
+           bool evict);
+
+  // The number of attributes stored without a heap allocation.
+  static constexpr int kInlineAttributes = 4;
+
   uint32_t total_recorded_attributes_;
   const uint32_t max_attributes_;
-  std::unordered_map<std::string, exporter::AttributeValue> attributes_;
+  absl::InlinedVector<
+      std::pair<common::InternedString, exporter::AttributeValue>,
+      kInlineAttributes>
+      attributes_;
 };
 
 }  // namespace trace
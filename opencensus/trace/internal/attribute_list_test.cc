@@ -0,0 +1,109 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/internal/attribute_list.h"
+
+#include <cstdint>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+#include "opencensus/common/internal/string_interner.h"
+#include "opencensus/trace/attribute_value_ref.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+exporter::AttributeValue Value(int64_t value) {
+  return exporter::AttributeValue(AttributeValueRef(value));
+}
+
+TEST(AttributeListTest, LastValueWins) {
+  AttributeList list(10);
+  list.AddAttribute("key", Value(1));
+  list.AddAttribute("other_key", Value(2));
+  list.AddAttribute("key", Value(3));
+  const auto attributes = list.CopyAttributes();
+  EXPECT_EQ(2, attributes.size());
+  EXPECT_EQ(3, attributes.at("key").int_value());
+  EXPECT_EQ(2, attributes.at("other_key").int_value());
+  EXPECT_EQ(0, list.num_attributes_dropped());
+}
+
+TEST(AttributeListTest, EvictsOldestAttributes) {
+  AttributeList list(3);
+  for (int i = 0; i < 10; ++i) {
+    list.AddAttribute(absl::StrCat("key", i), Value(i));
+  }
+  const auto attributes = list.CopyAttributes();
+  EXPECT_EQ(3, attributes.size());
+  EXPECT_EQ(7, attributes.at("key7").int_value());
+  EXPECT_EQ(8, attributes.at("key8").int_value());
+  EXPECT_EQ(9, attributes.at("key9").int_value());
+  EXPECT_EQ(7, list.num_attributes_dropped());
+  EXPECT_EQ(10, list.num_attributes_added());
+}
+
+TEST(AttributeListTest, AddAttributeIfRoomDoesNotEvict) {
+  AttributeList list(2);
+  list.AddAttribute("key0", Value(0));
+  list.AddAttribute("key1", Value(1));
+  list.AddAttributeIfRoom("key2", Value(2));
+  list.AddAttributeIfRoom("key1", Value(3));
+  const auto attributes = list.CopyAttributes();
+  EXPECT_EQ(2, attributes.size());
+  EXPECT_EQ(0, attributes.at("key0").int_value());
+  EXPECT_EQ(3, attributes.at("key1").int_value());
+  EXPECT_EQ(1, list.num_attributes_dropped());
+  EXPECT_EQ(3, list.num_attributes_added());
+}
+
+TEST(AttributeListTest, TakeAttributes) {
+  AttributeList list(2);
+  for (int i = 0; i < 3; ++i) {
+    list.AddAttribute(absl::StrCat("key", i), Value(i));
+  }
+  const auto attributes = list.TakeAttributes();
+  EXPECT_EQ(2, attributes.size());
+  EXPECT_TRUE(list.CopyAttributes().empty());
+  EXPECT_EQ(1, list.num_attributes_dropped());
+}
+
+TEST(AttributeListTest, InternsOnlyInsertedKeys) {
+  AttributeList list(1);
+  list.AddAttribute("attribute_list_test_key", Value(0));
+  list.AddAttributeIfRoom("attribute_list_test_dropped_key", Value(1));
+  EXPECT_NE(nullptr, common::StringInterner::Find(
+                         "attribute_list_test_key",
+                         common::StringInterner::Table::kAttributeKeys)
+                         .data());
+  // Attribute keys do not fill the table that span names use.
+  EXPECT_EQ(nullptr,
+            common::StringInterner::Find("attribute_list_test_key").data());
+  EXPECT_EQ(nullptr, common::StringInterner::Find(
+                         "attribute_list_test_dropped_key",
+                         common::StringInterner::Table::kAttributeKeys)
+                         .data());
+}
+
+TEST(AttributeListTest, ZeroMaxAttributes) {
+  AttributeList list(0);
+  list.AddAttribute("key", Value(1));
+  EXPECT_TRUE(list.CopyAttributes().empty());
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
 #include "opencensus/trace/attribute_value_ref.h"
 
 namespace opencensus {
@@ -20,6 +21,7 @@ namespace trace {
 namespace {
 
 void BM_ConstructFromLiteral(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     benchmark::DoNotOptimize(
         AttributeValueRef("literal string, showing no string copy happens"));
@@ -29,6 +31,7 @@ BENCHMARK(BM_ConstructFromLiteral);
 
 void BM_ConstructFromString(benchmark::State& state) {
   std::string s(8192, 'a');
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     benchmark::DoNotOptimize(AttributeValueRef(s));
   }
@@ -0,0 +1,164 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/propagation/b3.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/internal/hex.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+#include "opencensus/trace/trace_options.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+namespace {
+
+constexpr uint8_t kSampledFlag = 0x01;
+
+// Decodes a 16 or 32 char TraceId into buf.
+bool DecodeTraceId(absl::string_view hex, uint8_t* buf) {
+  if (hex.size() == 2 * TraceId::kSize) {
+    return DecodeHex(hex.data(), TraceId::kSize, buf);
+  }
+  if (hex.size() == TraceId::kSize) {
+    // A 64-bit TraceId is the low half of a 128-bit one.
+    memset(buf, 0, TraceId::kSize / 2);
+    return DecodeHex(hex.data(), TraceId::kSize / 2, buf + TraceId::kSize / 2);
+  }
+  return false;
+}
+
+bool DecodeSpanId(absl::string_view hex, uint8_t* buf) {
+  return hex.size() == 2 * SpanId::kSize &&
+         DecodeHex(hex.data(), SpanId::kSize, buf);
+}
+
+SpanContext MakeSpanContext(const uint8_t* trace_id, const uint8_t* span_id,
+                            bool sampled) {
+  const uint8_t options = sampled ? kSampledFlag : 0;
+  return SpanContext(TraceId(trace_id), SpanId(span_id),
+                     TraceOptions(&options));
+}
+
+}  // namespace
+
+SpanContext FromB3Headers(absl::string_view b3_trace_id,
+                          absl::string_view b3_span_id,
+                          absl::string_view b3_sampled,
+                          absl::string_view b3_flags) {
+  uint8_t trace_id[TraceId::kSize];
+  uint8_t span_id[SpanId::kSize];
+  if (!DecodeTraceId(b3_trace_id, trace_id) ||
+      !DecodeSpanId(b3_span_id, span_id)) {
+    return SpanContext();
+  }
+  bool sampled;
+  if (b3_sampled == "1" || b3_sampled == "true") {
+    sampled = true;
+  } else if (b3_sampled.empty() || b3_sampled == "0" ||
+             b3_sampled == "false") {
+    sampled = false;
+  } else {
+    return SpanContext();
+  }
+  if (b3_flags == "1") {
+    sampled = true;
+  } else if (!b3_flags.empty() && b3_flags != "0") {
+    return SpanContext();
+  }
+  return MakeSpanContext(trace_id, span_id, sampled);
+}
+
+void ToB3TraceIdHeader(const SpanContext& ctx, char* out) {
+  uint8_t trace_id[TraceId::kSize];
+  ctx.trace_id().CopyTo(trace_id);
+  EncodeHex(trace_id, TraceId::kSize, out);
+}
+
+std::string ToB3TraceIdHeader(const SpanContext& ctx) {
+  char buf[kB3TraceIdHeaderLen];
+  ToB3TraceIdHeader(ctx, buf);
+  return std::string(buf, kB3TraceIdHeaderLen);
+}
+
+void ToB3SpanIdHeader(const SpanContext& ctx, char* out) {
+  uint8_t span_id[SpanId::kSize];
+  ctx.span_id().CopyTo(span_id);
+  EncodeHex(span_id, SpanId::kSize, out);
+}
+
+std::string ToB3SpanIdHeader(const SpanContext& ctx) {
+  char buf[kB3SpanIdHeaderLen];
+  ToB3SpanIdHeader(ctx, buf);
+  return std::string(buf, kB3SpanIdHeaderLen);
+}
+
+absl::string_view ToB3SampledHeader(const SpanContext& ctx) {
+  return ctx.trace_options().IsSampled() ? "1" : "0";
+}
+
+SpanContext FromB3SingleHeader(absl::string_view header) {
+  const size_t dash = header.find('-');
+  if (dash == absl::string_view::npos) return SpanContext();
+  uint8_t trace_id[TraceId::kSize];
+  if (!DecodeTraceId(header.substr(0, dash), trace_id)) return SpanContext();
+  header.remove_prefix(dash + 1);
+
+  const size_t span_id_end = header.find('-');
+  uint8_t span_id[SpanId::kSize];
+  if (!DecodeSpanId(header.substr(0, span_id_end), span_id)) {
+    return SpanContext();
+  }
+  if (span_id_end == absl::string_view::npos) {
+    return MakeSpanContext(trace_id, span_id, false);
+  }
+  header.remove_prefix(span_id_end + 1);
+
+  const size_t sampled_end = header.find('-');
+  const absl::string_view sampled = header.substr(0, sampled_end);
+  if (sampled != "0" && sampled != "1" && sampled != "d") {
+    return SpanContext();
+  }
+  if (sampled_end != absl::string_view::npos) {
+    uint8_t parent_span_id[SpanId::kSize];
+    if (!DecodeSpanId(header.substr(sampled_end + 1), parent_span_id)) {
+      return SpanContext();
+    }
+  }
+  return MakeSpanContext(trace_id, span_id, sampled != "0");
+}
+
+void ToB3SingleHeader(const SpanContext& ctx, char* out) {
+  ToB3TraceIdHeader(ctx, out);
+  out[kB3TraceIdHeaderLen] = '-';
+  ToB3SpanIdHeader(ctx, out + kB3TraceIdHeaderLen + 1);
+  out[kB3SingleHeaderLen - 2] = '-';
+  out[kB3SingleHeaderLen - 1] = ctx.trace_options().IsSampled() ? '1' : '0';
+}
+
+std::string ToB3SingleHeader(const SpanContext& ctx) {
+  char buf[kB3SingleHeaderLen];
+  ToB3SingleHeader(ctx, buf);
+  return std::string(buf, kB3SingleHeaderLen);
+}
+
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
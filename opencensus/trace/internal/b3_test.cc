@@ -0,0 +1,123 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/propagation/b3.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+namespace {
+
+constexpr char kTraceId[] = "463ac35c9f6413ad48485a3953bb6124";
+constexpr char kSpanId[] = "a2fb4a1d1a96d312";
+
+TEST(B3Test, ParseHeaders) {
+  SpanContext ctx = FromB3Headers(kTraceId, kSpanId, "1", "");
+  EXPECT_TRUE(ctx.IsValid());
+  EXPECT_EQ(kTraceId, ctx.trace_id().ToHex());
+  EXPECT_EQ(kSpanId, ctx.span_id().ToHex());
+  EXPECT_TRUE(ctx.trace_options().IsSampled());
+}
+
+TEST(B3Test, ParseSampled) {
+  EXPECT_TRUE(FromB3Headers(kTraceId, kSpanId, "true", "")
+                  .trace_options()
+                  .IsSampled());
+  EXPECT_FALSE(
+      FromB3Headers(kTraceId, kSpanId, "0", "").trace_options().IsSampled());
+  EXPECT_FALSE(
+      FromB3Headers(kTraceId, kSpanId, "", "").trace_options().IsSampled());
+  // Debug implies sampled.
+  EXPECT_TRUE(
+      FromB3Headers(kTraceId, kSpanId, "", "1").trace_options().IsSampled());
+}
+
+TEST(B3Test, Parse64BitTraceId) {
+  SpanContext ctx = FromB3Headers("48485a3953bb6124", kSpanId, "1", "");
+  EXPECT_TRUE(ctx.IsValid());
+  EXPECT_EQ("000000000000000048485a3953bb6124", ctx.trace_id().ToHex());
+}
+
+TEST(B3Test, MalformedHeaders) {
+  EXPECT_FALSE(FromB3Headers("", kSpanId, "1", "").IsValid());
+  EXPECT_FALSE(FromB3Headers("463ac35c9f6413ad48485a3953bb612", kSpanId, "1",
+                             "")
+                   .IsValid());
+  EXPECT_FALSE(FromB3Headers(kTraceId, "a2fb4a1d1a96d31", "1", "").IsValid());
+  EXPECT_FALSE(FromB3Headers(kTraceId, "a2fb4a1d1a96d31z", "1", "").IsValid());
+  EXPECT_FALSE(FromB3Headers(kTraceId, kSpanId, "yes", "").IsValid());
+  EXPECT_FALSE(FromB3Headers(kTraceId, kSpanId, "1", "2").IsValid());
+}
+
+TEST(B3Test, SerializeHeaders) {
+  SpanContext ctx = FromB3Headers(kTraceId, kSpanId, "1", "");
+  EXPECT_EQ(kTraceId, ToB3TraceIdHeader(ctx));
+  EXPECT_EQ(kSpanId, ToB3SpanIdHeader(ctx));
+  EXPECT_EQ("1", ToB3SampledHeader(ctx));
+  char trace_id[kB3TraceIdHeaderLen];
+  ToB3TraceIdHeader(ctx, trace_id);
+  EXPECT_EQ(kTraceId, absl::string_view(trace_id, sizeof(trace_id)));
+  EXPECT_EQ("0", ToB3SampledHeader(FromB3Headers(kTraceId, kSpanId, "0", "")));
+}
+
+TEST(B3Test, ParseSingleHeader) {
+  const std::string header = std::string(kTraceId) + "-" + kSpanId;
+  SpanContext ctx = FromB3SingleHeader(header + "-1-05e3ac9a4f6e3b90");
+  EXPECT_TRUE(ctx.IsValid());
+  EXPECT_EQ(kTraceId, ctx.trace_id().ToHex());
+  EXPECT_EQ(kSpanId, ctx.span_id().ToHex());
+  EXPECT_TRUE(ctx.trace_options().IsSampled());
+
+  EXPECT_TRUE(FromB3SingleHeader(header).IsValid());
+  EXPECT_FALSE(FromB3SingleHeader(header).trace_options().IsSampled());
+  EXPECT_FALSE(FromB3SingleHeader(header + "-0").trace_options().IsSampled());
+  EXPECT_TRUE(FromB3SingleHeader(header + "-d").trace_options().IsSampled());
+}
+
+TEST(B3Test, MalformedSingleHeader) {
+  const std::string header = std::string(kTraceId) + "-" + kSpanId;
+  const std::vector<std::string> headers = {
+      "",
+      "1",
+      kTraceId,
+      header + "-",
+      header + "-2",
+      header + "-1-",
+      header + "-1-05e3ac9a4f6e3b9",
+      std::string(kTraceId) + "-" + kSpanId + "0",
+  };
+  for (const auto& h : headers) {
+    EXPECT_FALSE(FromB3SingleHeader(h).IsValid()) << h;
+  }
+}
+
+TEST(B3Test, SingleHeaderRoundTrip) {
+  const std::string header = std::string(kTraceId) + "-" + kSpanId + "-1";
+  EXPECT_EQ(header, ToB3SingleHeader(FromB3SingleHeader(header)));
+  char buf[kB3SingleHeaderLen];
+  ToB3SingleHeader(FromB3SingleHeader(header), buf);
+  EXPECT_EQ(header, absl::string_view(buf, sizeof(buf)));
+}
+
+}  // namespace
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
@@ -15,20 +15,21 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_EVENT_WITH_TIME_H_
 #define OPENCENSUS_TRACE_INTERNAL_EVENT_WITH_TIME_H_
 
-#include "absl/time/time.h"
+#include <cstdint>
+#include <utility>
 
 namespace opencensus {
 namespace trace {
 
-// Event with a timestamp.
+// Event with a timestamp, in common::TscClock ticks.
 template <typename T>
 struct EventWithTime {
-  EventWithTime(absl::Time record_time, const T& record_event)
-      : time(record_time), event(record_event) {}
-  EventWithTime(absl::Time record_time, T&& record_event)
-      : time(record_time), event(std::move(record_event)) {}
+  EventWithTime(int64_t record_ticks, const T& record_event)
+      : ticks(record_ticks), event(record_event) {}
+  EventWithTime(int64_t record_ticks, T&& record_event)
+      : ticks(record_ticks), event(std::move(record_event)) {}
 
-  absl::Time time;
+  int64_t ticks;
   T event;
 };
 
@@ -0,0 +1,77 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/propagation/grpc_trace_bin.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+#include "opencensus/trace/trace_options.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+namespace {
+
+constexpr uint8_t kVersionId = 0;
+constexpr uint8_t kTraceIdField = 0;
+constexpr uint8_t kSpanIdField = 1;
+constexpr uint8_t kTraceOptionsField = 2;
+
+// Offsets of the field ids; each field's value follows its id.
+constexpr size_t kTraceIdOffset = 1;
+constexpr size_t kSpanIdOffset = kTraceIdOffset + 1 + TraceId::kSize;
+constexpr size_t kTraceOptionsOffset = kSpanIdOffset + 1 + SpanId::kSize;
+static_assert(kTraceOptionsOffset + 1 + TraceOptions::kSize ==
+                  kGrpcTraceBinHeaderLen,
+              "Unexpected grpc-trace-bin layout.");
+
+}  // namespace
+
+SpanContext FromGrpcTraceBinHeader(absl::string_view header) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(header.data());
+  if (header.size() < kGrpcTraceBinHeaderLen || p[0] != kVersionId ||
+      p[kTraceIdOffset] != kTraceIdField || p[kSpanIdOffset] != kSpanIdField ||
+      p[kTraceOptionsOffset] != kTraceOptionsField) {
+    return SpanContext();
+  }
+  return SpanContext(TraceId(p + kTraceIdOffset + 1),
+                     SpanId(p + kSpanIdOffset + 1),
+                     TraceOptions(p + kTraceOptionsOffset + 1));
+}
+
+void ToGrpcTraceBinHeader(const SpanContext& ctx, uint8_t* out) {
+  out[0] = kVersionId;
+  out[kTraceIdOffset] = kTraceIdField;
+  ctx.trace_id().CopyTo(out + kTraceIdOffset + 1);
+  out[kSpanIdOffset] = kSpanIdField;
+  ctx.span_id().CopyTo(out + kSpanIdOffset + 1);
+  out[kTraceOptionsOffset] = kTraceOptionsField;
+  ctx.trace_options().CopyTo(out + kTraceOptionsOffset + 1);
+}
+
+std::string ToGrpcTraceBinHeader(const SpanContext& ctx) {
+  uint8_t buf[kGrpcTraceBinHeaderLen];
+  ToGrpcTraceBinHeader(ctx, buf);
+  return std::string(reinterpret_cast<const char*>(buf),
+                     kGrpcTraceBinHeaderLen);
+}
+
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
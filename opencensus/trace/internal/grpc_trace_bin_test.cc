@@ -0,0 +1,81 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/propagation/grpc_trace_bin.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+namespace {
+
+constexpr uint8_t kHeader[] = {
+    0,                                               // version_id
+    0,                                               // trace_id field
+    64, 65, 66, 67, 68, 69, 70, 71,                  // trace_id
+    72, 73, 74, 75, 76, 77, 78, 79,                  //
+    1,                                               // span_id field
+    97, 98, 99, 100, 101, 102, 103, 104,             // span_id
+    2,                                               // trace_options field
+    1,                                               // trace_options
+};
+static_assert(sizeof(kHeader) == kGrpcTraceBinHeaderLen, "Wrong length.");
+
+absl::string_view Header() {
+  return absl::string_view(reinterpret_cast<const char*>(kHeader),
+                           sizeof(kHeader));
+}
+
+TEST(GrpcTraceBinTest, Parse) {
+  SpanContext ctx = FromGrpcTraceBinHeader(Header());
+  EXPECT_TRUE(ctx.IsValid());
+  EXPECT_EQ("404142434445464748494a4b4c4d4e4f", ctx.trace_id().ToHex());
+  EXPECT_EQ("6162636465666768", ctx.span_id().ToHex());
+  EXPECT_TRUE(ctx.trace_options().IsSampled());
+}
+
+TEST(GrpcTraceBinTest, RoundTrip) {
+  EXPECT_EQ(Header(), ToGrpcTraceBinHeader(FromGrpcTraceBinHeader(Header())));
+  uint8_t buf[kGrpcTraceBinHeaderLen];
+  ToGrpcTraceBinHeader(FromGrpcTraceBinHeader(Header()), buf);
+  EXPECT_EQ(Header(),
+            absl::string_view(reinterpret_cast<const char*>(buf), sizeof(buf)));
+}
+
+TEST(GrpcTraceBinTest, IgnoresTrailingBytes) {
+  const std::string header = std::string(Header()) + "more";
+  EXPECT_TRUE(FromGrpcTraceBinHeader(header).IsValid());
+}
+
+TEST(GrpcTraceBinTest, Malformed) {
+  EXPECT_FALSE(FromGrpcTraceBinHeader("").IsValid());
+  EXPECT_FALSE(FromGrpcTraceBinHeader(Header().substr(0, 28)).IsValid());
+  // Each of the version and field ids.
+  for (size_t i : {0, 1, 18, 27}) {
+    std::string header(Header());
+    header[i] = 9;
+    EXPECT_FALSE(FromGrpcTraceBinHeader(header).IsValid()) << i;
+  }
+}
+
+}  // namespace
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
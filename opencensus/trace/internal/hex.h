@@ -0,0 +1,56 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_HEX_H_
+#define OPENCENSUS_TRACE_INTERNAL_HEX_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+
+// The value of each char as a lowercase hex digit, or -1.
+extern const int8_t kHexDigitValue[256];
+
+// Decodes 2 * n lowercase hex chars from hex into n bytes at out. Returns
+// false if any char is not a lowercase hex digit, in which case out is
+// partially written. Decoding is table-driven and does not branch per char.
+inline bool DecodeHex(const char* hex, size_t n, uint8_t* out) {
+  int8_t invalid = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const int8_t hi = kHexDigitValue[static_cast<uint8_t>(hex[2 * i])];
+    const int8_t lo = kHexDigitValue[static_cast<uint8_t>(hex[2 * i + 1])];
+    // Invalid digits are negative, so they set the sign bit.
+    invalid |= hi | lo;
+    out[i] = static_cast<uint8_t>((static_cast<uint8_t>(hi) << 4) | lo);
+  }
+  return invalid >= 0;
+}
+
+// Encodes n bytes from in as 2 * n lowercase hex chars at out.
+inline void EncodeHex(const uint8_t* in, size_t n, char* out) {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  for (size_t i = 0; i < n; ++i) {
+    out[2 * i] = kDigits[in[i] >> 4];
+    out[2 * i + 1] = kDigits[in[i] & 0xf];
+  }
+}
+
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_HEX_H_
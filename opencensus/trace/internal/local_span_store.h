@@ -34,7 +34,9 @@ namespace exporter {
 // LocalSpanStore allows users to access in-process information about Spans that
 // have completed (called End()) and were recording events.
 //
-// The LocalSpanStore has a bounded size and evicts Spans when needed.
+// The LocalSpanStore has a bounded size and evicts Spans when needed. Samples
+// are kept for up to 1000 span names; Spans with further names are sampled
+// together under the span name "other".
 //
 // This class is thread-safe.
 class LocalSpanStore {
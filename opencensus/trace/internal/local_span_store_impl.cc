@@ -14,9 +14,9 @@
 
 #include "opencensus/trace/internal/local_span_store_impl.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <queue>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -24,22 +24,30 @@
 
 #include "absl/base/internal/endian.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/tsc_clock.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/exporter/status.h"
 #include "opencensus/trace/internal/span_impl.h"
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
 
 namespace opencensus {
 namespace trace {
 namespace exporter {
 
+constexpr size_t LocalSpanStoreImpl::kMaxSpanNames;
+constexpr char LocalSpanStoreImpl::kOtherSpanName[];
+
 namespace {
-constexpr int kMaxSpans = 128;
+
+// Each bucket admits at most one span per kTimeBetweenSamples.
+constexpr absl::Duration kTimeBetweenSamples = absl::Seconds(1);
 
 using ErrorFilter = LocalSpanStore::ErrorFilter;
 using LatencyBucketBoundary = LocalSpanStore::LatencyBucketBoundary;
@@ -47,16 +55,6 @@ using LatencyFilter = LocalSpanStore::LatencyFilter;
 using PerSpanNameSummary = LocalSpanStore::PerSpanNameSummary;
 using Summary = LocalSpanStore::Summary;
 
-// Returns a reference to the requested PerSpanNameSummary. If necessary, adds
-// it first.
-PerSpanNameSummary& GetPerSpanNameSummary(absl::string_view span_name,
-                                          LocalSpanStore::Summary* summary) {
-  const std::string name = std::string(span_name);
-  return summary->per_span_name_summary
-      .insert({name, LocalSpanStore::PerSpanNameSummary()})
-      .first->second;
-}
-
 // Returns the LatencyBucketBoundary corresponding to the given latency.
 LatencyBucketBoundary GetLatencyBucketBoundary(absl::Duration latency) {
   if (latency < absl::Microseconds(10))
@@ -75,86 +73,237 @@ LatencyBucketBoundary GetLatencyBucketBoundary(absl::Duration latency) {
   return LatencyBucketBoundary::k100s_plus;
 }
 
-// Increment the counter corresponding to the given key. Sets it to 1 if the key
-// wasn't present before.
-template <typename Key, typename Hash>
-void MapIncrement(const Key& key, std::unordered_map<Key, int, Hash>* map) {
-  auto iter_inserted = map->insert({key, 1});
-  if (!iter_inserted.second) {
-    // Was not inserted: needs to be incremented instead.
-    ++iter_inserted.first->second;
+// Returns the lower bound of the LatencyBucketBoundary 'bucket'.
+absl::Duration GetLatencyBucketLowerBound(int bucket) {
+  absl::Duration bound = absl::ZeroDuration();
+  if (bucket > 0) {
+    bound = absl::Microseconds(10);
+    for (int i = 1; i < bucket; ++i) bound *= 10;
   }
+  return bound;
+}
+
+// Returns the index into error_buckets for the non-OK 'code'.
+int GetErrorBucket(StatusCode code) {
+  // Codes outside the canonical range are treated as UNKNOWN.
+  if (code > StatusCode::UNAUTHENTICATED) code = StatusCode::UNKNOWN;
+  return code - 1;
+}
+
+bool MatchesLatency(absl::Duration latency, const LatencyFilter& filter) {
+  const uint64_t latency_ns = latency / absl::Nanoseconds(1);
+  return latency_ns >= filter.lower_latency_ns &&
+         latency_ns < filter.upper_latency_ns;
 }
 
 }  // namespace
 
+// static
+std::vector<SpanData> LocalSpanStoreImpl::ConvertSpans(
+    const std::vector<std::shared_ptr<SpanImpl>>& spans) {
+  std::vector<SpanData> out;
+  out.reserve(spans.size());
+  for (const auto& span : spans) {
+    out.emplace_back(span->ToSpanData());
+  }
+  return out;
+}
+
+void LocalSpanStoreImpl::Bucket::ConsiderForSampling(Sample sample,
+                                                     absl::Time end_time) {
+  if (end_time - last_sampled_ < kTimeBetweenSamples) return;
+  last_sampled_ = end_time;
+  if (samples_.size() < capacity_) {
+    samples_.push_back(std::move(sample));
+  } else {
+    samples_[next_] = std::move(sample);
+    next_ = (next_ + 1) % capacity_;
+  }
+}
+
+void LocalSpanStoreImpl::Bucket::clear() {
+  samples_.clear();
+  next_ = 0;
+  last_sampled_ = absl::InfinitePast();
+}
+
+LocalSpanStoreImpl::PerNameSamples::PerNameSamples(absl::string_view name)
+    : name(name),
+      latency_buckets(kNumLatencyBuckets, Bucket(kLatencySamplesPerBucket)),
+      error_buckets(kNumErrorBuckets, Bucket(kErrorSamplesPerBucket)) {}
+
 LocalSpanStoreImpl* LocalSpanStoreImpl::Get() {
   static LocalSpanStoreImpl* global_running_span_store = new LocalSpanStoreImpl;
   return global_running_span_store;
 }
 
-void LocalSpanStoreImpl::AddSpan(const std::shared_ptr<SpanImpl>& span) {
+LocalSpanStoreImpl::PerNameSamples* LocalSpanStoreImpl::GetOrAddPerNameSamples(
+    absl::string_view name) {
+  {
+    absl::ReaderMutexLock l(&mu_);
+    auto it = samples_by_name_.find(name);
+    if (it != samples_by_name_.end()) return it->second.get();
+    if (other_samples_ != nullptr) return other_samples_;
+  }
   absl::MutexLock l(&mu_);
-  if (spans_.size() >= kMaxSpans) {
-    spans_.pop_back();  // Make room.
+  auto it = samples_by_name_.find(name);
+  if (it != samples_by_name_.end()) return it->second.get();
+  if (samples_by_name_.size() < kMaxSpanNames) return AddPerNameSamples(name);
+  if (other_samples_ == nullptr) {
+    // Spans already named kOtherSpanName share their samples.
+    it = samples_by_name_.find(kOtherSpanName);
+    other_samples_ = it != samples_by_name_.end()
+                         ? it->second.get()
+                         : AddPerNameSamples(kOtherSpanName);
+  }
+  return other_samples_;
+}
+
+LocalSpanStoreImpl::PerNameSamples* LocalSpanStoreImpl::AddPerNameSamples(
+    absl::string_view name) {
+  auto samples = absl::make_unique<PerNameSamples>(name);
+  PerNameSamples* ptr = samples.get();
+  samples_by_name_.emplace(ptr->name, std::move(samples));
+  return ptr;
+}
+
+std::vector<const LocalSpanStoreImpl::PerNameSamples*>
+LocalSpanStoreImpl::FindPerNameSamples(absl::string_view name) const {
+  std::vector<const PerNameSamples*> out;
+  absl::ReaderMutexLock l(&mu_);
+  if (name.empty()) {
+    out.reserve(samples_by_name_.size());
+    for (const auto& it : samples_by_name_) {
+      out.push_back(it.second.get());
+    }
+  } else {
+    auto it = samples_by_name_.find(name);
+    if (it != samples_by_name_.end()) out.push_back(it->second.get());
+  }
+  return out;
+}
+
+void LocalSpanStoreImpl::AddSpan(const std::shared_ptr<SpanImpl>& span) {
+  absl::Time end_time;
+  absl::Duration latency;
+  StatusCode code;
+  {
+    absl::MutexLock l(&span->mu_);
+    const common::TscClock::Converter converter;
+    end_time = converter.ToTime(span->end_ticks_);
+    latency = converter.ToDuration(span->end_ticks_ - span->start_ticks_);
+    code = span->status_.CanonicalCode();
   }
-  spans_.emplace_front(span->ToSpanData());
+  PerNameSamples* samples = GetOrAddPerNameSamples(span->name());
+  absl::MutexLock l(&samples->mu);
+  Bucket& bucket =
+      code == StatusCode::OK
+          ? samples->latency_buckets[GetLatencyBucketBoundary(latency)]
+          : samples->error_buckets[GetErrorBucket(code)];
+  bucket.ConsiderForSampling({span, latency}, end_time);
 }
 
 Summary LocalSpanStoreImpl::GetSummary() const {
   Summary summary;
-  absl::MutexLock l(&mu_);
-  for (const auto& span : spans_) {
-    PerSpanNameSummary& curr = GetPerSpanNameSummary(span.name(), &summary);
-    const absl::Duration latency = span.end_time() - span.start_time();
-    MapIncrement(GetLatencyBucketBoundary(latency),
-                 &curr.number_of_latency_sampled_spans);
-    MapIncrement(span.status().CanonicalCode(),
-                 &curr.number_of_error_sampled_spans);
+  absl::ReaderMutexLock l(&mu_);
+  for (const auto& name_samples : samples_by_name_) {
+    const PerNameSamples& samples = *name_samples.second;
+    PerSpanNameSummary per_name;
+    {
+      absl::MutexLock samples_lock(&samples.mu);
+      for (int i = 0; i < kNumLatencyBuckets; ++i) {
+        const int size = samples.latency_buckets[i].samples().size();
+        if (size > 0) {
+          per_name.number_of_latency_sampled_spans[static_cast<
+              LatencyBucketBoundary>(i)] = size;
+        }
+      }
+      for (int i = 0; i < kNumErrorBuckets; ++i) {
+        const int size = samples.error_buckets[i].samples().size();
+        if (size > 0) {
+          per_name.number_of_error_sampled_spans[static_cast<StatusCode>(
+              i + 1)] = size;
+        }
+      }
+    }
+    if (!per_name.number_of_latency_sampled_spans.empty() ||
+        !per_name.number_of_error_sampled_spans.empty()) {
+      summary.per_span_name_summary.emplace(samples.name, std::move(per_name));
+    }
   }
   return summary;
 }
 
 std::vector<SpanData> LocalSpanStoreImpl::GetLatencySampledSpans(
     const LatencyFilter& filter) const {
-  std::vector<SpanData> out;
-  absl::MutexLock l(&mu_);
-  for (const auto& span : spans_) {
-    uint64_t latency_ns =
-        (span.end_time() - span.start_time()) / absl::Nanoseconds(1);
-    if ((filter.span_name.empty() || (span.name() == filter.span_name)) &&
-        latency_ns >= filter.lower_latency_ns &&
-        latency_ns < filter.upper_latency_ns) {
-      out.emplace_back(span);
+  std::vector<std::shared_ptr<SpanImpl>> matching;
+  for (const PerNameSamples* samples : FindPerNameSamples(filter.span_name)) {
+    absl::MutexLock l(&samples->mu);
+    for (int i = 0; i < kNumLatencyBuckets; ++i) {
+      // Skip buckets entirely outside the filter.
+      if (GetLatencyBucketLowerBound(i) / absl::Nanoseconds(1) >=
+              filter.upper_latency_ns ||
+          (i + 1 < kNumLatencyBuckets &&
+           GetLatencyBucketLowerBound(i + 1) / absl::Nanoseconds(1) <=
+               filter.lower_latency_ns)) {
+        continue;
+      }
+      for (const Sample& sample : samples->latency_buckets[i].samples()) {
+        if (matching.size() >= filter.max_spans_to_return) break;
+        if (MatchesLatency(sample.latency, filter)) {
+          matching.push_back(sample.span);
+        }
+      }
     }
-    if (out.size() >= filter.max_spans_to_return) break;
   }
-  return out;
+  return ConvertSpans(matching);
 }
 
 std::vector<SpanData> LocalSpanStoreImpl::GetErrorSampledSpans(
     const ErrorFilter& filter) const {
-  std::vector<SpanData> out;
-  absl::MutexLock l(&mu_);
-  for (const auto& span : spans_) {
-    if ((filter.span_name.empty() || (span.name() == filter.span_name)) &&
-        filter.canonical_code == span.status().CanonicalCode()) {
-      out.emplace_back(span);
+  std::vector<std::shared_ptr<SpanImpl>> matching;
+  if (!filter.all_errors && filter.canonical_code == StatusCode::OK) {
+    return {};
+  }
+  for (const PerNameSamples* samples : FindPerNameSamples(filter.span_name)) {
+    absl::MutexLock l(&samples->mu);
+    for (int i = 0; i < kNumErrorBuckets; ++i) {
+      if (!filter.all_errors && i != GetErrorBucket(filter.canonical_code)) {
+        continue;
+      }
+      for (const Sample& sample : samples->error_buckets[i].samples()) {
+        if (matching.size() >= filter.max_spans_to_return) break;
+        matching.push_back(sample.span);
+      }
     }
-    if (out.size() >= filter.max_spans_to_return) break;
   }
-  return out;
+  return ConvertSpans(matching);
 }
 
 std::vector<SpanData> LocalSpanStoreImpl::GetSpans() const {
-  absl::MutexLock l(&mu_);
-  std::vector<SpanData> out(spans_.begin(), spans_.end());
-  return out;
+  std::vector<std::shared_ptr<SpanImpl>> spans;
+  for (const PerNameSamples* samples : FindPerNameSamples("")) {
+    absl::MutexLock l(&samples->mu);
+    for (const auto* buckets :
+         {&samples->latency_buckets, &samples->error_buckets}) {
+      for (const Bucket& bucket : *buckets) {
+        for (const Sample& sample : bucket.samples()) {
+          spans.push_back(sample.span);
+        }
+      }
+    }
+  }
+  return ConvertSpans(spans);
 }
 
 void LocalSpanStoreImpl::ClearForTesting() {
-  absl::MutexLock l(&mu_);
-  spans_.clear();
+  absl::ReaderMutexLock l(&mu_);
+  for (const auto& name_samples : samples_by_name_) {
+    PerNameSamples& samples = *name_samples.second;
+    absl::MutexLock samples_lock(&samples.mu);
+    for (Bucket& bucket : samples.latency_buckets) bucket.clear();
+    for (Bucket& bucket : samples.error_buckets) bucket.clear();
+  }
 }
 
 }  // namespace exporter
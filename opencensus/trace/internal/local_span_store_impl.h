@@ -17,8 +17,8 @@
 
 #include "opencensus/trace/internal/local_span_store.h"
 
+#include <cstddef>
 #include <cstdint>
-#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -27,6 +27,7 @@
 
 #include "absl/base/internal/endian.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
@@ -36,6 +37,7 @@
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/status_code.h"
 
 namespace opencensus {
 namespace trace {
@@ -43,13 +45,21 @@ namespace exporter {
 
 // LocalSpanStoreImpl implements the LocalSpanStore API.
 //
+// As in zPages, samples are kept separately for each span name: successful
+// spans in a bucket per LatencyBucketBoundary, and failed spans in a bucket per
+// StatusCode. Each bucket is a fixed-capacity ring that admits at most one span
+// per kTimeBetweenSamples, so that rare latencies and errors are not evicted by
+// common ones. Beyond kMaxSpanNames names, spans share the samples for
+// kOtherSpanName. Only the SpanImpl is retained; SpanData is built when a query
+// returns it.
+//
 // This class is thread-safe and a singleton.
 class LocalSpanStoreImpl {
  public:
   // Returns the global instance of LocalSpanStoreImpl.
   static LocalSpanStoreImpl* Get();
 
-  // Adds a new running Span. Only Span::End should call this.
+  // Considers an ended Span for sampling. Only Span::End should call this.
   void AddSpan(const std::shared_ptr<SpanImpl>& span) LOCKS_EXCLUDED(mu_);
 
   // Returns a summary of the data available in the LocalSpanStore.
@@ -67,14 +77,87 @@ class LocalSpanStoreImpl {
  private:
   friend class LocalSpanStoreImplTestPeer;
 
+  static constexpr int kNumLatencyBuckets =
+      LocalSpanStore::LatencyBucketBoundary::k100s_plus + 1;
+  // StatusCodes other than OK.
+  static constexpr int kNumErrorBuckets = StatusCode::UNAUTHENTICATED;
+  static constexpr int kLatencySamplesPerBucket = 10;
+  static constexpr int kErrorSamplesPerBucket = 5;
+  static constexpr size_t kMaxSpanNames = 1000;
+  static constexpr char kOtherSpanName[] = "other";
+
+  struct Sample {
+    std::shared_ptr<SpanImpl> span;
+    absl::Duration latency;
+  };
+
+  // A fixed-capacity ring of samples.
+  class Bucket {
+   public:
+    explicit Bucket(int capacity) : capacity_(capacity) {}
+
+    // Adds a span that ended at 'end_time' if enough time has passed since the
+    // last one was added, evicting the oldest if the bucket is full.
+    void ConsiderForSampling(Sample sample, absl::Time end_time);
+
+    void clear();
+
+    const std::vector<Sample>& samples() const { return samples_; }
+
+   private:
+    const int capacity_;
+    std::vector<Sample> samples_;
+    // The index of the oldest sample, once the bucket is full.
+    int next_ = 0;
+    absl::Time last_sampled_ = absl::InfinitePast();
+  };
+
+  // The samples for one span name.
+  struct PerNameSamples {
+    explicit PerNameSamples(absl::string_view name);
+
+    // The key in samples_by_name_ views this.
+    const std::string name;
+    mutable absl::Mutex mu;
+    std::vector<Bucket> latency_buckets GUARDED_BY(mu);
+    std::vector<Bucket> error_buckets GUARDED_BY(mu);
+  };
+
   // Private so only Get() can call it.
   LocalSpanStoreImpl() {}
 
+  // Returns the samples for 'name', adding them if necessary, or
+  // other_samples_ if there are already kMaxSpanNames names.
+  PerNameSamples* GetOrAddPerNameSamples(absl::string_view name)
+      LOCKS_EXCLUDED(mu_);
+
+  // Adds samples for 'name', which must not be in samples_by_name_.
+  PerNameSamples* AddPerNameSamples(absl::string_view name)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the samples for span names matching 'name', or all span names if
+  // 'name' is empty. Samples are never removed, so the returned pointers remain
+  // valid.
+  std::vector<const PerNameSamples*> FindPerNameSamples(
+      absl::string_view name) const LOCKS_EXCLUDED(mu_);
+
+  // Converts 'spans' to SpanData. Called without holding any store locks.
+  static std::vector<SpanData> ConvertSpans(
+      const std::vector<std::shared_ptr<SpanImpl>>& spans);
+
   // Clears all currently active spans from the store.
   void ClearForTesting() LOCKS_EXCLUDED(mu_);
 
+  // Guards the set of span names. Samples for each name are guarded by their
+  // own mutex.
   mutable absl::Mutex mu_;
-  std::deque<SpanData> spans_ GUARDED_BY(mu_);
+  // Keyed by a view of PerNameSamples::name, so that spans are looked up
+  // without copying their names.
+  std::unordered_map<absl::string_view, std::unique_ptr<PerNameSamples>,
+                     absl::Hash<absl::string_view>>
+      samples_by_name_ GUARDED_BY(mu_);
+  // The samples for kOtherSpanName, once samples_by_name_ is full.
+  PerNameSamples* other_samples_ GUARDED_BY(mu_) = nullptr;
 };
 
 }  // namespace exporter
@@ -14,6 +14,12 @@
 
 #include "opencensus/trace/internal/local_span_store.h"
 
+#include <cstdint>
+#include <limits>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gtest/gtest.h"
 #include "opencensus/trace/internal/local_span_store_impl.h"
 #include "opencensus/trace/sampler.h"
@@ -43,8 +49,97 @@ TEST(LocalSpanStoreTest, GetSummary) {
   EXPECT_EQ(1, summary.per_span_name_summary.size());
   EXPECT_EQ(1, summary.per_span_name_summary["SpanName"]
                    .number_of_latency_sampled_spans.size());
-  // TODO: EXPECT it ended up in the right bucket in
-  // number_of_latency_sampled_spans[].
+}
+
+TEST(LocalSpanStoreTest, ErrorsAreSampledByStatusCode) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  static AlwaysSampler sampler;
+  auto span1 = Span::StartSpan("ErrorSpan", /*parent=*/nullptr, {&sampler});
+  span1.SetStatus(StatusCode::CANCELLED, "cancelled");
+  span1.End();
+  auto span2 = Span::StartSpan("ErrorSpan", /*parent=*/nullptr, {&sampler});
+  span2.SetStatus(StatusCode::INTERNAL, "internal");
+  span2.End();
+
+  auto summary = LocalSpanStore::GetSummary();
+  const auto& errors =
+      summary.per_span_name_summary["ErrorSpan"].number_of_error_sampled_spans;
+  EXPECT_EQ(2, errors.size());
+  EXPECT_EQ(1, errors.at(StatusCode::CANCELLED));
+  EXPECT_EQ(1, errors.at(StatusCode::INTERNAL));
+  EXPECT_TRUE(summary.per_span_name_summary["ErrorSpan"]
+                  .number_of_latency_sampled_spans.empty());
+
+  auto spans = LocalSpanStore::GetErrorSampledSpans(
+      {"ErrorSpan", 10, StatusCode::CANCELLED, /*all_errors=*/false});
+  ASSERT_EQ(1, spans.size());
+  EXPECT_EQ(span1.context().span_id(), spans[0].context().span_id());
+  EXPECT_EQ(2, LocalSpanStore::GetErrorSampledSpans(
+                   {"ErrorSpan", 10, StatusCode::OK, /*all_errors=*/true})
+                   .size());
+  EXPECT_EQ(1, LocalSpanStore::GetErrorSampledSpans(
+                   {"", 1, StatusCode::OK, /*all_errors=*/true})
+                   .size());
+  EXPECT_EQ(0, LocalSpanStore::GetLatencySampledSpans(
+                   {"ErrorSpan", 10, 0, std::numeric_limits<uint64_t>::max()})
+                   .size());
+}
+
+TEST(LocalSpanStoreTest, LatencyFilter) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  static AlwaysSampler sampler;
+  auto span = Span::StartSpan("LatencySpan", /*parent=*/nullptr, {&sampler});
+  absl::SleepFor(absl::Milliseconds(2));
+  span.End();
+
+  auto summary = LocalSpanStore::GetSummary();
+  const auto& latencies = summary.per_span_name_summary["LatencySpan"]
+                              .number_of_latency_sampled_spans;
+  ASSERT_EQ(1, latencies.size());
+  EXPECT_LE(LocalSpanStore::k1ms_to_10ms, latencies.begin()->first);
+
+  EXPECT_EQ(1, LocalSpanStore::GetLatencySampledSpans(
+                   {"LatencySpan", 10, 1000000,
+                    std::numeric_limits<uint64_t>::max()})
+                   .size());
+  EXPECT_EQ(0, LocalSpanStore::GetLatencySampledSpans(
+                   {"LatencySpan", 10, 0, 1000000})
+                   .size());
+  EXPECT_EQ(1, LocalSpanStore::GetSpans().size());
+}
+
+TEST(LocalSpanStoreTest, BucketsAdmitOneSpanPerInterval) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  static AlwaysSampler sampler;
+  for (int i = 0; i < 100; ++i) {
+    auto span = Span::StartSpan("FrequentSpan", /*parent=*/nullptr, {&sampler});
+    span.SetStatus(StatusCode::UNAVAILABLE, "");
+    span.End();
+  }
+  EXPECT_EQ(1, LocalSpanStore::GetErrorSampledSpans(
+                   {"FrequentSpan", 100, StatusCode::UNAVAILABLE, false})
+                   .size());
+}
+
+// Runs last, since it fills the span names for the rest of the process.
+TEST(LocalSpanStoreTest, NamesBeyondLimitShareOtherSamples) {
+  exporter::LocalSpanStoreImplTestPeer::ClearForTesting();
+  static AlwaysSampler sampler;
+  for (int i = 0; i < 1000; ++i) {
+    Span::StartSpan(absl::StrCat("Span", i), /*parent=*/nullptr, {&sampler})
+        .End();
+  }
+  auto span = Span::StartSpan("OverflowSpan", /*parent=*/nullptr, {&sampler});
+  span.SetStatus(StatusCode::ABORTED, "");
+  span.End();
+  const auto summary = LocalSpanStore::GetSummary();
+  EXPECT_EQ(0, summary.per_span_name_summary.count("OverflowSpan"));
+  EXPECT_EQ(1, summary.per_span_name_summary.count("other"));
+  EXPECT_GE(1001, summary.per_span_name_summary.size());
+  const auto spans = LocalSpanStore::GetErrorSampledSpans(
+      {"other", 10, StatusCode::ABORTED, false});
+  ASSERT_EQ(1, spans.size());
+  EXPECT_EQ("OverflowSpan", spans[0].name());
 }
 
 }  // namespace
@@ -0,0 +1,133 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/trace/propagation/b3.h"
+#include "opencensus/trace/propagation/grpc_trace_bin.h"
+#include "opencensus/trace/propagation/trace_context.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+namespace {
+
+constexpr char kTraceParent[] =
+    "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01";
+constexpr char kTraceState[] =
+    "rojo=00f067aa0ba902b7,congo=t61rcWkgMzE,vendor@tenant=opaque-value";
+
+SpanContext TestContext() { return FromTraceParentHeader(kTraceParent); }
+
+void BM_FromTraceParentHeader(benchmark::State& state) {
+  const absl::string_view header(kTraceParent);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FromTraceParentHeader(header));
+  }
+  state.SetBytesProcessed(state.iterations() * header.size());
+}
+BENCHMARK(BM_FromTraceParentHeader);
+
+void BM_ToTraceParentHeader(benchmark::State& state) {
+  const SpanContext ctx = TestContext();
+  char buf[kTraceParentHeaderLen];
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    ToTraceParentHeader(ctx, buf);
+    benchmark::DoNotOptimize(buf);
+  }
+  state.SetBytesProcessed(state.iterations() * sizeof(buf));
+}
+BENCHMARK(BM_ToTraceParentHeader);
+
+void BM_ParseTraceStateHeader(benchmark::State& state) {
+  const absl::string_view header(kTraceState);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    size_t n = 0;
+    ParseTraceStateHeader(header,
+                          [&n](absl::string_view, absl::string_view) { ++n; });
+    benchmark::DoNotOptimize(n);
+  }
+  state.SetBytesProcessed(state.iterations() * header.size());
+}
+BENCHMARK(BM_ParseTraceStateHeader);
+
+void BM_FromB3Headers(benchmark::State& state) {
+  const SpanContext ctx = TestContext();
+  const std::string trace_id = ToB3TraceIdHeader(ctx);
+  const std::string span_id = ToB3SpanIdHeader(ctx);
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FromB3Headers(trace_id, span_id, "1", ""));
+  }
+}
+BENCHMARK(BM_FromB3Headers);
+
+void BM_FromB3SingleHeader(benchmark::State& state) {
+  const std::string header = ToB3SingleHeader(TestContext());
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FromB3SingleHeader(header));
+  }
+  state.SetBytesProcessed(state.iterations() * header.size());
+}
+BENCHMARK(BM_FromB3SingleHeader);
+
+void BM_ToB3SingleHeader(benchmark::State& state) {
+  const SpanContext ctx = TestContext();
+  char buf[kB3SingleHeaderLen];
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    ToB3SingleHeader(ctx, buf);
+    benchmark::DoNotOptimize(buf);
+  }
+  state.SetBytesProcessed(state.iterations() * sizeof(buf));
+}
+BENCHMARK(BM_ToB3SingleHeader);
+
+void BM_FromGrpcTraceBinHeader(benchmark::State& state) {
+  const std::string header = ToGrpcTraceBinHeader(TestContext());
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FromGrpcTraceBinHeader(header));
+  }
+  state.SetBytesProcessed(state.iterations() * header.size());
+}
+BENCHMARK(BM_FromGrpcTraceBinHeader);
+
+void BM_ToGrpcTraceBinHeader(benchmark::State& state) {
+  const SpanContext ctx = TestContext();
+  uint8_t buf[kGrpcTraceBinHeaderLen];
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    ToGrpcTraceBinHeader(ctx, buf);
+    benchmark::DoNotOptimize(buf);
+  }
+  state.SetBytesProcessed(state.iterations() * sizeof(buf));
+}
+BENCHMARK(BM_ToGrpcTraceBinHeader);
+
+}  // namespace
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
+
+BENCHMARK_MAIN();
@@ -0,0 +1,45 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "opencensus/trace/resource_usage.h"
+
+#include <time.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace opencensus {
+namespace trace {
+
+std::atomic<ResourceUsage::AllocatedBytesFunction>
+    ResourceUsage::allocated_bytes_function_(nullptr);
+
+// static
+void ResourceUsage::SetAllocatedBytesFunction(
+    AllocatedBytesFunction function) {
+  allocated_bytes_function_.store(function, std::memory_order_release);
+}
+
+// static
+int64_t ResourceUsage::ThreadCpuNanos() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+#endif
+  return -1;
+}
+
+}  // namespace trace
+}  // namespace opencensus
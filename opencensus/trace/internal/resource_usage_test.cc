@@ -0,0 +1,137 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "opencensus/trace/resource_usage.h"
+
+#include <time.h>
+
+#include <cstdint>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/trace_config.h"
+#include "opencensus/trace/trace_params.h"
+
+namespace opencensus {
+namespace trace {
+
+class SpanTestPeer {
+ public:
+  static exporter::SpanData ToSpanData(Span* span) {
+    return span->span_impl_for_test()->ToSpanData();
+  }
+};
+
+namespace {
+
+// Uses at least the given CPU time on the calling thread.
+void BurnCpu(int64_t nanos) {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  const int64_t start = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  int64_t now;
+  do {
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    now = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  } while (now - start < nanos);
+}
+
+thread_local int64_t allocated_bytes = 0;
+int64_t GetAllocatedBytes() { return allocated_bytes; }
+
+class ResourceUsageTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    ResourceUsage::SetAllocatedBytesFunction(nullptr);
+  }
+
+  static StartSpanOptions Options() {
+    static AlwaysSampler sampler;
+    return StartSpanOptions(&sampler, {}, /*record_resource_usage=*/true);
+  }
+};
+
+TEST_F(ResourceUsageTest, NotRecordedByDefault) {
+  AlwaysSampler sampler;
+  auto span = Span::StartSpan("span", nullptr, {&sampler});
+  span.End();
+  const auto data = SpanTestPeer::ToSpanData(&span);
+  EXPECT_EQ(0, data.attributes().count(kCpuTimeAttributeKey));
+  EXPECT_EQ(0, data.attributes().count(kAllocatedBytesAttributeKey));
+}
+
+TEST_F(ResourceUsageTest, RecordsCpuTime) {
+  auto span = Span::StartSpan("span", nullptr, Options());
+  BurnCpu(1000000);
+  span.End();
+  const auto data = SpanTestPeer::ToSpanData(&span);
+  EXPECT_LE(1000000, data.attributes().at(kCpuTimeAttributeKey).int_value());
+  EXPECT_EQ(0, data.attributes().count(kAllocatedBytesAttributeKey));
+}
+
+TEST_F(ResourceUsageTest, RecordsAllocatedBytes) {
+  ResourceUsage::SetAllocatedBytesFunction(&GetAllocatedBytes);
+  auto span = Span::StartSpan("span", nullptr, Options());
+  allocated_bytes += 100;
+  span.End();
+  const auto data = SpanTestPeer::ToSpanData(&span);
+  EXPECT_EQ(100, data.attributes().at(kAllocatedBytesAttributeKey).int_value());
+}
+
+TEST_F(ResourceUsageTest, ParentIncludesChild) {
+  auto parent = Span::StartSpan("parent", nullptr, Options());
+  auto child = Span::StartSpan("child", &parent, Options());
+  BurnCpu(1000000);
+  child.End();
+  parent.End();
+  const int64_t parent_cpu = SpanTestPeer::ToSpanData(&parent)
+                                 .attributes()
+                                 .at(kCpuTimeAttributeKey)
+                                 .int_value();
+  const int64_t child_cpu = SpanTestPeer::ToSpanData(&child)
+                                .attributes()
+                                .at(kCpuTimeAttributeKey)
+                                .int_value();
+  EXPECT_LE(child_cpu, parent_cpu);
+}
+
+TEST_F(ResourceUsageTest, NotRecordedAcrossThreads) {
+  ResourceUsage::SetAllocatedBytesFunction(&GetAllocatedBytes);
+  auto span = Span::StartSpan("span", nullptr, Options());
+  std::thread([&span] { span.End(); }).join();
+  const auto data = SpanTestPeer::ToSpanData(&span);
+  EXPECT_EQ(0, data.attributes().count(kCpuTimeAttributeKey));
+  EXPECT_EQ(0, data.attributes().count(kAllocatedBytesAttributeKey));
+}
+
+TEST_F(ResourceUsageTest, DoesNotEvictUserAttributes) {
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{1, 32, 128, 128, ProbabilitySampler(1e-4)});
+  auto span = Span::StartSpan("span", nullptr, Options());
+  span.AddAttribute("key", "value");
+  span.End();
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(1e-4)});
+  const auto data = SpanTestPeer::ToSpanData(&span);
+  EXPECT_EQ("value", data.attributes().at("key").string_value());
+  EXPECT_EQ(0, data.attributes().count(kCpuTimeAttributeKey));
+  EXPECT_EQ(1, data.num_attributes_dropped());
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
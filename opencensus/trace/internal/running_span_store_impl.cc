@@ -25,10 +25,13 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "opencensus/common/internal/string_interner.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/internal/trace_config_impl.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_config.h"
 
 namespace opencensus {
 namespace trace {
@@ -48,31 +51,146 @@ RunningSpanStoreImpl* RunningSpanStoreImpl::Get() {
   return global_running_span_store;
 }
 
+RunningSpanStoreImpl::Shard& RunningSpanStoreImpl::ShardFor(uintptr_t key) {
+  // Fibonacci hashing: the high bits of the product depend on all bits of the
+  // address, including those above the allocator's alignment.
+  return shards_[(static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >>
+                 (64 - kShardBits)];
+}
+
+ThreadSpanList* RunningSpanStoreImpl::CurrentThreadList() {
+  // Returns the list for reuse when the thread exits.
+  struct Handle {
+    ~Handle() {
+      if (list != nullptr) RunningSpanStoreImpl::Get()->ReleaseThreadList(list);
+    }
+    ThreadSpanList* list = nullptr;
+  };
+  thread_local Handle handle;
+  if (handle.list == nullptr) handle.list = AcquireThreadList();
+  return handle.list;
+}
+
+ThreadSpanList* RunningSpanStoreImpl::AcquireThreadList() {
+  absl::MutexLock l(&lists_mu_);
+  if (!free_lists_.empty()) {
+    ThreadSpanList* list = free_lists_.back();
+    free_lists_.pop_back();
+    return list;
+  }
+  lists_.push_back(new ThreadSpanList);
+  return lists_.back();
+}
+
+void RunningSpanStoreImpl::ReleaseThreadList(ThreadSpanList* list) {
+  absl::MutexLock l(&lists_mu_);
+  free_lists_.push_back(list);
+}
+
+std::vector<ThreadSpanList*> RunningSpanStoreImpl::AllThreadLists() const {
+  absl::MutexLock l(&lists_mu_);
+  return lists_;
+}
+
+// static
+void RunningSpanStoreImpl::Link(SpanImpl* span, ThreadSpanList* list) {
+  RunningSpanLinks& links = span->running_links_;
+  links.tracker = RunningSpanLinks::Tracker::kThreadList;
+  links.list = list;
+  absl::MutexLock l(&list->mu);
+  links.prev = nullptr;
+  links.next = list->head;
+  if (list->head != nullptr) list->head->running_links_.prev = span;
+  list->head = span;
+}
+
+// static
+void RunningSpanStoreImpl::Unlink(SpanImpl* span) {
+  RunningSpanLinks& links = span->running_links_;
+  ThreadSpanList* list = links.list;
+  absl::MutexLock l(&list->mu);
+  if (links.prev != nullptr) {
+    links.prev->running_links_.next = links.next;
+  } else {
+    list->head = links.next;
+  }
+  if (links.next != nullptr) links.next->running_links_.prev = links.prev;
+  links.prev = nullptr;
+  links.next = nullptr;
+}
+
 void RunningSpanStoreImpl::AddSpan(const std::shared_ptr<SpanImpl>& span) {
-  absl::MutexLock l(&mu_);
-  spans_.insert({GetKey(span.get()), span});
+  switch (TraceConfigImpl::Get()->running_span_tracking()) {
+    case RunningSpanTracking::kDisabled:
+      return;
+    case RunningSpanTracking::kSharded: {
+      span->running_links_.tracker = RunningSpanLinks::Tracker::kShards;
+      const uintptr_t key = GetKey(span.get());
+      Shard& shard = ShardFor(key);
+      absl::MutexLock l(&shard.mu);
+      shard.spans.insert({key, span});
+      return;
+    }
+    case RunningSpanTracking::kPerThreadLists:
+      Link(span.get(), CurrentThreadList());
+      return;
+  }
 }
 
 bool RunningSpanStoreImpl::RemoveSpan(const std::shared_ptr<SpanImpl>& span) {
-  absl::MutexLock l(&mu_);
-  auto iter = spans_.find(GetKey(span.get()));
-  if (iter == spans_.end()) {
-    return false;  // Not tracked.
+  RunningSpanLinks& links = span->running_links_;
+  const RunningSpanLinks::Tracker tracker = links.tracker;
+  links.tracker = RunningSpanLinks::Tracker::kNone;
+  switch (tracker) {
+    case RunningSpanLinks::Tracker::kNone:
+      return false;  // Not tracked.
+    case RunningSpanLinks::Tracker::kShards: {
+      const uintptr_t key = GetKey(span.get());
+      Shard& shard = ShardFor(key);
+      absl::MutexLock l(&shard.mu);
+      auto iter = shard.spans.find(key);
+      if (iter == shard.spans.end()) {
+        return false;  // Cleared for testing.
+      }
+      shard.spans.erase(iter);
+      return true;
+    }
+    case RunningSpanLinks::Tracker::kThreadList:
+      Unlink(span.get());
+      return true;
+  }
+  return false;
+}
+
+void RunningSpanStoreImpl::OnSpanDestroyed(SpanImpl* span) {
+  // Spans in shards are kept alive by the store, so only spans in lists can be
+  // destroyed while tracked.
+  if (span->running_links_.tracker == RunningSpanLinks::Tracker::kThreadList) {
+    span->running_links_.tracker = RunningSpanLinks::Tracker::kNone;
+    Unlink(span);
   }
-  spans_.erase(iter);
-  return true;
 }
 
 RunningSpanStore::Summary RunningSpanStoreImpl::GetSummary() const {
   RunningSpanStore::Summary summary;
-  absl::MutexLock l(&mu_);
-  for (const auto& addr_span : spans_) {
-    const std::string& name = addr_span.second->name_constref();
-    auto it = summary.per_span_name_summary.find(name);
-    if (it != summary.per_span_name_summary.end()) {
-      it->second.num_running_spans++;
-    } else {
-      summary.per_span_name_summary[name] = {1};
+  for (const Shard& shard : shards_) {
+    absl::MutexLock l(&shard.mu);
+    for (const auto& addr_span : shard.spans) {
+      const std::string name(addr_span.second->name());
+      auto it = summary.per_span_name_summary.find(name);
+      if (it != summary.per_span_name_summary.end()) {
+        it->second.num_running_spans++;
+      } else {
+        summary.per_span_name_summary[name] = {1};
+      }
+    }
+  }
+  for (ThreadSpanList* list : AllThreadLists()) {
+    absl::MutexLock l(&list->mu);
+    for (const SpanImpl* span = list->head; span != nullptr;
+         span = span->running_links_.next) {
+      summary.per_span_name_summary[std::string(span->name())]
+          .num_running_spans++;
     }
   }
   return summary;
@@ -80,20 +198,61 @@ RunningSpanStore::Summary RunningSpanStoreImpl::GetSummary() const {
 
 std::vector<SpanData> RunningSpanStoreImpl::GetRunningSpans(
     const RunningSpanStore::Filter& filter) const {
+  // Interned span names match by address.
+  const absl::string_view interned_name =
+      common::StringInterner::Find(filter.span_name);
+  auto matches = [&filter, interned_name](const SpanImpl& span) {
+    if (filter.span_name.empty()) return true;
+    const common::InternedString& name = span.interned_name();
+    return name.interned() ? name.view().data() == interned_name.data()
+                           : name.view() == filter.span_name;
+  };
+  // Collect matching spans first, and convert them without holding any shard
+  // lock.
+  std::vector<std::shared_ptr<SpanImpl>> matching;
+  for (const Shard& shard : shards_) {
+    absl::MutexLock l(&shard.mu);
+    for (const auto& it : shard.spans) {
+      if (matching.size() >= filter.max_spans_to_return) break;
+      if (matches(*it.second)) {
+        matching.push_back(it.second);
+      }
+    }
+  }
   std::vector<SpanData> running_spans;
-  absl::MutexLock l(&mu_);
-  for (const auto& it : spans_) {
-    if (running_spans.size() >= filter.max_spans_to_return) break;
-    if (filter.span_name.empty() || (it.second->name() == filter.span_name)) {
-      running_spans.emplace_back(it.second->ToSpanData());
+  running_spans.reserve(matching.size());
+  for (const auto& span : matching) {
+    running_spans.emplace_back(span->ToSpanData());
+  }
+  // Spans in lists are not owned by the store, so must be converted while the
+  // list's lock keeps them from being destroyed.
+  for (ThreadSpanList* list : AllThreadLists()) {
+    absl::MutexLock l(&list->mu);
+    for (const SpanImpl* span = list->head;
+         span != nullptr && running_spans.size() < filter.max_spans_to_return;
+         span = span->running_links_.next) {
+      if (matches(*span)) {
+        running_spans.emplace_back(span->ToSpanData());
+      }
     }
   }
   return running_spans;
 }
 
 void RunningSpanStoreImpl::ClearForTesting() {
-  absl::MutexLock l(&mu_);
-  spans_.clear();
+  for (Shard& shard : shards_) {
+    absl::MutexLock l(&shard.mu);
+    shard.spans.clear();
+  }
+  for (ThreadSpanList* list : AllThreadLists()) {
+    absl::MutexLock l(&list->mu);
+    for (SpanImpl* span = list->head; span != nullptr;) {
+      RunningSpanLinks& links = span->running_links_;
+      span = links.next;
+      links = RunningSpanLinks();
+    }
+    list->head = nullptr;
+  }
 }
 
 }  // namespace exporter
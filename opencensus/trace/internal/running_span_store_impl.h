@@ -20,6 +20,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "absl/base/optimization.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "opencensus/trace/internal/running_span_store.h"
@@ -29,41 +30,87 @@ namespace opencensus {
 namespace trace {
 namespace exporter {
 
+// A list of running spans started on one thread, linked through their
+// RunningSpanLinks. Lists are never destroyed: when their thread exits they are
+// reused by a later thread, and spans still in them remain linked until they
+// end or are destroyed.
+struct ThreadSpanList {
+  absl::Mutex mu;
+  SpanImpl* head GUARDED_BY(mu) = nullptr;
+};
+
 // RunningSpanStoreImpl implements the store for the RunningSpanStore API.
 //
+// Depending on TraceConfig's RunningSpanTracking, spans are either:
+//  - Partitioned into kNumShards shards by the address of their SpanImpl,
+//    each with its own lock, so that adding and removing spans on different
+//    threads rarely contend. Queries lock one shard at a time, and never block
+//    writers to the other shards.
+//  - Linked into the ThreadSpanList of the thread that started them. Adding
+//    and removing a span is O(1) and does not allocate; queries lock one list
+//    at a time.
+//
 // This class is thread-safe and a singleton.
 class RunningSpanStoreImpl {
  public:
   // Returns the global instance of RunningSpanStoreImpl.
   static RunningSpanStoreImpl* Get();
 
-  // Adds a new running Span.
-  void AddSpan(const std::shared_ptr<SpanImpl>& span) LOCKS_EXCLUDED(mu_);
+  // Adds a new running Span, unless running span tracking is disabled.
+  void AddSpan(const std::shared_ptr<SpanImpl>& span);
 
   // Removes a Span that's no longer running. Returns true on success, false if
   // that Span was not being tracked.
-  bool RemoveSpan(const std::shared_ptr<SpanImpl>& span) LOCKS_EXCLUDED(mu_);
+  bool RemoveSpan(const std::shared_ptr<SpanImpl>& span);
+
+  // Removes a Span that is being destroyed without having ended. Must be called
+  // before 'span' is deleted.
+  void OnSpanDestroyed(SpanImpl* span);
 
   // Returns a summary of the data available in the RunningSpanStore.
-  RunningSpanStore::Summary GetSummary() const LOCKS_EXCLUDED(mu_);
+  RunningSpanStore::Summary GetSummary() const;
 
   // Returns the running spans that match the filter.
   std::vector<SpanData> GetRunningSpans(
-      const RunningSpanStore::Filter& filter) const LOCKS_EXCLUDED(mu_);
+      const RunningSpanStore::Filter& filter) const;
 
  private:
   friend class RunningSpanStoreImplTestPeer;
 
+  static constexpr int kShardBits = 5;
+  static constexpr int kNumShards = 1 << kShardBits;
+
+  // Aligned so that shards do not share cache lines.
+  struct ABSL_CACHELINE_ALIGNED Shard {
+    mutable absl::Mutex mu;
+    // The key is the memory address of the underlying SpanImpl object.
+    std::unordered_map<uintptr_t, std::shared_ptr<SpanImpl>> spans
+        GUARDED_BY(mu);
+  };
+
   RunningSpanStoreImpl() {}
 
+  Shard& ShardFor(uintptr_t key);
+
+  // Returns the calling thread's ThreadSpanList, assigning one on first use.
+  ThreadSpanList* CurrentThreadList();
+  ThreadSpanList* AcquireThreadList() LOCKS_EXCLUDED(lists_mu_);
+  void ReleaseThreadList(ThreadSpanList* list) LOCKS_EXCLUDED(lists_mu_);
+  // Returns all lists ever created.
+  std::vector<ThreadSpanList*> AllThreadLists() const LOCKS_EXCLUDED(lists_mu_);
+
+  static void Link(SpanImpl* span, ThreadSpanList* list);
+  static void Unlink(SpanImpl* span);
+
   // Clears all currently active spans from the store.
-  void ClearForTesting() LOCKS_EXCLUDED(mu_);
+  void ClearForTesting();
 
-  mutable absl::Mutex mu_;
+  Shard shards_[kNumShards];
 
-  // The key is the memory address of the underlying SpanImpl object.
-  std::unordered_map<uintptr_t, std::shared_ptr<SpanImpl>> spans_
-      GUARDED_BY(mu_);
+  mutable absl::Mutex lists_mu_;
+  std::vector<ThreadSpanList*> lists_ GUARDED_BY(lists_mu_);
+  // Lists whose threads have exited.
+  std::vector<ThreadSpanList*> free_lists_ GUARDED_BY(lists_mu_);
 };
 
 }  // namespace exporter
@@ -15,7 +15,9 @@
 #include "opencensus/trace/internal/running_span_store.h"
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <vector>
 
@@ -111,6 +113,101 @@ TEST(RunningSpanStoreTest, GetSummaryAndGetRunningSpans) {
   EXPECT_EQ(1, summary.per_span_name_summary["Group2"].num_running_spans);
 }
 
+TEST(RunningSpanStoreTest, ConcurrentStartEndAndQueries) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  auto long_running = Span::StartSpan("LongRunning", nullptr, opts);
+
+  constexpr int kThreads = 8;
+  constexpr int kSpansPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&opts]() {
+      for (int j = 0; j < kSpansPerThread; ++j) {
+        auto span = Span::StartSpan("Concurrent", nullptr, opts);
+        span.End();
+      }
+    });
+  }
+  // Queries run concurrently with the writers.
+  for (int i = 0; i < 100; ++i) {
+    auto summary = RunningSpanStore::GetSummary();
+    EXPECT_EQ(1,
+              summary.per_span_name_summary["LongRunning"].num_running_spans);
+    EXPECT_EQ(1, RunningSpanStore::GetRunningSpans({"LongRunning", 10}).size());
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto summary = RunningSpanStore::GetSummary();
+  EXPECT_EQ(0, summary.per_span_name_summary.count("Concurrent"));
+  EXPECT_EQ(1, RunningSpanStore::GetRunningSpans({"", 10}).size());
+  long_running.End();
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+}
+
+TEST(RunningSpanStoreTest, PerThreadLists) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  TraceConfig::SetRunningSpanTracking(RunningSpanTracking::kPerThreadLists);
+  auto span1 = Span::StartSpan("Group1", nullptr, opts);
+  auto span2 = Span::StartSpan("Group1", nullptr, opts);
+  std::unique_ptr<Span> span3;
+  std::thread([&span3, &opts]() {
+    span3 = absl::make_unique<Span>(Span::StartSpan("Group2", nullptr, opts));
+  }).join();
+  {
+    // Destroyed without ending.
+    auto span4 = Span::StartSpan("Group3", nullptr, opts);
+  }
+
+  auto summary = RunningSpanStore::GetSummary();
+  EXPECT_EQ(2, summary.per_span_name_summary["Group1"].num_running_spans);
+  EXPECT_EQ(1, summary.per_span_name_summary["Group2"].num_running_spans);
+  EXPECT_EQ(0, summary.per_span_name_summary.count("Group3"));
+  EXPECT_EQ(2, RunningSpanStore::GetRunningSpans({"Group1", 10}).size());
+  EXPECT_EQ(1, RunningSpanStore::GetRunningSpans({"Group1", 1}).size());
+  EXPECT_EQ(1, RunningSpanStore::GetRunningSpans({"Group2", 10}).size());
+
+  // Ends spans in the middle of a list, and on a different thread from the one
+  // that started them.
+  span1.End();
+  span3->End();
+  summary = RunningSpanStore::GetSummary();
+  EXPECT_EQ(1, summary.per_span_name_summary["Group1"].num_running_spans);
+  EXPECT_EQ(0, summary.per_span_name_summary.count("Group2"));
+  span2.End();
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+  TraceConfig::SetRunningSpanTracking(RunningSpanTracking::kSharded);
+}
+
+TEST(RunningSpanStoreTest, DisabledAndSwitchingModes) {
+  AlwaysSampler sampler;
+  StartSpanOptions opts = {&sampler};
+  RunningSpanStoreImplTestPeer::ClearForTesting();
+  auto sharded = Span::StartSpan("Sharded", nullptr, opts);
+  TraceConfig::SetRunningSpanTracking(RunningSpanTracking::kDisabled);
+  auto untracked = Span::StartSpan("Untracked", nullptr, opts);
+  TraceConfig::SetRunningSpanTracking(RunningSpanTracking::kPerThreadLists);
+  auto listed = Span::StartSpan("Listed", nullptr, opts);
+  TraceConfig::SetRunningSpanTracking(RunningSpanTracking::kSharded);
+
+  auto summary = RunningSpanStore::GetSummary();
+  EXPECT_EQ(1, summary.per_span_name_summary["Sharded"].num_running_spans);
+  EXPECT_EQ(0, summary.per_span_name_summary.count("Untracked"));
+  EXPECT_EQ(1, summary.per_span_name_summary["Listed"].num_running_spans);
+
+  // Spans are removed from the store that tracked them, whatever the current
+  // mode.
+  sharded.End();
+  untracked.End();
+  listed.End();
+  EXPECT_EQ(0, RunningSpanStore::GetRunningSpans({"", 10}).size());
+}
+
 }  // namespace
 }  // namespace exporter
 }  // namespace trace
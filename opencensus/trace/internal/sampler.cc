@@ -14,10 +14,18 @@
 
 #include "opencensus/trace/sampler.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <vector>
 
 #include "absl/base/attributes.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
 
 namespace opencensus {
 namespace trace {
@@ -38,6 +46,17 @@ uint64_t CalculateThreshold(double probability) {
          static_cast<uint64_t>(lo_bits);
 }
 
+// Token intervals are clamped to this, about 31 years, so that converting
+// them is defined and adding one to the current time cannot overflow.
+constexpr double kMaxIntervalNanos = 1e18;
+
+// Returns the time it takes to accumulate one token, or -1 to never sample.
+int64_t CalculateIntervalNanos(double max_traces_per_second) {
+  if (!(max_traces_per_second > 0)) return -1;
+  return static_cast<int64_t>(
+      std::min(1e9 / max_traces_per_second, kMaxIntervalNanos));
+}
+
 uint64_t CalculateThresholdFromBuffer(const TraceId& trace_id) {
   uint8_t buf[TraceId::kSize];
   trace_id.CopyTo(buf);
@@ -65,5 +84,214 @@ bool ProbabilitySampler::ShouldSample(
   return CalculateThresholdFromBuffer(trace_id) <= threshold_;
 }
 
+RateLimitingSampler::RateLimitingSampler(double max_traces_per_second,
+                                         double probability)
+    : probability_sampler_(probability),
+      interval_nanos_(CalculateIntervalNanos(max_traces_per_second)),
+      burst_nanos_(std::max<int64_t>(0, 1000000000 - interval_nanos_)),
+      full_time_nanos_(0) {}
+
+bool RateLimitingSampler::ShouldSample(
+    const SpanContext* parent_context, bool has_remote_parent,
+    const TraceId& trace_id, const SpanId& span_id, absl::string_view name,
+    const std::vector<Span*>& parent_links) const {
+  if (parent_context != nullptr && parent_context->IsValid()) {
+    return parent_context->trace_options().IsSampled();
+  }
+  if (interval_nanos_ < 0) return false;
+  if (!probability_sampler_.ShouldSample(parent_context, has_remote_parent,
+                                         trace_id, span_id, name,
+                                         parent_links)) {
+    return false;
+  }
+  return TryAcquire(absl::GetCurrentTimeNanos());
+}
+
+bool RateLimitingSampler::TryAcquire(int64_t now_nanos) const {
+  int64_t full_time = full_time_nanos_.load(std::memory_order_relaxed);
+  while (true) {
+    // When the bucket is empty, reject without writing, so that a saturated
+    // sampler does not contend on the cache line.
+    if (full_time - now_nanos > burst_nanos_) return false;
+    const int64_t next = std::max(full_time, now_nanos) + interval_nanos_;
+    if (full_time_nanos_.compare_exchange_weak(full_time, next,
+                                               std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+namespace {
+
+// The number of separately tracked names; a power of two.
+constexpr size_t kNumSlots = 2048;
+// At most half the slots are used, to keep probe sequences short.
+constexpr size_t kMaxNames = kNumSlots / 2;
+// The number of slots probed for a name before using the shared slot.
+constexpr size_t kMaxProbes = 16;
+constexpr int64_t kAdjustIntervalNanos = 1000000000;
+// When a new name appears, probabilities are recomputed after at most this
+// long, to bound the time it is sampled in full.
+constexpr int64_t kNewNameAdjustDelayNanos = 100000000;
+// Each thread checks whether to recompute probabilities every this many
+// calls, to avoid reading the clock on every decision.
+constexpr int kCallsPerClockCheck = 64;
+// The weight of the newest interval in the exponentially weighted rate.
+constexpr double kRateSmoothing = 0.5;
+// A name's slot is freed after this many adjustments without calls.
+constexpr int kIdleAdjustmentsBeforeFree = 60;
+
+thread_local int calls_until_clock_check = 0;
+
+}  // namespace
+
+struct AdaptiveSampler::Slot {
+  // 0 if the slot is unused.
+  std::atomic<uint64_t> name_hash{0};
+  // Calls since the last adjustment.
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> threshold{UINT64_MAX};
+  // The estimated calls per second. Only accessed while adjusting.
+  double rate = -1;
+  // Adjustments since the last call. Only accessed while adjusting.
+  int idle_adjustments = 0;
+};
+
+AdaptiveSampler::AdaptiveSampler(double target_traces_per_second,
+                                 double min_traces_per_second_per_name)
+    : target_traces_per_second_(std::max(0.0, target_traces_per_second)),
+      min_traces_per_second_per_name_(
+          std::max(0.0, min_traces_per_second_per_name)),
+      slots_(new Slot[kNumSlots + 1]),
+      num_names_(0),
+      adjusting_(false),
+      next_adjust_nanos_(absl::GetCurrentTimeNanos() + kAdjustIntervalNanos),
+      last_adjust_nanos_(absl::GetCurrentTimeNanos()) {}
+
+AdaptiveSampler::~AdaptiveSampler() = default;
+
+bool AdaptiveSampler::ShouldSample(
+    const SpanContext* parent_context,
+    bool has_remote_parent ABSL_ATTRIBUTE_UNUSED, const TraceId& trace_id,
+    const SpanId& span_id ABSL_ATTRIBUTE_UNUSED, absl::string_view name,
+    const std::vector<Span*>& parent_links ABSL_ATTRIBUTE_UNUSED) const {
+  if (parent_context != nullptr && parent_context->IsValid()) {
+    return parent_context->trace_options().IsSampled();
+  }
+  Slot* slot = FindSlot(name);
+  slot->calls.fetch_add(1, std::memory_order_relaxed);
+  if (--calls_until_clock_check <= 0) {
+    calls_until_clock_check = kCallsPerClockCheck;
+    MaybeAdjust(absl::GetCurrentTimeNanos());
+  }
+  const uint64_t threshold = slot->threshold.load(std::memory_order_relaxed);
+  return threshold != 0 && CalculateThresholdFromBuffer(trace_id) <= threshold;
+}
+
+AdaptiveSampler::Slot* AdaptiveSampler::FindSlot(absl::string_view name) const {
+  uint64_t hash = absl::Hash<absl::string_view>()(name);
+  if (hash == 0) hash = 1;
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    Slot* slot = &slots_[(hash + i) & (kNumSlots - 1)];
+    uint64_t slot_hash = slot->name_hash.load(std::memory_order_relaxed);
+    if (slot_hash == hash) return slot;
+    if (slot_hash != 0) continue;
+    // Reserve a name before claiming the slot, so that at most kMaxNames
+    // slots are used.
+    if (num_names_.fetch_add(1, std::memory_order_relaxed) >= kMaxNames) {
+      num_names_.fetch_sub(1, std::memory_order_relaxed);
+      break;
+    }
+    if (slot->name_hash.compare_exchange_strong(slot_hash, hash,
+                                                std::memory_order_relaxed)) {
+      // Recompute soon, so that the new name is not sampled in full for
+      // long.
+      const int64_t adjust_by =
+          absl::GetCurrentTimeNanos() + kNewNameAdjustDelayNanos;
+      int64_t next = next_adjust_nanos_.load(std::memory_order_relaxed);
+      while (adjust_by < next &&
+             !next_adjust_nanos_.compare_exchange_weak(
+                 next, adjust_by, std::memory_order_relaxed)) {
+      }
+      calls_until_clock_check = 0;
+      return slot;
+    }
+    num_names_.fetch_sub(1, std::memory_order_relaxed);
+    // Another thread claimed the slot; it may have been for this name.
+    if (slot_hash == hash) return slot;
+  }
+  return &slots_[kNumSlots];
+}
+
+double AdaptiveSampler::Probability(absl::string_view name) const {
+  return static_cast<double>(
+             FindSlot(name)->threshold.load(std::memory_order_relaxed)) /
+         static_cast<double>(UINT64_MAX);
+}
+
+void AdaptiveSampler::MaybeAdjust(int64_t now_nanos) const {
+  if (now_nanos < next_adjust_nanos_.load(std::memory_order_relaxed)) return;
+  if (adjusting_.exchange(true, std::memory_order_acquire)) return;
+  if (now_nanos >= next_adjust_nanos_.load(std::memory_order_relaxed)) {
+    Adjust(now_nanos);
+  }
+  adjusting_.store(false, std::memory_order_release);
+}
+
+void AdaptiveSampler::Adjust(int64_t now_nanos) const {
+  const double elapsed_seconds =
+      std::max<int64_t>(1, now_nanos - last_adjust_nanos_) * 1e-9;
+  last_adjust_nanos_ = now_nanos;
+  next_adjust_nanos_.store(now_nanos + kAdjustIntervalNanos,
+                           std::memory_order_relaxed);
+
+  // Update the rate estimates.
+  std::vector<Slot*> active;
+  active.reserve(kMaxNames);
+  for (size_t i = 0; i <= kNumSlots; ++i) {
+    Slot* slot = &slots_[i];
+    if (i < kNumSlots &&
+        slot->name_hash.load(std::memory_order_relaxed) == 0) {
+      continue;
+    }
+    const uint64_t calls = slot->calls.exchange(0, std::memory_order_relaxed);
+    if (i < kNumSlots) {
+      slot->idle_adjustments = calls == 0 ? slot->idle_adjustments + 1 : 0;
+      if (slot->idle_adjustments >= kIdleAdjustmentsBeforeFree) {
+        // Free the slot for another name. If the name returns while a later
+        // slot in its probe sequence is still in use, it briefly has two slots
+        // until the unused one is freed in turn.
+        slot->rate = -1;
+        slot->idle_adjustments = 0;
+        slot->threshold.store(UINT64_MAX, std::memory_order_relaxed);
+        slot->name_hash.store(0, std::memory_order_relaxed);
+        num_names_.fetch_sub(1, std::memory_order_relaxed);
+        continue;
+      }
+    }
+    const double rate = calls / elapsed_seconds;
+    slot->rate = slot->rate < 0 ? rate
+                                : kRateSmoothing * rate +
+                                      (1 - kRateSmoothing) * slot->rate;
+    if (slot->rate > 0) active.push_back(slot);
+  }
+
+  // Share the target fairly: visit names from the least to the most busy,
+  // giving each the lesser of its rate and an equal share of what remains.
+  std::sort(active.begin(), active.end(),
+            [](const Slot* a, const Slot* b) { return a->rate < b->rate; });
+  double remaining = target_traces_per_second_;
+  for (size_t i = 0; i < active.size(); ++i) {
+    Slot* slot = active[i];
+    const double fair_share = remaining / (active.size() - i);
+    double sampled_rate = std::min(slot->rate, fair_share);
+    remaining -= sampled_rate;
+    sampled_rate = std::max(
+        sampled_rate, std::min(slot->rate, min_traces_per_second_per_name_));
+    slot->threshold.store(CalculateThreshold(sampled_rate / slot->rate),
+                          std::memory_order_relaxed);
+  }
+}
+
 }  // namespace trace
 }  // namespace opencensus
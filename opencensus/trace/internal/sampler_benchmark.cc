@@ -0,0 +1,94 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/sampler.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+constexpr uint8_t kTraceId[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t kSpanId[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+void RunSampler(benchmark::State& state, const Sampler& sampler) {
+  const TraceId trace_id(kTraceId);
+  const SpanId span_id(kSpanId);
+  const std::vector<Span*> parent_links;
+  int64_t sampled = 0;
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    if (sampler.ShouldSample(nullptr, false, trace_id, span_id, "SpanName",
+                             parent_links)) {
+      ++sampled;
+    }
+  }
+  state.counters["sampled"] = sampled;
+}
+
+void BM_ProbabilitySampler(benchmark::State& state) {
+  static ProbabilitySampler sampler(1e-4);
+  RunSampler(state, sampler);
+}
+BENCHMARK(BM_ProbabilitySampler)->ThreadRange(1, 16)->UseRealTime();
+
+// All threads share one sampler, which is saturated almost immediately, so
+// this measures the cost of rejecting under contention.
+void BM_RateLimitingSampler(benchmark::State& state) {
+  static RateLimitingSampler sampler(100);
+  RunSampler(state, sampler);
+}
+BENCHMARK(BM_RateLimitingSampler)->ThreadRange(1, 16)->UseRealTime();
+
+// A rate high enough that most decisions take a token.
+void BM_RateLimitingSamplerUnsaturated(benchmark::State& state) {
+  static RateLimitingSampler sampler(1e9);
+  RunSampler(state, sampler);
+}
+BENCHMARK(BM_RateLimitingSamplerUnsaturated)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+// Samples root spans with one of kNumNames names.
+void BM_AdaptiveSampler(benchmark::State& state) {
+  static AdaptiveSampler sampler(100);
+  constexpr int kNumNames = 8;
+  static const char* const kNames[kNumNames] = {"A", "B", "C", "D",
+                                                "E", "F", "G", "H"};
+  const TraceId trace_id(kTraceId);
+  const SpanId span_id(kSpanId);
+  const std::vector<Span*> parent_links;
+  int i = state.thread_index();
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sampler.ShouldSample(
+        nullptr, false, trace_id, span_id, kNames[i++ % kNumNames],
+        parent_links));
+  }
+}
+BENCHMARK(BM_AdaptiveSampler)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
+
+BENCHMARK_MAIN();
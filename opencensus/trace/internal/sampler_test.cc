@@ -20,10 +20,32 @@
 #include "absl/time/clock.h"
 #include "gtest/gtest.h"
 #include "opencensus/trace/span.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+#include "opencensus/trace/trace_options.h"
 #include "opencensus/trace/trace_params.h"
 
 namespace opencensus {
 namespace trace {
+
+class AdaptiveSamplerTestPeer {
+ public:
+  // Recomputes the probabilities as if the interval ended at now.
+  static void Adjust(const AdaptiveSampler& sampler, absl::Time now) {
+    sampler.Adjust(absl::ToUnixNanos(now));
+  }
+
+  static double Probability(const AdaptiveSampler& sampler,
+                            absl::string_view name) {
+    return sampler.Probability(name);
+  }
+
+  static size_t NumNames(const AdaptiveSampler& sampler) {
+    return sampler.num_names_.load();
+  }
+};
+
 namespace {
 
 // Example of a stateful sampler class.
@@ -70,6 +92,171 @@ TEST(SamplerTest, SampleNth) {
   }
 }
 
+constexpr uint8_t kTraceId[] = {1, 2,  3,  4,  5,  6,  7,  8,
+                                9, 10, 11, 12, 13, 14, 15, 16};
+constexpr uint8_t kSpanId[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+TEST(RateLimitingSamplerTest, LimitsRootSpans) {
+  RateLimitingSampler sampler(10);
+  int sampled = 0;
+  for (int i = 0; i < 1000; ++i) {
+    auto span = Span::StartSpan("MySpan", nullptr, {&sampler});
+    if (span.IsSampled()) ++sampled;
+    span.End();
+  }
+  // The bucket starts full, with one second's worth of traces.
+  EXPECT_GE(sampled, 1);
+  EXPECT_LE(sampled, 11);
+}
+
+TEST(RateLimitingSamplerTest, Refills) {
+  RateLimitingSampler sampler(1000);
+  while (sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                              SpanId(kSpanId), "MySpan", {})) {
+  }
+  absl::SleepFor(absl::Milliseconds(20));
+  EXPECT_TRUE(sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                                   SpanId(kSpanId), "MySpan", {}));
+}
+
+TEST(RateLimitingSamplerTest, ZeroRateNeverSamples) {
+  RateLimitingSampler sampler(0);
+  EXPECT_FALSE(sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                                    SpanId(kSpanId), "MySpan", {}));
+}
+
+TEST(RateLimitingSamplerTest, TinyRateSamplesOnce) {
+  RateLimitingSampler sampler(1e-30);
+  EXPECT_TRUE(sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                                   SpanId(kSpanId), "MySpan", {}));
+  EXPECT_FALSE(sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                                    SpanId(kSpanId), "MySpan", {}));
+}
+
+TEST(RateLimitingSamplerTest, ChildrenFollowParent) {
+  RateLimitingSampler sampler(1);
+  const uint8_t sampled_options[] = {1};
+  const SpanContext sampled_parent{TraceId(kTraceId), SpanId(kSpanId),
+                                   TraceOptions(sampled_options)};
+  const SpanContext unsampled_parent{TraceId(kTraceId), SpanId(kSpanId)};
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(sampler.ShouldSample(&sampled_parent, false, TraceId(kTraceId),
+                                     SpanId(kSpanId), "MySpan", {}));
+    EXPECT_FALSE(sampler.ShouldSample(&unsampled_parent, true,
+                                      TraceId(kTraceId), SpanId(kSpanId),
+                                      "MySpan", {}));
+  }
+  // Children took no tokens.
+  EXPECT_TRUE(sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                                   SpanId(kSpanId), "MySpan", {}));
+}
+
+TEST(RateLimitingSamplerTest, AppliesProbability) {
+  RateLimitingSampler sampler(1000, 0.0);
+  EXPECT_FALSE(sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                                    SpanId(kSpanId), "MySpan", {}));
+}
+
+// Calls sampler.ShouldSample() count times for root spans named name.
+void RecordCalls(const AdaptiveSampler& sampler, absl::string_view name,
+                 int count) {
+  for (int i = 0; i < count; ++i) {
+    sampler.ShouldSample(nullptr, false, TraceId(kTraceId), SpanId(kSpanId),
+                         name, {});
+  }
+}
+
+TEST(AdaptiveSamplerTest, SharesTargetBetweenNames) {
+  AdaptiveSampler sampler(10);
+  const absl::Time start = absl::Now();
+  RecordCalls(sampler, "Hot", 10000);
+  RecordCalls(sampler, "Rare", 2);
+  AdaptiveSamplerTestPeer::Adjust(sampler, start + absl::Seconds(1));
+  // The rare name is sampled in full, and the hot one gets the remainder of
+  // the target.
+  EXPECT_DOUBLE_EQ(1.0, AdaptiveSamplerTestPeer::Probability(sampler, "Rare"));
+  EXPECT_NEAR(8.0 / 10000,
+              AdaptiveSamplerTestPeer::Probability(sampler, "Hot"), 2e-4);
+}
+
+TEST(AdaptiveSamplerTest, SplitsTargetEquallyBetweenBusyNames) {
+  AdaptiveSampler sampler(10);
+  const absl::Time start = absl::Now();
+  RecordCalls(sampler, "A", 1000);
+  RecordCalls(sampler, "B", 10000);
+  AdaptiveSamplerTestPeer::Adjust(sampler, start + absl::Seconds(1));
+  EXPECT_NEAR(5.0 / 1000, AdaptiveSamplerTestPeer::Probability(sampler, "A"),
+              5e-4);
+  EXPECT_NEAR(5.0 / 10000, AdaptiveSamplerTestPeer::Probability(sampler, "B"),
+              5e-5);
+}
+
+TEST(AdaptiveSamplerTest, MinimumPerName) {
+  AdaptiveSampler sampler(0, 1);
+  const absl::Time start = absl::Now();
+  RecordCalls(sampler, "Rare", 10);
+  RecordCalls(sampler, "Hot", 10000);
+  AdaptiveSamplerTestPeer::Adjust(sampler, start + absl::Seconds(1));
+  EXPECT_NEAR(1.0 / 10, AdaptiveSamplerTestPeer::Probability(sampler, "Rare"),
+              1e-2);
+  EXPECT_NEAR(1.0 / 10000,
+              AdaptiveSamplerTestPeer::Probability(sampler, "Hot"), 1e-5);
+}
+
+TEST(AdaptiveSamplerTest, NewNamesAreSampled) {
+  AdaptiveSampler sampler(0);
+  EXPECT_TRUE(sampler.ShouldSample(nullptr, false, TraceId(kTraceId),
+                                   SpanId(kSpanId), "New", {}));
+}
+
+TEST(AdaptiveSamplerTest, ChildrenFollowParent) {
+  AdaptiveSampler sampler(0);
+  const uint8_t sampled_options[] = {1};
+  const SpanContext sampled_parent{TraceId(kTraceId), SpanId(kSpanId),
+                                   TraceOptions(sampled_options)};
+  EXPECT_TRUE(sampler.ShouldSample(&sampled_parent, false, TraceId(kTraceId),
+                                   SpanId(kSpanId), "MySpan", {}));
+}
+
+TEST(AdaptiveSamplerTest, ManyNames) {
+  AdaptiveSampler sampler(10);
+  const absl::Time start = absl::Now();
+  for (int i = 0; i < 5000; ++i) {
+    RecordCalls(sampler, absl::StrCat("Name", i), 1);
+  }
+  AdaptiveSamplerTestPeer::Adjust(sampler, start + absl::Seconds(1));
+  // Names that don't have their own slot share one estimate.
+  const double probability =
+      AdaptiveSamplerTestPeer::Probability(sampler, "Name4999");
+  EXPECT_GT(probability, 0.0);
+  EXPECT_LT(probability, 1.0);
+}
+
+TEST(AdaptiveSamplerTest, TracksAtMost1024Names) {
+  AdaptiveSampler sampler(10);
+  for (int i = 0; i < 5000; ++i) {
+    RecordCalls(sampler, absl::StrCat("Name", i), 1);
+  }
+  EXPECT_EQ(1024, AdaptiveSamplerTestPeer::NumNames(sampler));
+}
+
+TEST(AdaptiveSamplerTest, FreesIdleNames) {
+  AdaptiveSampler sampler(10);
+  absl::Time now = absl::Now();
+  RecordCalls(sampler, "Old", 1);
+  EXPECT_EQ(1, AdaptiveSamplerTestPeer::NumNames(sampler));
+  // The first adjustment counts the call, and the next 60 see none.
+  for (int i = 0; i < 61; ++i) {
+    now += absl::Seconds(1);
+    AdaptiveSamplerTestPeer::Adjust(sampler, now);
+  }
+  EXPECT_EQ(0, AdaptiveSamplerTestPeer::NumNames(sampler));
+  // A name seen again is sampled in full until the next adjustment.
+  RecordCalls(sampler, "Old", 1);
+  EXPECT_EQ(1, AdaptiveSamplerTestPeer::NumNames(sampler));
+  EXPECT_DOUBLE_EQ(1.0, AdaptiveSamplerTestPeer::Probability(sampler, "Old"));
+}
+
 }  // namespace
 }  // namespace trace
 }  // namespace opencensus
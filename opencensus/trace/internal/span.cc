@@ -12,13 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/block_pool.h"
 #include "opencensus/common/internal/random.h"
+#include "opencensus/common/internal/rcu.h"
+#include "opencensus/common/internal/tsc_clock.h"
 #include "opencensus/trace/exporter/annotation.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 #include "opencensus/trace/exporter/link.h"
@@ -29,6 +35,8 @@
 #include "opencensus/trace/internal/running_span_store_impl.h"
 #include "opencensus/trace/internal/span_exporter_impl.h"
 #include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/internal/span_metrics_impl.h"
+#include "opencensus/trace/internal/tail_sampler_impl.h"
 #include "opencensus/trace/internal/trace_config_impl.h"
 #include "opencensus/trace/sampler.h"
 #include "opencensus/trace/span.h"
@@ -38,11 +46,15 @@
 #include "opencensus/trace/trace_id.h"
 #include "opencensus/trace/trace_options.h"
 #include "opencensus/trace/trace_params.h"
+#include "opencensus/trace/with_span.h"
 
 namespace opencensus {
 namespace trace {
 namespace {
 
+// Span::metrics_status_ once a Span that is not recording has ended.
+constexpr uint8_t kMetricsEnded = 0xff;
+
 // Generates a random SpanId.
 SpanId GenerateRandomSpanId() {
   uint8_t span_id_buf[SpanId::kSize];
@@ -59,6 +71,41 @@ TraceId GenerateRandomTraceId() {
   return TraceId(trace_id_buf);
 }
 
+// Allocates the SpanImpl and its shared_ptr control block together, in a
+// pooled block that is recycled when the last reference (held by a Span, a
+// span store or the exporter) is released.
+template <typename T>
+class SpanImplAllocator {
+ public:
+  using value_type = T;
+
+  SpanImplAllocator() = default;
+  template <typename U>
+  SpanImplAllocator(const SpanImplAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    if (n != 1) return std::allocator<T>().allocate(n);
+    return static_cast<T*>(common::BlockPool<sizeof(T)>::Allocate());
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (n != 1) return std::allocator<T>().deallocate(ptr, n);
+    common::BlockPool<sizeof(T)>::Free(ptr);
+  }
+
+  template <typename U>
+  bool operator==(const SpanImplAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const SpanImplAllocator<U>&) const {
+    return false;
+  }
+};
+
+static_assert(alignof(SpanImpl) <= alignof(std::max_align_t),
+              "BlockPool blocks are not sufficiently aligned for SpanImpl.");
+
 }  // namespace
 
 class SpanGenerator {
@@ -84,45 +131,82 @@ class SpanGenerator {
             parent_ctx, has_remote_parent, trace_id, span_id, name,
             options.parent_links);
       } else {
+        common::RcuReadLock lock;
         should_sample =
-            TraceConfigImpl::Get()->current_trace_params().sampler.ShouldSample(
-                parent_ctx, has_remote_parent, trace_id, span_id, name,
-                options.parent_links);
+            TraceConfigImpl::Get()
+                ->current_trace_params(lock)
+                ->sampler->ShouldSample(parent_ctx, has_remote_parent,
+                                        trace_id, span_id, name,
+                                        options.parent_links);
       }
       trace_options.SetSampled(should_sample);
     }
     SpanContext context(trace_id, span_id, trace_options);
-    SpanImpl* impl = nullptr;
-    if (trace_options.IsSampled()) {
-      // Only Spans that are sampled are backed by a SpanImpl.
-      impl =
-          new SpanImpl(context, TraceConfigImpl::Get()->current_trace_params(),
-                       name, parent_span_id, has_remote_parent);
+    const SpanMetricsEntry* metrics_entry =
+        SpanMetricsImpl::Enabled() ? SpanMetricsImpl::Get()->GetEntry(name)
+                                   : nullptr;
+    if (!trace_options.IsSampled() && !exporter::TailSamplerImpl::Enabled()) {
+      // Fast path for the common case: unsampled Spans have no SpanImpl, so
+      // the only remaining work is linking them to their parent links.
+      for (const auto& parent_link : options.parent_links) {
+        parent_link->AddChildLink(context);
+      }
+      return Span(context, metrics_entry);
+    }
+    // Only Spans that are sampled, or recorded for tail sampling, are backed
+    // by a SpanImpl.
+    std::shared_ptr<SpanImpl> impl;
+    {
+      common::RcuReadLock lock;
+      impl = std::allocate_shared<SpanImpl>(
+          SpanImplAllocator<SpanImpl>(), context,
+          TraceConfigImpl::Get()->current_trace_params(lock)->params, name,
+          parent_span_id, has_remote_parent, options.record_resource_usage);
     }
     // Add links.
     for (const auto& parent_link : options.parent_links) {
-      if (impl) {
-        impl->AddLink(parent_link->context(),
-                      exporter::Link::Type::kParentLinkedSpan,
-                      /*attributes=*/{});
-      }
+      impl->AddLink(parent_link->context(),
+                    exporter::Link::Type::kParentLinkedSpan,
+                    /*attributes=*/{});
       parent_link->AddChildLink(context);
     }
-    return Span(context, impl);
+    return Span(context, std::move(impl), metrics_entry);
   }
 };
 
 Span Span::BlankSpan() { return Span(); }
 
+Span::Span(const Span& other)
+    : context_(other.context_),
+      span_impl_(other.span_impl_),
+      metrics_entry_(other.metrics_entry_),
+      metrics_start_ticks_(other.metrics_start_ticks_),
+      metrics_status_(
+          other.metrics_status_.load(std::memory_order_relaxed)) {}
+
+Span::Span(Span&& other)
+    : context_(other.context_),
+      span_impl_(std::move(other.span_impl_)),
+      metrics_entry_(other.metrics_entry_),
+      metrics_start_ticks_(other.metrics_start_ticks_),
+      metrics_status_(
+          other.metrics_status_.load(std::memory_order_relaxed)) {}
+
 Span Span::StartSpan(absl::string_view name, const Span* parent,
                      const StartSpanOptions& options) {
-  SpanContext parent_ctx;
-  if (parent != nullptr) {
-    parent_ctx = parent->context();
-  }
-  return SpanGenerator::Generate(name,
-                                 (parent == nullptr) ? nullptr : &parent_ctx,
-                                 /*has_remote_parent=*/false, options);
+  return SpanGenerator::Generate(
+      name, (parent == nullptr) ? nullptr : &parent->context(),
+      /*has_remote_parent=*/false, options);
+}
+
+Span Span::StartSpanWithCurrentParent(absl::string_view name,
+                                      const StartSpanOptions& options) {
+  const Span* parent = WithSpan::current();
+  return SpanGenerator::Generate(
+      name,
+      (parent == nullptr || !parent->context().IsValid()) ? nullptr
+                                                          : &parent->context(),
+      /*has_remote_parent=*/false, options);
 }
 
 Span Span::StartSpanWithRemoteParent(absl::string_view name,
@@ -132,9 +216,21 @@ Span Span::StartSpanWithRemoteParent(absl::string_view name,
                                  /*has_remote_parent=*/true, options);
 }
 
-Span::Span(const SpanContext& context, SpanImpl* impl)
-    : context_(context), span_impl_(impl) {
-  if (IsRecording()) {
+Span::Span(const SpanContext& context,
+           const SpanMetricsEntry* metrics_entry)
+    : context_(context),
+      metrics_entry_(metrics_entry),
+      metrics_start_ticks_(
+          metrics_entry == nullptr ? 0 : common::TscClock::Now()) {}
+
+Span::Span(const SpanContext& context, std::shared_ptr<SpanImpl> impl,
+           const SpanMetricsEntry* metrics_entry)
+    : context_(context),
+      span_impl_(std::move(impl)),
+      metrics_entry_(metrics_entry) {
+  // Spans recorded only for tail sampling are kept out of the span stores,
+  // since they may never be exported.
+  if (IsRecording() && IsSampled()) {
     exporter::RunningSpanStoreImpl::Get()->AddSpan(span_impl_);
   }
 }
@@ -197,6 +293,12 @@ void Span::AddChildLink(const SpanContext& child_ctx,
 void Span::SetStatus(StatusCode canonical_code, absl::string_view message) {
   if (IsRecording()) {
     span_impl_->SetStatus(exporter::Status(canonical_code, message));
+  } else if (metrics_entry_ != nullptr) {
+    uint8_t status = metrics_status_.load(std::memory_order_relaxed);
+    while (status != kMetricsEnded &&
+           !metrics_status_.compare_exchange_weak(status, canonical_code,
+                                                  std::memory_order_relaxed)) {
+    }
   }
 }
 
@@ -206,9 +308,24 @@ void Span::End() {
       // In non-debug builds, ignore the second End().
       return;
     }
-    exporter::RunningSpanStoreImpl::Get()->RemoveSpan(span_impl_);
-    exporter::LocalSpanStoreImpl::Get()->AddSpan(span_impl_);
-    exporter::SpanExporterImpl::Get()->AddSpan(span_impl_);
+    if (metrics_entry_ != nullptr) {
+      SpanMetricsImpl::Get()->Record(*metrics_entry_, *span_impl_);
+    }
+    if (IsSampled()) {
+      exporter::RunningSpanStoreImpl::Get()->RemoveSpan(span_impl_);
+      exporter::LocalSpanStoreImpl::Get()->AddSpan(span_impl_);
+      exporter::SpanExporterImpl::Get()->AddSpan(span_impl_);
+    } else {
+      exporter::TailSamplerImpl::Get()->AddSpan(span_impl_);
+    }
+  } else if (metrics_entry_ != nullptr) {
+    const uint8_t status =
+        metrics_status_.exchange(kMetricsEnded, std::memory_order_relaxed);
+    if (status == kMetricsEnded) return;
+    SpanMetricsImpl::Get()->Record(
+        *metrics_entry_, static_cast<StatusCode>(status),
+        common::TscClock::ToDuration(common::TscClock::Now() -
+                                     metrics_start_ticks_));
   }
 }
 
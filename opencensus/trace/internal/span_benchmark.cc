@@ -12,14 +12,39 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/trace/exporter/span_exporter.h"
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_metrics.h"
+#include "opencensus/trace/trace_config.h"
+#include "opencensus/trace/with_span.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+class SpanExporterTestPeer {
+ public:
+  static void ExportForTesting() { SpanExporter::ExportForTesting(); }
+};
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
 
 namespace {
 
 void BM_StartEndSpan(benchmark::State& state) {
   static ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     auto span = ::opencensus::trace::Span::StartSpan(
         "SpanName", /*parent=*/nullptr, {&sampler});
@@ -28,8 +53,147 @@ void BM_StartEndSpan(benchmark::State& state) {
 }
 BENCHMARK(BM_StartEndSpan);
 
+void BM_StartEndSpanWithResourceUsage(benchmark::State& state) {
+  static ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::common::AllocationCounter allocations(&state);
+  while (state.KeepRunning()) {
+    auto span = ::opencensus::trace::Span::StartSpan(
+        "SpanName", /*parent=*/nullptr,
+        {&sampler, {}, /*record_resource_usage=*/true});
+    span.End();
+  }
+}
+BENCHMARK(BM_StartEndSpanWithResourceUsage);
+
+// Starts and ends a child span using the default sampler, which is set to
+// never sample. If the argument is 0 the parent is not sampled, so the child
+// takes the unsampled fast path; otherwise the parent is sampled and so is the
+// child.
+void BM_StartEndChildSpan(benchmark::State& state) {
+  static ::opencensus::trace::AlwaysSampler always_sampler;
+  static ::opencensus::trace::NeverSampler never_sampler;
+  ::opencensus::trace::TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ::opencensus::trace::ProbabilitySampler(0.0)});
+  auto parent = ::opencensus::trace::Span::StartSpan(
+      "ParentSpan", /*parent=*/nullptr,
+      {state.range(0) != 0
+           ? static_cast<::opencensus::trace::Sampler*>(&always_sampler)
+           : &never_sampler});
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    auto span = ::opencensus::trace::Span::StartSpan("SpanName", &parent);
+    span.End();
+  }
+  parent.End();
+  ::opencensus::trace::TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ::opencensus::trace::ProbabilitySampler(1e-4)});
+}
+BENCHMARK(BM_StartEndChildSpan)->Arg(0)->Arg(1);
+
+// Starts and ends a root span that the default sampler does not sample.
+void BM_StartEndUnsampledRootSpan(benchmark::State& state) {
+  ::opencensus::trace::TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ::opencensus::trace::ProbabilitySampler(0.0)});
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    auto span = ::opencensus::trace::Span::StartSpan("SpanName");
+    span.End();
+  }
+  ::opencensus::trace::TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ::opencensus::trace::ProbabilitySampler(1e-4)});
+}
+BENCHMARK(BM_StartEndUnsampledRootSpan);
+
+void BM_BlankSpan(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    auto span = ::opencensus::trace::Span::BlankSpan();
+    span.AddAttribute("key", "value");
+    span.End();
+    benchmark::DoNotOptimize(span.context());
+  }
+}
+BENCHMARK(BM_BlankSpan);
+
+// Starts and ends a span with span metrics enabled. The span is sampled if the
+// argument is not 0.
+void BM_StartEndSpanWithMetrics(benchmark::State& state) {
+  static ::opencensus::trace::AlwaysSampler always_sampler;
+  static ::opencensus::trace::NeverSampler never_sampler;
+  ::opencensus::trace::Sampler* sampler =
+      state.range(0) != 0
+          ? static_cast<::opencensus::trace::Sampler*>(&always_sampler)
+          : &never_sampler;
+  ::opencensus::trace::SpanMetrics::Enable();
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    auto span = ::opencensus::trace::Span::StartSpan(
+        "SpanName", /*parent=*/nullptr, {sampler});
+    span.End();
+  }
+  ::opencensus::trace::SpanMetrics::Disable();
+}
+BENCHMARK(BM_StartEndSpanWithMetrics)->Arg(0)->Arg(1);
+
+// Makes a span current, and starts and ends a child of it. The parent is
+// sampled if the argument is not 0, as in BM_StartEndChildSpan.
+void BM_StartEndChildOfCurrentSpan(benchmark::State& state) {
+  static ::opencensus::trace::AlwaysSampler always_sampler;
+  static ::opencensus::trace::NeverSampler never_sampler;
+  ::opencensus::trace::TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ::opencensus::trace::ProbabilitySampler(0.0)});
+  auto parent = ::opencensus::trace::Span::StartSpan(
+      "ParentSpan", /*parent=*/nullptr,
+      {state.range(0) != 0
+           ? static_cast<::opencensus::trace::Sampler*>(&always_sampler)
+           : &never_sampler});
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    ::opencensus::trace::WithSpan ws(parent);
+    auto span =
+        ::opencensus::trace::Span::StartSpanWithCurrentParent("SpanName");
+    span.End();
+  }
+  parent.End();
+  ::opencensus::trace::TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ::opencensus::trace::ProbabilitySampler(1e-4)});
+}
+BENCHMARK(BM_StartEndChildOfCurrentSpan)->Arg(0)->Arg(1);
+
+void BM_WithSpan(benchmark::State& state) {
+  auto span = ::opencensus::trace::Span::BlankSpan();
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    ::opencensus::trace::WithSpan ws(span);
+    benchmark::DoNotOptimize(&ws);
+  }
+}
+BENCHMARK(BM_WithSpan);
+
+// Like BM_StartEndSpan, with running spans tracked as specified by the
+// argument (a RunningSpanTracking).
+void BM_StartEndSpanWithRunningSpanTracking(benchmark::State& state) {
+  static ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::trace::TraceConfig::SetRunningSpanTracking(
+      static_cast<::opencensus::trace::RunningSpanTracking>(state.range(0)));
+  ::opencensus::common::AllocationCounter allocations(&state);
+  while (state.KeepRunning()) {
+    auto span = ::opencensus::trace::Span::StartSpan(
+        "SpanName", /*parent=*/nullptr, {&sampler});
+    span.End();
+  }
+  ::opencensus::trace::TraceConfig::SetRunningSpanTracking(
+      ::opencensus::trace::RunningSpanTracking::kSharded);
+}
+BENCHMARK(BM_StartEndSpanWithRunningSpanTracking)
+    ->Arg(static_cast<int>(::opencensus::trace::RunningSpanTracking::kDisabled))
+    ->Arg(static_cast<int>(::opencensus::trace::RunningSpanTracking::kSharded))
+    ->Arg(static_cast<int>(
+        ::opencensus::trace::RunningSpanTracking::kPerThreadLists));
+
 void BM_StartEndSpanAndAddAttribute(benchmark::State& state) {
   static ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     auto span = ::opencensus::trace::Span::StartSpan(
         "SpanName", /*parent=*/nullptr, {&sampler});
@@ -41,6 +205,7 @@ BENCHMARK(BM_StartEndSpanAndAddAttribute);
 
 void BM_StartEndSpanAndAddAnnotation(benchmark::State& state) {
   static ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     auto span = ::opencensus::trace::Span::StartSpan(
         "SpanName", /*parent=*/nullptr, {&sampler});
@@ -52,6 +217,7 @@ BENCHMARK(BM_StartEndSpanAndAddAnnotation);
 
 void BM_StartEndSpanAndAddMessageEvent(benchmark::State& state) {
   static ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     auto span = ::opencensus::trace::Span::StartSpan(
         "SpanName", /*parent=*/nullptr, {&sampler});
@@ -68,6 +234,7 @@ void BM_StartEndSpanAndAddLink(benchmark::State& state) {
   constexpr uint8_t span_id[] = {1, 2, 3, 4, 5, 6, 7, 8};
   ::opencensus::trace::SpanContext ctx{::opencensus::trace::TraceId(trace_id),
                                        ::opencensus::trace::SpanId(span_id)};
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     auto span = ::opencensus::trace::Span::StartSpan(
         "SpanName", /*parent=*/nullptr, {&sampler});
@@ -79,6 +246,7 @@ BENCHMARK(BM_StartEndSpanAndAddLink);
 
 void BM_StartEndSpanAndSetStatus(benchmark::State& state) {
   static ::opencensus::trace::AlwaysSampler sampler;
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     auto span = ::opencensus::trace::Span::StartSpan(
         "SpanName", /*parent=*/nullptr, {&sampler});
@@ -89,5 +257,54 @@ void BM_StartEndSpanAndSetStatus(benchmark::State& state) {
 }
 BENCHMARK(BM_StartEndSpanAndSetStatus);
 
+// Starts a span, adds the given number of attributes, annotations and message
+// events, and ends it.
+void BM_StartEndSpanWithEvents(benchmark::State& state) {
+  static ::opencensus::trace::AlwaysSampler sampler;
+  const int events = state.range(0);
+  std::vector<std::string> keys;
+  for (int i = 0; i < events; ++i) keys.push_back(absl::StrCat("key", i));
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    auto span = ::opencensus::trace::Span::StartSpan(
+        "SpanName", /*parent=*/nullptr, {&sampler});
+    for (int i = 0; i < events; ++i) {
+      span.AddAttribute(keys[i], i);
+      span.AddAnnotation("This is an annotation.");
+      span.AddSentMessageEvent(i, 456, 789);
+    }
+    span.End();
+  }
+}
+BENCHMARK(BM_StartEndSpanWithEvents)->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+
+// Ends a span with 32 attributes and 32 annotations and converts it to
+// SpanData for export. If the argument is 0, the Span handle is released before
+// the export, so that the exporter holds the last reference and moves the span
+// contents into SpanData. Otherwise, the handle is held and the contents are
+// copied.
+void BM_EndToExport(benchmark::State& state) {
+  static ::opencensus::trace::AlwaysSampler sampler;
+  const bool hold_handle = state.range(0) != 0;
+  std::vector<std::string> keys;
+  for (int i = 0; i < 32; ++i) keys.push_back(absl::StrCat("key", i));
+  // Discard spans buffered by other benchmarks.
+  ::opencensus::trace::exporter::SpanExporterTestPeer::ExportForTesting();
+  ::opencensus::common::AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    auto span = absl::make_unique<::opencensus::trace::Span>(
+        ::opencensus::trace::Span::StartSpan("SpanName", /*parent=*/nullptr,
+                                             {&sampler}));
+    for (int i = 0; i < 32; ++i) {
+      span->AddAttribute(keys[i], i);
+      span->AddAnnotation("This is an annotation.");
+    }
+    span->End();
+    if (!hold_handle) span.reset();
+    ::opencensus::trace::exporter::SpanExporterTestPeer::ExportForTesting();
+  }
+}
+BENCHMARK(BM_EndToExport)->Arg(0)->Arg(1);
+
 }  // namespace
 BENCHMARK_MAIN();
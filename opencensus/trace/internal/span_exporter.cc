@@ -14,10 +14,12 @@
 
 #include "opencensus/trace/exporter/span_exporter.h"
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 
 #include "opencensus/trace/internal/span_exporter_impl.h"
+#include "opencensus/trace/internal/tail_sampler_impl.h"
 
 namespace opencensus {
 namespace trace {
@@ -25,7 +27,47 @@ namespace exporter {
 
 // static
 void SpanExporter::RegisterHandler(std::unique_ptr<Handler> handler) {
-  SpanExporterImpl::Get()->RegisterHandler(std::move(handler));
+  SpanExporterImpl::Get()->RegisterHandler(std::move(handler),
+                                           HandlerOptions());
+}
+
+// static
+void SpanExporter::RegisterHandler(std::unique_ptr<Handler> handler,
+                                   const HandlerOptions& options) {
+  SpanExporterImpl::Get()->RegisterHandler(std::move(handler), options);
+}
+
+// static
+void SpanExporter::SetConversionThreads(int threads) {
+  SpanExporterImpl::Get()->SetConversionThreads(threads);
+}
+
+// static
+void SpanExporter::SetBufferOptions(const BufferOptions& options) {
+  SpanExporterImpl::Get()->SetBufferOptions(options);
+}
+
+// static
+uint64_t SpanExporter::DroppedSpanCount() {
+  return SpanExporterImpl::Get()->dropped_span_count();
+}
+
+// static
+uint64_t SpanExporter::DroppedBatchCount() {
+  return SpanExporterImpl::Get()->dropped_batch_count();
+}
+
+// static
+void SpanExporter::EnableTailSampling(const TailSamplingOptions& options) {
+  TailSamplerImpl::Get()->Enable(options);
+}
+
+// static
+void SpanExporter::DisableTailSampling() { TailSamplerImpl::Get()->Disable(); }
+
+// static
+SpanExporter::TailSamplingStats SpanExporter::GetTailSamplingStats() {
+  return TailSamplerImpl::Get()->GetStats();
 }
 
 // static
@@ -14,9 +14,19 @@
 
 #include "opencensus/trace/internal/span_exporter_impl.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/export_worker.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/exporter/span_exporter.h"
 
@@ -24,6 +34,65 @@ namespace opencensus {
 namespace trace {
 namespace exporter {
 
+namespace {
+
+// Batches are only split between conversion threads if each thread gets at
+// least this many spans.
+constexpr size_t kMinSpansPerConversionTask = 16;
+
+}  // namespace
+
+ConversionPool::ConversionPool(int threads) {
+  for (int i = 0; i < threads; ++i) {
+    threads_.emplace_back(&ConversionPool::RunHelperLoop, this);
+  }
+}
+
+ConversionPool::~ConversionPool() {
+  {
+    absl::MutexLock l(&mu_);
+    shutdown_ = true;
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ConversionPool::ParallelFor(int n, const std::function<void(int)>& fn) {
+  absl::MutexLock l(&mu_);
+  fn_ = &fn;
+  next_ = 0;
+  end_ = n;
+  completed_ = 0;
+  RunTasks();
+  mu_.Await(absl::Condition(this, &ConversionPool::IsDone));
+  fn_ = nullptr;
+}
+
+bool ConversionPool::HasWork() const { return shutdown_ || next_ < end_; }
+
+bool ConversionPool::IsDone() const { return completed_ == end_; }
+
+void ConversionPool::RunTasks() {
+  while (next_ < end_) {
+    const int i = next_++;
+    const std::function<void(int)>* fn = fn_;
+    mu_.Unlock();
+    (*fn)(i);
+    mu_.Lock();
+    ++completed_;
+  }
+}
+
+void ConversionPool::RunHelperLoop() {
+  absl::MutexLock l(&mu_);
+  while (true) {
+    mu_.Await(absl::Condition(this, &ConversionPool::HasWork));
+    if (shutdown_) return;
+    RunTasks();
+  }
+}
+
 SpanExporterImpl* SpanExporterImpl::span_exporter_ = nullptr;
 
 SpanExporterImpl* SpanExporterImpl::Get() {
@@ -35,21 +104,111 @@ SpanExporterImpl* SpanExporterImpl::Get() {
 // Create detached worker thread
 SpanExporterImpl::SpanExporterImpl(uint32_t buffer_size,
                                    absl::Duration interval)
-    : buffer_size_(buffer_size), interval_(interval) {}
+    : buffer_size_(buffer_size), interval_(interval) {
+  SpanExporter::BufferOptions options;
+  buffers_.emplace_back(new SpanBuffer(options.capacity));
+  buffer_.store(buffers_.back().get(), std::memory_order_release);
+  overflow_policy_.store(options.overflow_policy, std::memory_order_relaxed);
+}
 
 void SpanExporterImpl::RegisterHandler(
-    std::unique_ptr<SpanExporter::Handler> handler) {
+    std::unique_ptr<SpanExporter::Handler> handler,
+    const SpanExporter::HandlerOptions& options) {
   absl::MutexLock l(&handler_mu_);
-  handlers_.emplace_back(std::move(handler));
+  std::shared_ptr<SpanExporter::Handler> shared_handler = std::move(handler);
+  common::ExportWorker<std::vector<SpanData>>::Options worker_options;
+  worker_options.max_queued = options.max_queued_batches;
+  worker_options.drop_oldest =
+      options.overflow_policy ==
+      SpanExporter::HandlerOptions::OverflowPolicy::kDropOldest;
+  workers_.push_back(
+      absl::make_unique<common::ExportWorker<std::vector<SpanData>>>(
+          [shared_handler](const std::vector<SpanData>& batch) {
+            shared_handler->Export(batch);
+          },
+          [this] { dropped_batches_.fetch_add(1, std::memory_order_relaxed); },
+          worker_options));
   if (!thread_started_) {
     StartExportThread();
   }
 }
 
+void SpanExporterImpl::SetConversionThreads(int threads) {
+  absl::MutexLock l(&conversion_mu_);
+  const int helpers = std::max(threads - 1, 0);
+  if (helpers == (conversion_pool_ ? conversion_pool_->threads() : 0)) {
+    return;
+  }
+  conversion_pool_.reset();
+  if (helpers > 0) {
+    conversion_pool_ = absl::make_unique<ConversionPool>(helpers);
+  }
+}
+
+void SpanExporterImpl::SetBufferOptions(
+    const SpanExporter::BufferOptions& options) {
+  overflow_policy_.store(options.overflow_policy, std::memory_order_relaxed);
+  absl::MutexLock l(&buffers_mu_);
+  const size_t capacity = options.capacity < 0 ? 0 : options.capacity;
+  if (SpanBuffer::CapacityFor(capacity) ==
+      buffer_.load(std::memory_order_relaxed)->capacity()) {
+    return;
+  }
+  buffers_.emplace_back(new SpanBuffer(capacity));
+  // Sequentially consistent with the load in AddSpan(), so that a producer
+  // that DrainBuffers() does not count sees the new buffer.
+  buffer_.store(buffers_.back().get(), std::memory_order_seq_cst);
+}
+
 void SpanExporterImpl::AddSpan(
     const std::shared_ptr<opencensus::trace::SpanImpl>& span_impl) {
-  absl::MutexLock l(&span_mu_);
-  spans_.emplace_back(span_impl);
+  producers_.fetch_add(1, std::memory_order_seq_cst);
+  SpanBuffer* buffer = buffer_.load(std::memory_order_seq_cst);
+  const bool wake = PushSpan(buffer, span_impl) &&
+                    buffer->size() >= buffer_size_;
+  producers_.fetch_sub(1, std::memory_order_release);
+  if (wake) RequestWake();
+}
+
+void SpanExporterImpl::AddTailSampledSpans(std::vector<SpanData>&& spans) {
+  const size_t capacity = buffer_.load(std::memory_order_acquire)->capacity();
+  bool wake;
+  {
+    absl::MutexLock l(&tail_sampled_mu_);
+    for (auto& span : spans) {
+      if (tail_sampled_spans_.size() >= capacity) {
+        dropped_spans_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      tail_sampled_spans_.push_back(std::move(span));
+    }
+    wake = tail_sampled_spans_.size() >= buffer_size_;
+  }
+  if (wake) RequestWake();
+}
+
+void SpanExporterImpl::RequestWake() {
+  if (!wake_requested_.load(std::memory_order_relaxed) &&
+      !wake_requested_.exchange(true, std::memory_order_acq_rel)) {
+    // Releasing wake_mu_ makes the export thread re-evaluate WakeRequested().
+    absl::MutexLock l(&wake_mu_);
+  }
+}
+
+bool SpanExporterImpl::PushSpan(
+    SpanBuffer* buffer, std::shared_ptr<opencensus::trace::SpanImpl> span) {
+  while (!buffer->TryPush(std::move(span))) {
+    if (overflow_policy_.load(std::memory_order_relaxed) ==
+        SpanExporter::BufferOptions::OverflowPolicy::kDropNewest) {
+      dropped_spans_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    std::shared_ptr<opencensus::trace::SpanImpl> oldest;
+    if (buffer->TryPop(&oldest)) {
+      dropped_spans_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  return true;
 }
 
 void SpanExporterImpl::StartExportThread() {
@@ -57,58 +216,132 @@ void SpanExporterImpl::StartExportThread() {
   thread_started_ = true;
 }
 
-bool SpanExporterImpl::IsBufferFull() const {
-  span_mu_.AssertHeld();
-  return spans_.size() >= buffer_size_;
+void SpanExporterImpl::DrainBuffers(
+    std::vector<std::shared_ptr<opencensus::trace::SpanImpl>>* batch) {
+  absl::MutexLock l(&buffers_mu_);
+  // If no producer is in AddSpan() now, any later one loads the current
+  // buffer, so the replaced buffers are drained for the last time.
+  const bool free_replaced = buffers_.size() > 1 &&
+                             producers_.load(std::memory_order_seq_cst) == 0;
+  for (const auto& buffer : buffers_) {
+    // Bound the number of pops so that a steady stream of new spans cannot
+    // keep the export thread here.
+    std::shared_ptr<opencensus::trace::SpanImpl> span;
+    for (size_t n = buffer->size(); n > 0 && buffer->TryPop(&span); --n) {
+      batch->emplace_back(std::move(span));
+    }
+  }
+  if (free_replaced) buffers_.erase(buffers_.begin(), buffers_.end() - 1);
+}
+
+std::vector<SpanData> SpanExporterImpl::ConvertSpans(
+    std::vector<std::shared_ptr<opencensus::trace::SpanImpl>>* spans) {
+  std::vector<SpanData> span_data;
+  {
+    absl::MutexLock l(&conversion_mu_);
+    const size_t tasks =
+        conversion_pool_ == nullptr
+            ? 1
+            : std::min<size_t>(conversion_pool_->threads() + 1,
+                               spans->size() / kMinSpansPerConversionTask);
+    if (tasks <= 1) {
+      ConvertSpanRange(spans, 0, spans->size(), &span_data);
+    } else {
+      // Each task converts a contiguous range of spans into its own vector.
+      std::vector<std::vector<SpanData>> task_data(tasks);
+      const size_t spans_per_task = (spans->size() + tasks - 1) / tasks;
+      conversion_pool_->ParallelFor(tasks, [&](int task) {
+        const size_t begin = task * spans_per_task;
+        ConvertSpanRange(spans, begin,
+                         std::min(begin + spans_per_task, spans->size()),
+                         &task_data[task]);
+      });
+      span_data.reserve(spans->size());
+      for (auto& data : task_data) {
+        std::move(data.begin(), data.end(), std::back_inserter(span_data));
+      }
+    }
+  }
+  spans->clear();
+  return span_data;
+}
+
+// static
+void SpanExporterImpl::ConvertSpanRange(
+    std::vector<std::shared_ptr<opencensus::trace::SpanImpl>>* spans,
+    size_t begin, size_t end, std::vector<SpanData>* span_data) {
+  span_data->reserve(span_data->size() + end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    std::shared_ptr<opencensus::trace::SpanImpl>& span = (*spans)[i];
+    // Once the span has ended, only stores (which convert it) and Span handles
+    // (which cannot change or read its contents) hold references. If this is
+    // the only reference, nothing else can convert the span, so its contents
+    // can be moved instead of copied.
+    if (span.use_count() == 1) {
+      span_data->emplace_back(span->ConsumeToSpanData());
+    } else {
+      span_data->emplace_back(span->ToSpanData());
+    }
+  }
 }
 
 void SpanExporterImpl::RunWorkerLoop() {
-  std::vector<opencensus::trace::exporter::SpanData> span_data_;
   std::vector<std::shared_ptr<opencensus::trace::SpanImpl>> batch_;
   // Thread loops forever.
   // TODO: Add in shutdown mechanism.
   absl::Time next_forced_export_time = absl::Now() + interval_;
   while (true) {
     {
-      absl::MutexLock l(&span_mu_);
+      absl::MutexLock l(&wake_mu_);
       // Wait until batch is full or interval time has been exceeded.
-      span_mu_.AwaitWithDeadline(
-          absl::Condition(this, &SpanExporterImpl::IsBufferFull),
+      wake_mu_.AwaitWithDeadline(
+          absl::Condition(this, &SpanExporterImpl::WakeRequested),
           next_forced_export_time);
-      next_forced_export_time = absl::Now() + interval_;
-      if (spans_.empty()) {
-        continue;
-      }
-      std::swap(batch_, spans_);
     }
-    for (const auto& span : batch_) {
-      span_data_.emplace_back(span->ToSpanData());
+    next_forced_export_time = absl::Now() + interval_;
+    wake_requested_.store(false, std::memory_order_release);
+    DrainBuffers(&batch_);
+    std::vector<SpanData> span_data = ConvertSpans(&batch_);
+    TakeTailSampledSpans(&span_data);
+    if (span_data.empty()) {
+      continue;
     }
-    batch_.clear();
-    Export(span_data_);
-    span_data_.clear();
+    Export(std::move(span_data));
+  }
+}
+
+void SpanExporterImpl::TakeTailSampledSpans(std::vector<SpanData>* span_data) {
+  absl::MutexLock l(&tail_sampled_mu_);
+  if (span_data->empty()) {
+    span_data->swap(tail_sampled_spans_);
+    return;
   }
+  std::move(tail_sampled_spans_.begin(), tail_sampled_spans_.end(),
+            std::back_inserter(*span_data));
+  tail_sampled_spans_.clear();
 }
 
-void SpanExporterImpl::Export(const std::vector<SpanData>& span_data) {
-  // Call each registered handler.
+void SpanExporterImpl::Export(std::vector<SpanData>&& span_data) {
+  // Handlers share a single copy of the batch.
+  auto batch =
+      std::make_shared<const std::vector<SpanData>>(std::move(span_data));
   absl::MutexLock lock(&handler_mu_);
-  for (const auto& handler : handlers_) {
-    handler->Export(span_data);
+  const absl::Time now = absl::Now();
+  for (const auto& worker : workers_) {
+    worker->Enqueue(batch, now);
   }
 }
 
 void SpanExporterImpl::ExportForTesting() {
-  std::vector<opencensus::trace::exporter::SpanData> span_data_;
   std::vector<std::shared_ptr<opencensus::trace::SpanImpl>> batch_;
-  {
-    absl::MutexLock l(&span_mu_);
-    std::swap(batch_, spans_);
-  }
-  for (const auto& span : batch_) {
-    span_data_.emplace_back(span->ToSpanData());
+  DrainBuffers(&batch_);
+  std::vector<SpanData> span_data = ConvertSpans(&batch_);
+  TakeTailSampledSpans(&span_data);
+  Export(std::move(span_data));
+  absl::MutexLock lock(&handler_mu_);
+  for (const auto& worker : workers_) {
+    worker->WaitUntilIdle();
   }
-  Export(span_data_);
 }
 
 }  // namespace exporter
@@ -15,6 +15,8 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_EXPORTER_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_SPAN_EXPORTER_IMPL_H_
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -24,6 +26,8 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/export_worker.h"
+#include "opencensus/common/internal/mpsc_ring_buffer.h"
 #include "opencensus/trace/exporter/span_data.h"
 #include "opencensus/trace/exporter/span_exporter.h"
 #include "opencensus/trace/internal/span_impl.h"
@@ -36,6 +40,44 @@ class SpanExporterImpl;
 
 namespace exporter {
 
+// ConversionPool is a fixed set of threads that help the export thread convert
+// spans to SpanData. ConversionPool is thread-safe.
+class ConversionPool final {
+ public:
+  // Starts 'threads' helper threads.
+  explicit ConversionPool(int threads);
+  // Stops and joins the helper threads. Must not be called during ParallelFor.
+  ~ConversionPool();
+
+  ConversionPool(const ConversionPool&) = delete;
+  ConversionPool& operator=(const ConversionPool&) = delete;
+
+  int threads() const { return threads_.size(); }
+
+  // Calls fn(i) for each i in [0, n) on the helper threads and the calling
+  // thread, and returns when all calls have completed. Calls to ParallelFor
+  // must not overlap.
+  void ParallelFor(int n, const std::function<void(int)>& fn)
+      LOCKS_EXCLUDED(mu_);
+
+ private:
+  bool HasWork() const SHARED_LOCKS_REQUIRED(mu_);
+  bool IsDone() const SHARED_LOCKS_REQUIRED(mu_);
+
+  // Runs tasks of the current ParallelFor until none are left to start.
+  void RunTasks() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RunHelperLoop() LOCKS_EXCLUDED(mu_);
+
+  mutable absl::Mutex mu_;
+  // The current ParallelFor: fn_(i) is called for i in [next_, end_).
+  const std::function<void(int)>* fn_ GUARDED_BY(mu_) = nullptr;
+  int next_ GUARDED_BY(mu_) = 0;
+  int end_ GUARDED_BY(mu_) = 0;
+  int completed_ GUARDED_BY(mu_) = 0;
+  bool shutdown_ GUARDED_BY(mu_) = false;
+  std::vector<std::thread> threads_;
+};
+
 // SpanExporterImpl implements the SpanExporter API. Please refer to
 // opencensus/trace/exporter/span_exporter.h for usage.
 //
@@ -45,15 +87,36 @@ class SpanExporterImpl {
   // Returns the global instance of SpanExporterImpl.
   static SpanExporterImpl* Get();
 
-  // A shared_ptr to the span is added to a list. The actual conversion to
-  // SpanData will take place at a later time via the background thread. This
-  // is intended to be called at the Span::End().
+  // A shared_ptr to the span is added to a lock-free buffer. The actual
+  // conversion to SpanData will take place at a later time via the background
+  // thread. This is intended to be called at the Span::End().
   void AddSpan(const std::shared_ptr<opencensus::trace::SpanImpl>& span_impl);
 
+  // Queues spans that tail sampling kept, already converted, to be exported
+  // with the next batch. Spans beyond the buffer capacity are dropped.
+  void AddTailSampledSpans(std::vector<SpanData>&& spans)
+      LOCKS_EXCLUDED(tail_sampled_mu_);
+
   // Registers a handler with the exporter. This is intended to be done at
   // initialization.
-  void RegisterHandler(std::unique_ptr<SpanExporter::Handler> handler);
+  void RegisterHandler(std::unique_ptr<SpanExporter::Handler> handler,
+                       const SpanExporter::HandlerOptions& options);
+
+  void SetConversionThreads(int threads) LOCKS_EXCLUDED(conversion_mu_);
+
+  void SetBufferOptions(const SpanExporter::BufferOptions& options)
+      LOCKS_EXCLUDED(buffers_mu_);
 
+  uint64_t dropped_span_count() const {
+    return dropped_spans_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t dropped_batch_count() const {
+    return dropped_batches_.load(std::memory_order_relaxed);
+  }
+
+  // The number of buffered spans at which the export thread is woken up
+  // before the interval expires.
   static constexpr uint32_t kDefaultBufferSize = 64;
   static constexpr uint32_t kIntervalWaitTimeInMillis = 5000;
 
@@ -65,29 +128,91 @@ class SpanExporterImpl {
   SpanExporterImpl& operator=(SpanExporterImpl&&) = delete;
   friend class Span;
   friend class SpanExporter;  // For ExportForTesting() only.
+  friend class SpanExporterTestPeer;
 
   void StartExportThread() EXCLUSIVE_LOCKS_REQUIRED(handler_mu_);
   void RunWorkerLoop();
 
-  // Calls all registered handlers and exports the spans contained in span_data.
-  void Export(const std::vector<SpanData>& span_data);
+  using SpanBuffer =
+      common::MpscRingBuffer<std::shared_ptr<opencensus::trace::SpanImpl>>;
+
+  // Pushes span into buffer, applying the overflow policy. Returns false if
+  // the span was dropped.
+  bool PushSpan(SpanBuffer* buffer,
+                std::shared_ptr<opencensus::trace::SpanImpl> span);
+
+  // Wakes the export thread, unless a wake is already pending.
+  void RequestWake();
+
+  // Appends the spans queued by AddTailSampledSpans() to span_data.
+  void TakeTailSampledSpans(std::vector<SpanData>* span_data)
+      LOCKS_EXCLUDED(tail_sampled_mu_);
+
+  // Moves all currently buffered spans into batch, and frees replaced buffers
+  // that producers can no longer reach.
+  void DrainBuffers(
+      std::vector<std::shared_ptr<opencensus::trace::SpanImpl>>* batch)
+      LOCKS_EXCLUDED(buffers_mu_);
 
-  // Only for testing purposes: runs the export on the current thread and
-  // returns when complete.
+  // Converts spans to SpanData, in parallel if there are conversion threads,
+  // and clears spans.
+  std::vector<SpanData> ConvertSpans(
+      std::vector<std::shared_ptr<opencensus::trace::SpanImpl>>* spans)
+      LOCKS_EXCLUDED(conversion_mu_);
+
+  // Converts spans[begin, end) to SpanData, appending to span_data.
+  static void ConvertSpanRange(
+      std::vector<std::shared_ptr<opencensus::trace::SpanImpl>>* spans,
+      size_t begin, size_t end, std::vector<SpanData>* span_data);
+
+  // Queues the spans contained in span_data for each registered handler.
+  void Export(std::vector<SpanData>&& span_data) LOCKS_EXCLUDED(handler_mu_);
+
+  // Only for testing purposes: exports all buffered spans and returns when
+  // every handler has exported them.
   void ExportForTesting();
 
-  // Returns true if the spans_ buffer has filled up.
-  bool IsBufferFull() const;
+  // Returns true if a producer has asked the export thread to wake up.
+  bool WakeRequested() const {
+    return wake_requested_.load(std::memory_order_acquire);
+  }
 
   static SpanExporterImpl* span_exporter_;
   const uint32_t buffer_size_;
   const absl::Duration interval_;
-  mutable absl::Mutex span_mu_;
+
+  // The buffer that ended spans are pushed into. Producers never lock.
+  std::atomic<SpanBuffer*> buffer_;
+  std::atomic<SpanExporter::BufferOptions::OverflowPolicy> overflow_policy_;
+  std::atomic<uint64_t> dropped_spans_{0};
+  // The number of producers in AddSpan(). A producer may still push into a
+  // replaced buffer after SetBufferOptions() returns; once none is in
+  // AddSpan() after the replacement, replaced buffers are drained and freed.
+  std::atomic<int> producers_{0};
+  // Owns buffer_, which is last, and the buffers it has replaced that have not
+  // been freed yet.
+  absl::Mutex buffers_mu_;
+  std::vector<std::unique_ptr<SpanBuffer>> buffers_ GUARDED_BY(buffers_mu_);
+
+  absl::Mutex tail_sampled_mu_;
+  std::vector<SpanData> tail_sampled_spans_ GUARDED_BY(tail_sampled_mu_);
+
+  // Set by the first producer to see kDefaultBufferSize spans buffered, and
+  // cleared by the export thread when it drains the buffers. Producers only
+  // lock wake_mu_ (to wake the export thread) when they set it, so at most
+  // once per batch.
+  std::atomic<bool> wake_requested_{false};
+  absl::Mutex wake_mu_;
+
+  // Held while converting, so that the pool is not replaced while in use.
+  absl::Mutex conversion_mu_;
+  std::unique_ptr<ConversionPool> conversion_pool_ GUARDED_BY(conversion_mu_);
+
   mutable absl::Mutex handler_mu_;
-  std::vector<std::shared_ptr<opencensus::trace::SpanImpl>> spans_
-      GUARDED_BY(span_mu_);
-  std::vector<std::unique_ptr<SpanExporter::Handler>> handlers_
-      GUARDED_BY(handler_mu_);
+  // One per handler, which it owns.
+  std::vector<std::unique_ptr<common::ExportWorker<std::vector<SpanData>>>>
+      workers_ GUARDED_BY(handler_mu_);
+  std::atomic<uint64_t> dropped_batches_{0};
   bool thread_started_ GUARDED_BY(handler_mu_) = false;
   std::thread t_ GUARDED_BY(handler_mu_);
 };
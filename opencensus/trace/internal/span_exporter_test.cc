@@ -14,11 +14,20 @@
 
 #include "opencensus/trace/exporter/span_exporter.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "gtest/gtest.h"
 #include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/internal/span_exporter_impl.h"
 #include "opencensus/trace/sampler.h"
 #include "opencensus/trace/span.h"
 
@@ -60,6 +69,66 @@ class MyExporter : public exporter::SpanExporter::Handler {
   }
 };
 
+// Records the names of exported spans.
+class NameExporter : public exporter::SpanExporter::Handler {
+ public:
+  static NameExporter* Register() {
+    static NameExporter* exporter = [] {
+      auto handler = absl::make_unique<NameExporter>();
+      NameExporter* ptr = handler.get();
+      exporter::SpanExporter::RegisterHandler(std::move(handler));
+      return ptr;
+    }();
+    return exporter;
+  }
+
+  void Export(const std::vector<exporter::SpanData>& spans) override {
+    absl::MutexLock l(&mu_);
+    for (const auto& span : spans) {
+      names_.emplace_back(span.name());
+    }
+  }
+
+  std::vector<std::string> TakeNames() {
+    absl::MutexLock l(&mu_);
+    std::vector<std::string> names;
+    std::swap(names, names_);
+    return names;
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::vector<std::string> names_ GUARDED_BY(mu_);
+};
+
+// Blocks in Export() until Unblock() is called.
+class BlockingExporter : public exporter::SpanExporter::Handler {
+ public:
+  static BlockingExporter* Register() {
+    static BlockingExporter* exporter = [] {
+      auto handler = absl::make_unique<BlockingExporter>();
+      BlockingExporter* ptr = handler.get();
+      exporter::SpanExporter::RegisterHandler(std::move(handler));
+      return ptr;
+    }();
+    return exporter;
+  }
+
+  void Export(const std::vector<exporter::SpanData>& spans) override {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(&unblocked_));
+  }
+
+  void Unblock() {
+    absl::MutexLock l(&mu_);
+    unblocked_ = true;
+  }
+
+ private:
+  absl::Mutex mu_;
+  bool unblocked_ GUARDED_BY(mu_) = false;
+};
+
 class SpanExporterTest : public ::testing::Test {
  protected:
   static void SetUpTestCase() {
@@ -68,6 +137,34 @@ class SpanExporterTest : public ::testing::Test {
   }
 };
 
+}  // namespace
+
+namespace exporter {
+
+class SpanExporterTestPeer {
+ public:
+  static void ExportForTesting() { SpanExporter::ExportForTesting(); }
+
+  static size_t NumBuffers() {
+    SpanExporterImpl* impl = SpanExporterImpl::Get();
+    absl::MutexLock l(&impl->buffers_mu_);
+    return impl->buffers_.size();
+  }
+};
+
+}  // namespace exporter
+
+namespace {
+
+// Ends spans named "0" to "<count - 1>".
+void EndSpans(int count) {
+  static AlwaysSampler sampler;
+  for (int i = 0; i < count; ++i) {
+    auto span = Span::StartSpan(absl::StrCat(i), nullptr, {&sampler});
+    span.End();
+  }
+}
+
 TEST_F(SpanExporterTest, BasicExportTest) {
   ::opencensus::trace::AlwaysSampler sampler;
   ::opencensus::trace::StartSpanOptions opts = {&sampler};
@@ -88,6 +185,103 @@ TEST_F(SpanExporterTest, BasicExportTest) {
   EXPECT_EQ(3, Counter::Get()->value());
 }
 
+TEST_F(SpanExporterTest, OverflowDropsOldest) {
+  NameExporter* exporter = NameExporter::Register();
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  exporter->TakeNames();
+  exporter::SpanExporter::BufferOptions options;
+  options.capacity = 4;
+  options.overflow_policy =
+      exporter::SpanExporter::BufferOptions::OverflowPolicy::kDropOldest;
+  exporter::SpanExporter::SetBufferOptions(options);
+  const uint64_t dropped = exporter::SpanExporter::DroppedSpanCount();
+
+  EndSpans(10);
+  EXPECT_EQ(6, exporter::SpanExporter::DroppedSpanCount() - dropped);
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  EXPECT_EQ(std::vector<std::string>({"6", "7", "8", "9"}),
+            exporter->TakeNames());
+  exporter::SpanExporter::SetBufferOptions({});
+}
+
+TEST_F(SpanExporterTest, OverflowDropsNewest) {
+  NameExporter* exporter = NameExporter::Register();
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  exporter->TakeNames();
+  exporter::SpanExporter::BufferOptions options;
+  options.capacity = 4;
+  options.overflow_policy =
+      exporter::SpanExporter::BufferOptions::OverflowPolicy::kDropNewest;
+  exporter::SpanExporter::SetBufferOptions(options);
+  const uint64_t dropped = exporter::SpanExporter::DroppedSpanCount();
+
+  EndSpans(10);
+  EXPECT_EQ(6, exporter::SpanExporter::DroppedSpanCount() - dropped);
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  EXPECT_EQ(std::vector<std::string>({"0", "1", "2", "3"}),
+            exporter->TakeNames());
+  exporter::SpanExporter::SetBufferOptions({});
+}
+
+TEST_F(SpanExporterTest, FreesReplacedBuffers) {
+  NameExporter* exporter = NameExporter::Register();
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  exporter->TakeNames();
+  exporter::SpanExporter::BufferOptions options;
+  options.capacity = 4;
+  exporter::SpanExporter::SetBufferOptions(options);
+  EndSpans(2);
+  exporter::SpanExporter::SetBufferOptions({});
+  EndSpans(1);
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  EXPECT_EQ(std::vector<std::string>({"0", "1", "0"}), exporter->TakeNames());
+  EXPECT_EQ(1, exporter::SpanExporterTestPeer::NumBuffers());
+}
+
+TEST_F(SpanExporterTest, ParallelConversion) {
+  NameExporter* exporter = NameExporter::Register();
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  exporter->TakeNames();
+  exporter::SpanExporter::SetConversionThreads(4);
+
+  constexpr int kSpans = 500;
+  EndSpans(kSpans);
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  // The export thread may also have exported some of the spans.
+  std::vector<std::string> names;
+  for (int i = 0; i < 100 && names.size() < kSpans; ++i) {
+    for (auto& name : exporter->TakeNames()) names.push_back(std::move(name));
+    if (names.size() < kSpans) absl::SleepFor(absl::Milliseconds(100));
+  }
+  std::sort(names.begin(), names.end());
+  std::vector<std::string> expected;
+  for (int i = 0; i < kSpans; ++i) expected.push_back(absl::StrCat(i));
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(expected, names);
+  exporter::SpanExporter::SetConversionThreads(1);
+}
+
+// Must run last: the blocking handler stays registered.
+TEST_F(SpanExporterTest, SlowHandlerDoesNotBlockOthers) {
+  NameExporter* exporter = NameExporter::Register();
+  exporter::SpanExporterTestPeer::ExportForTesting();
+  exporter->TakeNames();
+  BlockingExporter* blocking = BlockingExporter::Register();
+
+  EndSpans(1);
+  // ExportForTesting() waits for every handler, including the blocked one.
+  std::thread export_thread(
+      [] { exporter::SpanExporterTestPeer::ExportForTesting(); });
+  std::vector<std::string> names;
+  for (int i = 0; i < 100 && names.empty(); ++i) {
+    names = exporter->TakeNames();
+    if (names.empty()) absl::SleepFor(absl::Milliseconds(100));
+  }
+  EXPECT_EQ(std::vector<std::string>({"0"}), names);
+  blocking->Unblock();
+  export_thread.join();
+}
+
 }  // namespace
 }  // namespace trace
 }  // namespace opencensus
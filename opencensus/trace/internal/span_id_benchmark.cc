@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "benchmark/benchmark.h"
+#include "opencensus/common/internal/allocation_counter.h"
+#include "opencensus/common/internal/random.h"
 #include "opencensus/trace/span_id.h"
 
 namespace opencensus {
@@ -22,6 +24,7 @@ namespace {
 constexpr uint8_t span_id[] = {1, 2, 3, 4, 5, 6, 7, 8};
 
 void BM_SpanIdDefaultConstructor(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     SpanId id;
   }
@@ -29,6 +32,7 @@ void BM_SpanIdDefaultConstructor(benchmark::State& state) {
 BENCHMARK(BM_SpanIdDefaultConstructor);
 
 void BM_SpanIdConstructFromBuffer(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     SpanId id(span_id);
   }
@@ -37,6 +41,7 @@ BENCHMARK(BM_SpanIdConstructFromBuffer);
 
 void BM_SpanIdToHex(benchmark::State& state) {
   SpanId id(span_id);
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     id.ToHex();
   }
@@ -47,6 +52,7 @@ void BM_SpanIdCompareEqual(benchmark::State& state) {
   bool b;
   SpanId id1(span_id);
   SpanId id2(span_id);
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     b = id1 == id2;
     (void)b;
@@ -56,6 +62,7 @@ BENCHMARK(BM_SpanIdCompareEqual);
 
 void BM_SpanIdIsValidFalse(benchmark::State& state) {
   SpanId id;
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     id.IsValid();
   }
@@ -64,6 +71,7 @@ BENCHMARK(BM_SpanIdIsValidFalse);
 
 void BM_SpanIdIsValidTrue(benchmark::State& state) {
   SpanId id(span_id);
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     id.IsValid();
   }
@@ -73,12 +81,27 @@ BENCHMARK(BM_SpanIdIsValidTrue);
 void BM_SpanIdCopyTo(benchmark::State& state) {
   uint8_t buf[SpanId::kSize];
   SpanId id(span_id);
+  ::opencensus::common::AllocationCounter allocations(&state);
   while (state.KeepRunning()) {
     id.CopyTo(buf);
   }
 }
 BENCHMARK(BM_SpanIdCopyTo);
 
+// Generates a random SpanId the way Span::StartSpan() does, from several
+// threads at once.
+void BM_SpanIdGenerateRandom(benchmark::State& state) {
+  ::opencensus::common::AllocationCounter allocations(&state);
+  while (state.KeepRunning()) {
+    uint8_t buf[SpanId::kSize];
+    ::opencensus::common::Random::GetRandom()->GenerateRandomBuffer(
+        buf, SpanId::kSize);
+    benchmark::DoNotOptimize(SpanId(buf));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpanIdGenerateRandom)->ThreadRange(1, 16)->UseRealTime();
+
 }  // namespace
 }  // namespace trace
 }  // namespace opencensus
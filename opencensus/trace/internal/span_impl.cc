@@ -14,18 +14,23 @@
 
 #include "opencensus/trace/internal/span_impl.h"
 
-#include <deque>
+#include <cstdint>
+#include <memory>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
-#include "absl/time/clock.h"
+#include "absl/memory/memory.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/tsc_clock.h"
 #include "opencensus/trace/attribute_value_ref.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 #include "opencensus/trace/exporter/message_event.h"
 #include "opencensus/trace/internal/local_span_store_impl.h"
 #include "opencensus/trace/internal/running_span_store_impl.h"
 #include "opencensus/trace/internal/span_exporter_impl.h"
+#include "opencensus/trace/resource_usage.h"
 #include "opencensus/trace/span.h"
 
 namespace opencensus {
@@ -33,23 +38,38 @@ namespace trace {
 
 namespace {
 template <typename T>
-std::vector<T> CopyTraceEvents(const std::deque<T>& events) {
+std::vector<T> CopyTraceEvents(const TraceEvents<T>& events) {
   std::vector<T> trace_events;
   trace_events.reserve(events.size());
-  for (const auto& event : events) {
+  events.ForEach([&trace_events](const T& event) {
     trace_events.emplace_back(event);
-  }
+  });
   return trace_events;
 }
 
 template <typename T>
 std::vector<exporter::SpanData::TimeEvent<T>> CopyEventWithTime(
-    const std::deque<EventWithTime<T>>& events) {
+    const TraceEvents<EventWithTime<T>>& events,
+    const common::TscClock::Converter& converter) {
   std::vector<exporter::SpanData::TimeEvent<T>> time_events;
   time_events.reserve(events.size());
-  for (const auto& event : events) {
+  events.ForEach([&time_events, &converter](const EventWithTime<T>& event) {
     auto tmp_event = event.event;
-    time_events.emplace_back(event.time, std::move(tmp_event));
+    time_events.emplace_back(converter.ToTime(event.ticks),
+                             std::move(tmp_event));
+  });
+  return time_events;
+}
+
+template <typename T>
+std::vector<exporter::SpanData::TimeEvent<T>> MoveEventWithTime(
+    std::vector<EventWithTime<T>>&& events,
+    const common::TscClock::Converter& converter) {
+  std::vector<exporter::SpanData::TimeEvent<T>> time_events;
+  time_events.reserve(events.size());
+  for (auto& event : events) {
+    time_events.emplace_back(converter.ToTime(event.ticks),
+                             std::move(event.event));
   }
   return time_events;
 }
@@ -77,8 +97,10 @@ std::unordered_map<std::string, exporter::AttributeValue> CopyAttributes(
 
 SpanImpl::SpanImpl(const SpanContext& context, const TraceParams& trace_params,
                    absl::string_view name, const SpanId& parent_span_id,
-                   bool remote_parent)
-    : start_time_(absl::Now()),
+                   bool remote_parent, bool record_resource_usage)
+    : resource_usage_start_(record_resource_usage ? StartResourceUsage()
+                                                  : nullptr),
+      start_ticks_(common::TscClock::Now()),
       name_(name),
       parent_span_id_(parent_span_id),
       context_(context),
@@ -89,6 +111,12 @@ SpanImpl::SpanImpl(const SpanContext& context, const TraceParams& trace_params,
       has_ended_(false),
       remote_parent_(remote_parent) {}
 
+SpanImpl::~SpanImpl() {
+  if (running_links_.tracker != exporter::RunningSpanLinks::Tracker::kNone) {
+    exporter::RunningSpanStoreImpl::Get()->OnSpanDestroyed(this);
+  }
+}
+
 void SpanImpl::AddAttributes(AttributesRef attributes) {
   absl::MutexLock l(&mu_);
   if (!has_ended_) {
@@ -104,7 +132,7 @@ void SpanImpl::AddAnnotation(absl::string_view description,
   absl::MutexLock l(&mu_);
   if (!has_ended_) {
     annotations_.AddEvent(EventWithTime<exporter::Annotation>(
-        absl::Now(),
+        common::TscClock::Now(),
         exporter::Annotation(description, CopyAttributes(attributes))));
   }
 }
@@ -116,7 +144,7 @@ void SpanImpl::AddMessageEvent(exporter::MessageEvent::Type type,
   absl::MutexLock l(&mu_);
   if (!has_ended_) {
     message_events_.AddEvent(EventWithTime<exporter::MessageEvent>(
-        absl::Now(),
+        common::TscClock::Now(),
         exporter::MessageEvent(type, message_id, compressed_message_size,
                                uncompressed_message_size)));
   }
@@ -138,6 +166,8 @@ void SpanImpl::SetStatus(exporter::Status&& status) {
 }
 
 bool SpanImpl::End() {
+  ResourceUsageSinceStart usage;
+  if (resource_usage_start_ != nullptr) usage = ReadResourceUsage();
   absl::MutexLock l(&mu_);
   if (has_ended_) {
     assert(false && "Invalid attempt to End() the same Span more than once.");
@@ -145,31 +175,101 @@ bool SpanImpl::End() {
     return false;
   }
   has_ended_ = true;
-  end_time_ = absl::Now();
+  end_ticks_ = common::TscClock::Now();
+  AddResourceUsageAttributes(usage);
   return true;
 }
 
+// static
+std::unique_ptr<const SpanImpl::ResourceUsageStart>
+SpanImpl::StartResourceUsage() {
+  const ResourceUsage::AllocatedBytesFunction allocated_bytes_function =
+      ResourceUsage::allocated_bytes_function();
+  return absl::make_unique<const ResourceUsageStart>(ResourceUsageStart{
+      std::this_thread::get_id(), ResourceUsage::ThreadCpuNanos(),
+      allocated_bytes_function,
+      allocated_bytes_function == nullptr ? 0 : allocated_bytes_function()});
+}
+
+SpanImpl::ResourceUsageSinceStart SpanImpl::ReadResourceUsage() const {
+  const ResourceUsageStart& start = *resource_usage_start_;
+  ResourceUsageSinceStart usage;
+  // Per-thread counters mean nothing across threads.
+  if (start.thread != std::this_thread::get_id()) return usage;
+  const int64_t cpu_nanos = ResourceUsage::ThreadCpuNanos();
+  if (start.cpu_nanos >= 0 && cpu_nanos >= 0) {
+    usage.has_cpu_nanos = true;
+    usage.cpu_nanos = cpu_nanos - start.cpu_nanos;
+  }
+  if (start.allocated_bytes_function != nullptr) {
+    usage.has_allocated_bytes = true;
+    usage.allocated_bytes =
+        start.allocated_bytes_function() - start.allocated_bytes;
+  }
+  return usage;
+}
+
+void SpanImpl::AddResourceUsageAttributes(
+    const ResourceUsageSinceStart& usage) {
+  if (usage.has_cpu_nanos) {
+    attributes_.AddAttributeIfRoom(
+        kCpuTimeAttributeKey,
+        exporter::AttributeValue(AttributeValueRef(usage.cpu_nanos)));
+  }
+  if (usage.has_allocated_bytes) {
+    attributes_.AddAttributeIfRoom(
+        kAllocatedBytesAttributeKey,
+        exporter::AttributeValue(AttributeValueRef(usage.allocated_bytes)));
+  }
+}
+
 bool SpanImpl::HasEnded() const {
   absl::MutexLock l(&mu_);
   return has_ended_;
 }
 
 exporter::SpanData SpanImpl::ToSpanData() const {
+  const common::TscClock::Converter converter;
   absl::MutexLock l(&mu_);
   // Make a deep copy of attributes.
   std::unordered_map<std::string, exporter::AttributeValue> attributes =
-      attributes_.attributes();
+      attributes_.CopyAttributes();
   return exporter::SpanData(
-      name_, context_, parent_span_id_,
+      name_.view(), context_, parent_span_id_,
       exporter::SpanData::TimeEvents<exporter::Annotation>(
-          CopyEventWithTime(annotations_.events()),
+          CopyEventWithTime(annotations_, converter),
           annotations_.num_events_dropped()),
       exporter::SpanData::TimeEvents<exporter::MessageEvent>(
-          CopyEventWithTime(message_events_.events()),
+          CopyEventWithTime(message_events_, converter),
           message_events_.num_events_dropped()),
-      CopyTraceEvents(links_.events()), links_.num_events_dropped(),
+      CopyTraceEvents(links_), links_.num_events_dropped(),
       std::move(attributes), attributes_.num_attributes_dropped(), has_ended_,
-      start_time_, end_time_, status_, remote_parent_);
+      converter.ToTime(start_ticks_),
+      has_ended_ ? converter.ToTime(end_ticks_) : absl::Time(), status_,
+      remote_parent_);
+}
+
+exporter::SpanData SpanImpl::ConsumeToSpanData() {
+  {
+    const common::TscClock::Converter converter;
+    absl::MutexLock l(&mu_);
+    if (has_ended_) {
+      // The dropped counts are unchanged by taking the contents.
+      return exporter::SpanData(
+          name_.view(), context_, parent_span_id_,
+          exporter::SpanData::TimeEvents<exporter::Annotation>(
+              MoveEventWithTime(annotations_.TakeEvents(), converter),
+              annotations_.num_events_dropped()),
+          exporter::SpanData::TimeEvents<exporter::MessageEvent>(
+              MoveEventWithTime(message_events_.TakeEvents(), converter),
+              message_events_.num_events_dropped()),
+          links_.TakeEvents(), links_.num_events_dropped(),
+          attributes_.TakeAttributes(), attributes_.num_attributes_dropped(),
+          has_ended_, converter.ToTime(start_ticks_),
+          converter.ToTime(end_ticks_), std::move(status_), remote_parent_);
+    }
+  }
+  return ToSpanData();
 }
 
 }  // namespace trace
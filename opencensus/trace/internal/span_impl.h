@@ -15,13 +15,17 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_SPAN_IMPL_H_
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "opencensus/common/internal/string_interner.h"
 #include "opencensus/trace/exporter/annotation.h"
 #include "opencensus/trace/exporter/attribute_value.h"
 #include "opencensus/trace/exporter/link.h"
@@ -31,6 +35,7 @@
 #include "opencensus/trace/internal/attribute_list.h"
 #include "opencensus/trace/internal/event_with_time.h"
 #include "opencensus/trace/internal/trace_events.h"
+#include "opencensus/trace/resource_usage.h"
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/span_context.h"
 #include "opencensus/trace/span_id.h"
@@ -40,12 +45,30 @@
 namespace opencensus {
 namespace trace {
 
+class SpanImpl;
+
 namespace exporter {
 class LocalSpanStoreImpl;
 class RunningSpanStoreImpl;
 class SpanExporterImpl;
+class TailSamplerImpl;
+struct ThreadSpanList;
+
+// The state RunningSpanStoreImpl keeps in each SpanImpl: which structure is
+// tracking it while it runs, and its links in a ThreadSpanList.
+struct RunningSpanLinks {
+  enum class Tracker : uint8_t { kNone, kShards, kThreadList };
+
+  // Set when the span starts and read when it ends or is destroyed.
+  Tracker tracker = Tracker::kNone;
+  ThreadSpanList* list = nullptr;
+  // Guarded by list->mu.
+  SpanImpl* prev = nullptr;
+  SpanImpl* next = nullptr;
+};
 }  // namespace exporter
 
+class SpanMetricsImpl;
 class SpanTestPeer;
 
 // SpanImpl is the underlying representation of a Span. Span has a shared_ptr
@@ -67,9 +90,15 @@ class SpanImpl final {
   // TraceParams sets the maximum number of attributes, annotations, network
   // events, and links. The name allows for a user provided description of the
   // span.
+  // If record_resource_usage is true, the span records its thread's resource
+  // usage when it ends (see ../resource_usage.h).
   SpanImpl(const SpanContext& context, const TraceParams& trace_params,
            absl::string_view name, const SpanId& parent_span_id,
-           bool remote_parent);
+           bool remote_parent, bool record_resource_usage = false);
+
+  // Removes the span from the running span store if it is destroyed without
+  // ending.
+  ~SpanImpl();
 
   void AddAttributes(AttributesRef attributes) LOCKS_EXCLUDED(mu_);
 
@@ -86,16 +115,17 @@ class SpanImpl final {
   void SetStatus(exporter::Status&& status) LOCKS_EXCLUDED(mu_);
 
   // Returns true on success (if this is the first time the Span has ended) and
-  // also marks the end of the Span and sets its end_time_.
+  // also marks the end of the Span and sets its end_ticks_.
   bool End() LOCKS_EXCLUDED(mu_);
 
   // Returns true if the span has ended.
   bool HasEnded() const LOCKS_EXCLUDED(mu_);
 
-  absl::string_view name() const { return name_; }
+  absl::string_view name() const { return name_.view(); }
 
-  // Returns the name of the span as a constref string.
-  const std::string& name_constref() const { return name_; }
+  // Returns the name of the span, which can be compared by address with other
+  // interned copies.
+  const common::InternedString& interned_name() const { return name_; }
 
   // Returns the SpanContext associated with this Span.
   SpanContext context() const { return context_; }
@@ -106,20 +136,59 @@ class SpanImpl final {
   friend class ::opencensus::trace::exporter::RunningSpanStoreImpl;
   friend class ::opencensus::trace::exporter::LocalSpanStoreImpl;
   friend class ::opencensus::trace::exporter::SpanExporterImpl;
+  friend class ::opencensus::trace::exporter::TailSamplerImpl;
+  friend class ::opencensus::trace::SpanMetricsImpl;
   friend class ::opencensus::trace::SpanTestPeer;
 
   // Makes a deep copy of span contents and returns copied data in SpanData.
   exporter::SpanData ToSpanData() const LOCKS_EXCLUDED(mu_);
 
+  // Like ToSpanData(), but moves the attributes, events, links and status into
+  // the returned SpanData instead of copying them, leaving this SpanImpl empty.
+  // Only the last owner of an ended span may call this: nothing must read the
+  // span contents afterwards. Copies if the span has not ended.
+  exporter::SpanData ConsumeToSpanData() LOCKS_EXCLUDED(mu_);
+
+  // The thread's resource usage when the span started.
+  struct ResourceUsageStart {
+    std::thread::id thread;
+    int64_t cpu_nanos;
+    ResourceUsage::AllocatedBytesFunction allocated_bytes_function;
+    int64_t allocated_bytes;
+  };
+
+  // The thread's resource usage between StartResourceUsage() and End().
+  struct ResourceUsageSinceStart {
+    bool has_cpu_nanos = false;
+    int64_t cpu_nanos = 0;
+    bool has_allocated_bytes = false;
+    int64_t allocated_bytes = 0;
+  };
+
+  // Returns the calling thread's resource usage.
+  static std::unique_ptr<const ResourceUsageStart> StartResourceUsage();
+
+  // Reads the resource usage since StartResourceUsage(). Called without mu_
+  // held, since it calls the user's AllocatedBytesFunction.
+  ResourceUsageSinceStart ReadResourceUsage() const LOCKS_EXCLUDED(mu_);
+
+  // Adds the resource usage as attributes, unless the span already has
+  // max_attributes user attributes.
+  void AddResourceUsageAttributes(const ResourceUsageSinceStart& usage)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   mutable absl::Mutex mu_;
-  // The start time of the span.
-  const absl::Time start_time_;
-  // The end time of the span. Set when End() is called.
-  absl::Time end_time_ GUARDED_BY(mu_);
+  // Null unless the span records its resource usage.
+  const std::unique_ptr<const ResourceUsageStart> resource_usage_start_;
+  // The start time of the span, in common::TscClock ticks.
+  const int64_t start_ticks_;
+  // The end time of the span, in common::TscClock ticks. Set when End() is
+  // called.
+  int64_t end_ticks_ GUARDED_BY(mu_) = 0;
   // The status of the span. Only set if start_options_.record_events is true.
   exporter::Status status_ GUARDED_BY(mu_);
   // The displayed name of the span.
-  const std::string name_;
+  const common::InternedString name_;
   // The parent SpanId of this span. Parent SpanId will be not valid if this is
   // a root span.
   const SpanId parent_span_id_;
@@ -138,6 +207,8 @@ class SpanImpl final {
   bool has_ended_ GUARDED_BY(mu_);
   // True if the parent Span is in a different process.
   const bool remote_parent_;
+  // Owned by RunningSpanStoreImpl.
+  exporter::RunningSpanLinks running_links_;
 };
 
 }  // namespace trace
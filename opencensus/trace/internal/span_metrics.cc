@@ -0,0 +1,159 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/span_metrics.h"
+#include "opencensus/trace/internal/span_metrics_impl.h"
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/common/internal/tsc_clock.h"
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/measure_registry.h"
+#include "opencensus/stats/recording.h"
+#include "opencensus/stats/tag_key.h"
+#include "opencensus/stats/tag_set.h"
+#include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+// The number of entries each thread caches.
+constexpr size_t kThreadCacheSize = 64;
+
+// The highest canonical code.
+constexpr StatusCode kMaxStatusCode = StatusCode::UNAUTHENTICATED;
+
+stats::MeasureDouble RegisterLatencyMeasure() {
+  // Another library may own the measure already.
+  stats::MeasureDouble measure =
+      stats::MeasureRegistry::GetMeasureDoubleByName(kSpanLatencyMeasureName);
+  if (measure.IsValid()) return measure;
+  return stats::MeasureDouble::Register(kSpanLatencyMeasureName,
+                                        "The latency of Spans.", "ms");
+}
+
+}  // namespace
+
+void SpanMetrics::Enable() { SpanMetricsImpl::Get()->Enable(); }
+
+void SpanMetrics::Disable() { SpanMetricsImpl::Get()->Disable(); }
+
+stats::MeasureDouble SpanMetrics::LatencyMeasure() {
+  return SpanMetricsImpl::Get()->latency_measure();
+}
+
+stats::TagKey SpanMetrics::NameTagKey() {
+  return SpanMetricsImpl::Get()->name_key();
+}
+
+stats::TagKey SpanMetrics::StatusTagKey() {
+  return SpanMetricsImpl::Get()->status_key();
+}
+
+SpanMetricsEntry::SpanMetricsEntry(absl::string_view name,
+                                   stats::TagKey name_key,
+                                   stats::TagKey status_key)
+    : name_(name) {
+  tags_.reserve(kMaxStatusCode + 1);
+  for (int code = 0; code <= kMaxStatusCode; ++code) {
+    tags_.emplace_back(stats::TagSet(
+        {{name_key, name},
+         {status_key, StatusCodeToString(static_cast<StatusCode>(code))}}));
+  }
+}
+
+std::atomic<bool> SpanMetricsImpl::enabled_(false);
+
+SpanMetricsImpl* SpanMetricsImpl::Get() {
+  static SpanMetricsImpl* global_span_metrics = new SpanMetricsImpl;
+  return global_span_metrics;
+}
+
+SpanMetricsImpl::SpanMetricsImpl()
+    : name_key_(stats::TagKey::Register("span_name")),
+      status_key_(stats::TagKey::Register("span_status")),
+      latency_measure_(RegisterLatencyMeasure()),
+      other_entry_("other", name_key_, status_key_) {}
+
+const SpanMetricsEntry* SpanMetricsImpl::GetEntry(absl::string_view name) {
+  // A direct-mapped per-thread cache, so that most Spans find their entry
+  // without locking. It is constant-initialized and holds only pointers to
+  // entries, which are never deleted. Names that fall into other_entry_ are
+  // cached by hash: entries_ no longer changes once it is full.
+  struct CacheSlot {
+    size_t hash;
+    const SpanMetricsEntry* entry;
+  };
+  static thread_local CacheSlot cache[kThreadCacheSize] = {};
+  const size_t hash = absl::Hash<absl::string_view>()(name);
+  CacheSlot& cached = cache[hash % kThreadCacheSize];
+  if (cached.entry != nullptr && cached.hash == hash &&
+      (cached.entry == &other_entry_ || cached.entry->name() == name)) {
+    return cached.entry;
+  }
+  const SpanMetricsEntry* entry = GetEntrySlow(name);
+  cached = {hash, entry};
+  return entry;
+}
+
+const SpanMetricsEntry* SpanMetricsImpl::GetEntrySlow(absl::string_view name) {
+  if (full_.load(std::memory_order_acquire)) {
+    auto it = entries_.find(name);
+    return it == entries_.end() ? &other_entry_ : it->second.get();
+  }
+  absl::MutexLock l(&mu_);
+  auto it = entries_.find(name);
+  if (it != entries_.end()) return it->second.get();
+  if (entries_.size() >= kMaxEntries) return &other_entry_;
+  auto entry =
+      absl::make_unique<SpanMetricsEntry>(name, name_key_, status_key_);
+  const SpanMetricsEntry* ptr = entry.get();
+  entries_.emplace(ptr->name(), std::move(entry));
+  if (entries_.size() == kMaxEntries) {
+    full_.store(true, std::memory_order_release);
+  }
+  return ptr;
+}
+
+void SpanMetricsImpl::Record(const SpanMetricsEntry& entry, StatusCode code,
+                             absl::Duration latency) const {
+  stats::Record(
+      {{latency_measure_, absl::ToDoubleMilliseconds(latency)}},
+      entry.tags(code));
+}
+
+void SpanMetricsImpl::Record(const SpanMetricsEntry& entry,
+                             const SpanImpl& span) const {
+  absl::Duration latency;
+  StatusCode code;
+  {
+    absl::MutexLock l(&span.mu_);
+    latency =
+        common::TscClock::ToDuration(span.end_ticks_ - span.start_ticks_);
+    code = span.status_.CanonicalCode();
+  }
+  Record(entry, code, latency);
+}
+
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,113 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_SPAN_METRICS_IMPL_H_
+#define OPENCENSUS_TRACE_INTERNAL_SPAN_METRICS_IMPL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/tag_key.h"
+#include "opencensus/stats/tag_set.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+
+class SpanImpl;
+
+// The tags for Spans with one name, one TagSet per status code.
+class SpanMetricsEntry final {
+ public:
+  SpanMetricsEntry(absl::string_view name, stats::TagKey name_key,
+                   stats::TagKey status_key);
+
+  const std::string& name() const { return name_; }
+  const stats::TagSet& tags(StatusCode code) const {
+    return code < tags_.size() ? tags_[code] : tags_[StatusCode::UNKNOWN];
+  }
+
+ private:
+  const std::string name_;
+  std::vector<stats::TagSet> tags_;
+};
+
+// SpanMetricsImpl implements SpanMetrics. Spans look up their entry when they
+// start, and record through it when they end.
+//
+// This class is thread-safe and a singleton.
+class SpanMetricsImpl final {
+ public:
+  static SpanMetricsImpl* Get();
+
+  // Returns true if Spans that start should be recorded.
+  static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  void Enable() { enabled_.store(true, std::memory_order_relaxed); }
+  void Disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+  // Returns the entry for name. Entries are never deleted.
+  const SpanMetricsEntry* GetEntry(absl::string_view name);
+
+  // Records a Span.
+  void Record(const SpanMetricsEntry& entry, StatusCode code,
+              absl::Duration latency) const;
+  // Records an ended SpanImpl.
+  void Record(const SpanMetricsEntry& entry, const SpanImpl& span) const;
+
+  stats::MeasureDouble latency_measure() const { return latency_measure_; }
+  stats::TagKey name_key() const { return name_key_; }
+  stats::TagKey status_key() const { return status_key_; }
+
+ private:
+  SpanMetricsImpl();
+
+  // Looks up or adds the entry under the lock, or without it once full_.
+  const SpanMetricsEntry* GetEntrySlow(absl::string_view name)
+      LOCKS_EXCLUDED(mu_);
+
+  static constexpr size_t kMaxEntries = 1000;
+
+  static std::atomic<bool> enabled_;
+
+  const stats::TagKey name_key_;
+  const stats::TagKey status_key_;
+  const stats::MeasureDouble latency_measure_;
+
+  absl::Mutex mu_;
+  // Keyed by the entry's name. Only added to under mu_, and never changed
+  // once full_, so that it can then be read without the lock.
+  std::unordered_map<absl::string_view, std::unique_ptr<SpanMetricsEntry>,
+                     absl::Hash<absl::string_view>>
+      entries_;
+  // Set once entries_ has kMaxEntries entries.
+  std::atomic<bool> full_{false};
+  // Used for Span names beyond kMaxEntries.
+  const SpanMetricsEntry other_entry_;
+};
+
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_SPAN_METRICS_IMPL_H_
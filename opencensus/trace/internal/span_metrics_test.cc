@@ -0,0 +1,160 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/span_metrics.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/stats/stats.h"
+#include "opencensus/stats/testing/test_utils.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/status_code.h"
+#include "opencensus/trace/with_span.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+class SpanMetricsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { SpanMetrics::Enable(); }
+  void TearDown() override { SpanMetrics::Disable(); }
+
+  static stats::ViewDescriptor CountDescriptor() {
+    return stats::ViewDescriptor()
+        .set_name("span_count")
+        .set_measure(kSpanLatencyMeasureName)
+        .set_aggregation(stats::Aggregation::Count())
+        .add_column(SpanMetrics::NameTagKey())
+        .add_column(SpanMetrics::StatusTagKey());
+  }
+
+  // Returns the count for name and status in the view.
+  static int64_t Count(stats::View* view, const std::string& name,
+                       const std::string& status) {
+    stats::testing::TestUtils::Flush();
+    const auto data = view->GetData();
+    auto it = data.int_data().find({name, status});
+    return it == data.int_data().end() ? 0 : it->second;
+  }
+
+  AlwaysSampler always_sampler_;
+  NeverSampler never_sampler_;
+};
+
+TEST_F(SpanMetricsTest, RecordsSampledSpans) {
+  stats::View view(CountDescriptor());
+  auto span = Span::StartSpan("sampled", nullptr, {&always_sampler_});
+  span.End();
+  auto failed = Span::StartSpan("sampled", nullptr, {&always_sampler_});
+  failed.SetStatus(StatusCode::DEADLINE_EXCEEDED, "too slow");
+  failed.End();
+  EXPECT_EQ(1, Count(&view, "sampled", "OK"));
+  EXPECT_EQ(1, Count(&view, "sampled", "DEADLINE_EXCEEDED"));
+}
+
+TEST_F(SpanMetricsTest, RecordsUnsampledSpans) {
+  stats::View view(CountDescriptor());
+  auto span = Span::StartSpan("unsampled", nullptr, {&never_sampler_});
+  EXPECT_FALSE(span.IsRecording());
+  span.SetStatus(StatusCode::NOT_FOUND);
+  span.End();
+  // Ignored after End().
+  span.SetStatus(StatusCode::INTERNAL);
+  span.End();
+  EXPECT_EQ(1, Count(&view, "unsampled", "NOT_FOUND"));
+  EXPECT_EQ(0, Count(&view, "unsampled", "INTERNAL"));
+}
+
+TEST_F(SpanMetricsTest, RecordsLatency) {
+  stats::View view(stats::ViewDescriptor()
+                       .set_name("span_latency")
+                       .set_measure(kSpanLatencyMeasureName)
+                       .set_aggregation(stats::Aggregation::Sum())
+                       .add_column(SpanMetrics::NameTagKey()));
+  auto span = Span::StartSpan("latency", nullptr, {&never_sampler_});
+  absl::SleepFor(absl::Milliseconds(10));
+  span.End();
+  stats::testing::TestUtils::Flush();
+  const auto data = view.GetData();
+  auto it = data.double_data().find({"latency"});
+  ASSERT_NE(data.double_data().end(), it);
+  EXPECT_LE(10, it->second);
+}
+
+TEST_F(SpanMetricsTest, CopiesKeepMetricsState) {
+  stats::View view(CountDescriptor());
+  auto span = Span::StartSpan("copied", nullptr, {&never_sampler_});
+  span.SetStatus(StatusCode::ABORTED);
+  Span copy = span;
+  copy.End();
+  EXPECT_EQ(1, Count(&view, "copied", "ABORTED"));
+}
+
+TEST_F(SpanMetricsTest, WrappedCopiesDoNotShareMetricsState) {
+  stats::View view(CountDescriptor());
+  auto span = Span::StartSpan("wrapped", nullptr, {&never_sampler_});
+  std::function<void()> fn;
+  {
+    WithSpan ws(span);
+    fn = WrapWithCurrentSpan([]() {
+      // The status of a copy is not seen by the original.
+      Span copy = GetCurrentSpan();
+      copy.SetStatus(StatusCode::INTERNAL);
+    });
+  }
+  fn();
+  span.End();
+  EXPECT_EQ(1, Count(&view, "wrapped", "OK"));
+  EXPECT_EQ(0, Count(&view, "wrapped", "INTERNAL"));
+}
+
+TEST_F(SpanMetricsTest, Disabled) {
+  stats::View view(CountDescriptor());
+  SpanMetrics::Disable();
+  auto span = Span::StartSpan("disabled", nullptr, {&never_sampler_});
+  // Spans are recorded if enabled when they start.
+  SpanMetrics::Enable();
+  span.End();
+  EXPECT_EQ(0, Count(&view, "disabled", "OK"));
+}
+
+// Runs last, since it fills the names for the rest of the process.
+TEST_F(SpanMetricsTest, NamesBeyondLimitShareOtherEntry) {
+  stats::View view(CountDescriptor());
+  for (int i = 0; i < 1000; ++i) {
+    Span::StartSpan(absl::StrCat("name", i), nullptr, {&never_sampler_}).End();
+  }
+  const int64_t other_count = Count(&view, "other", "OK");
+  EXPECT_LT(0, other_count);
+  // Twice, so that the second lookup is served from the thread's cache.
+  for (int i = 0; i < 2; ++i) {
+    Span::StartSpan("overflow", nullptr, {&never_sampler_}).End();
+  }
+  Span::StartSpan("name0", nullptr, {&never_sampler_}).End();
+  EXPECT_EQ(0, Count(&view, "overflow", "OK"));
+  EXPECT_EQ(other_count + 2, Count(&view, "other", "OK"));
+  EXPECT_EQ(2, Count(&view, "name0", "OK"));
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
@@ -42,6 +42,10 @@ class SpanTestPeer {
   static exporter::SpanData ToSpanData(Span* span) {
     return span->span_impl_for_test()->ToSpanData();
   }
+
+  static exporter::SpanData ConsumeToSpanData(Span* span) {
+    return span->span_impl_for_test()->ConsumeToSpanData();
+  }
 };
 
 namespace {
@@ -323,6 +327,21 @@ TEST(SpanTest, ForceSamplingOffViaTraceConfig) {
   }
 }
 
+TEST(SpanTest, UnsampledChildSpan) {
+  TraceConfig::SetCurrentTraceParams(
+      TraceParams{32, 32, 128, 128, ProbabilitySampler(0.0)});
+  NeverSampler never_sampler;
+  auto parent = Span::StartSpan("Parent", nullptr, {&never_sampler});
+  auto child = Span::StartSpan("Child", &parent);
+  EXPECT_FALSE(child.IsSampled());
+  EXPECT_FALSE(child.IsRecording());
+  EXPECT_TRUE(child.context().IsValid());
+  EXPECT_EQ(parent.context().trace_id(), child.context().trace_id());
+  EXPECT_FALSE(parent.context().span_id() == child.context().span_id());
+  child.End();
+  parent.End();
+}
+
 TEST(SpanTest, CheckSpanData) {
   AlwaysSampler sampler;
   auto current_span = Span::StartSpan("test_span", nullptr, {&sampler});
@@ -350,6 +369,40 @@ TEST(SpanTest, CheckSpanData) {
   EXPECT_EQ(333, attributes.at("test3").int_value());
 }
 
+TEST(SpanTest, ConsumeToSpanDataMovesContents) {
+  AlwaysSampler sampler;
+  auto span = Span::StartSpan("test_span", nullptr, {&sampler});
+  span.AddAttributes({{"key1", "value1"}, {"key2", 2}});
+  span.AddAnnotation("annotation", {{"key", "value"}});
+  span.AddSentMessageEvent(1, 2, 3);
+  span.SetStatus(StatusCode::CANCELLED, "cancelled");
+  span.End();
+
+  const exporter::SpanData copied = SpanTestPeer::ToSpanData(&span);
+  const exporter::SpanData moved = SpanTestPeer::ConsumeToSpanData(&span);
+  EXPECT_EQ(copied.DebugString(), moved.DebugString());
+
+  // The contents were moved out.
+  const exporter::SpanData empty = SpanTestPeer::ToSpanData(&span);
+  EXPECT_TRUE(empty.attributes().empty());
+  EXPECT_EQ(0, empty.num_attributes_dropped());
+  EXPECT_TRUE(empty.annotations().events().empty());
+  EXPECT_EQ(0, empty.annotations().dropped_events_count());
+  EXPECT_TRUE(empty.message_events().events().empty());
+  EXPECT_EQ(copied.start_time(), empty.start_time());
+  EXPECT_EQ(copied.end_time(), empty.end_time());
+}
+
+TEST(SpanTest, ConsumeToSpanDataCopiesRunningSpan) {
+  AlwaysSampler sampler;
+  auto span = Span::StartSpan("test_span", nullptr, {&sampler});
+  span.AddAttribute("key", "value");
+  SpanTestPeer::ConsumeToSpanData(&span);
+  const exporter::SpanData data = SpanTestPeer::ToSpanData(&span);
+  EXPECT_EQ("value", data.attributes().at("key").string_value());
+  span.End();
+}
+
 TEST(SpanTest, BlankSpan) {
   auto parent = Span::StartSpan("parent");
   auto span = Span::BlankSpan();
@@ -17,13 +17,13 @@
 #include <string>
 
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/status_code.h"
 
 namespace opencensus {
 namespace trace {
-namespace exporter {
-namespace {
 
-absl::string_view CodeToString(StatusCode code) {
+absl::string_view StatusCodeToString(StatusCode code) {
   switch (code) {
     case StatusCode::OK:
       return "OK";
@@ -63,13 +63,13 @@ absl::string_view CodeToString(StatusCode code) {
   return "";
 }
 
-}  // namespace
+namespace exporter {
 
 std::string Status::ToString() const {
   if (ok()) {
     return "OK";
   }
-  return absl::StrCat(CodeToString(code_), ": ", message_);
+  return absl::StrCat(StatusCodeToString(code_), ": ", message_);
 }
 
 bool Status::operator==(const Status& that) const {
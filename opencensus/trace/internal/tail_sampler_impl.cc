@@ -0,0 +1,248 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/internal/tail_sampler_impl.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/exporter/attribute_value.h"
+#include "opencensus/trace/exporter/message_event.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/internal/span_exporter_impl.h"
+#include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/status_code.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+namespace {
+
+// Expired traces are swept from every shard at most this often.
+constexpr absl::Duration kSweepInterval = absl::Seconds(1);
+
+size_t AttributesBytes(
+    const std::unordered_map<std::string, AttributeValue>& attributes) {
+  size_t bytes = 0;
+  for (const auto& attribute : attributes) {
+    bytes += sizeof(attribute) + attribute.first.size();
+    if (attribute.second.type() == AttributeValue::Type::kString) {
+      bytes += attribute.second.string_value().size();
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+std::atomic<bool> TailSamplerImpl::enabled_(false);
+
+TailSamplerImpl* TailSamplerImpl::Get() {
+  static TailSamplerImpl* global_tail_sampler = new TailSamplerImpl;
+  return global_tail_sampler;
+}
+
+void TailSamplerImpl::Enable(const SpanExporter::TailSamplingOptions& options) {
+  for (Shard& shard : shards_) {
+    absl::MutexLock l(&shard.mu);
+    shard.options = options;
+    shard.max_buffered_bytes = static_cast<size_t>(
+        std::max<int64_t>(1, options.max_buffered_bytes / kNumShards));
+    shard.max_traces = std::max(1, options.max_traces / kNumShards);
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void TailSamplerImpl::Disable() {
+  enabled_.store(false, std::memory_order_relaxed);
+  for (Shard& shard : shards_) {
+    absl::MutexLock l(&shard.mu);
+    for (const auto& trace : shard.traces) {
+      if (trace.second.decision == Trace::Decision::kPending) {
+        evicted_traces_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    shard.traces.clear();
+    shard.order.clear();
+    shard.buffered_bytes = 0;
+  }
+}
+
+// static
+TailSamplerImpl::TraceKey TailSamplerImpl::KeyFor(const TraceId& trace_id) {
+  uint8_t buf[TraceId::kSize];
+  trace_id.CopyTo(buf);
+  TraceKey key;
+  memcpy(&key.first, buf, sizeof(key.first));
+  memcpy(&key.second, buf + sizeof(key.first), sizeof(key.second));
+  return key;
+}
+
+// static
+size_t TailSamplerImpl::EstimateBytes(const SpanData& span) {
+  size_t bytes = sizeof(SpanData) + span.name().size() +
+                 span.status().error_message().size() +
+                 AttributesBytes(span.attributes());
+  for (const auto& annotation : span.annotations().events()) {
+    bytes += sizeof(annotation) + annotation.event().description().size() +
+             AttributesBytes(annotation.event().attributes());
+  }
+  bytes += span.message_events().events().size() *
+           sizeof(SpanData::TimeEvent<MessageEvent>);
+  for (const auto& link : span.links()) {
+    bytes += sizeof(link) + AttributesBytes(link.attributes());
+  }
+  return bytes;
+}
+
+void TailSamplerImpl::AddSpan(const std::shared_ptr<SpanImpl>& span) {
+  if (!Enabled()) return;
+  // Spans recorded only for tail sampling are in no span store, and Span
+  // handles cannot read an ended span's contents, so they can be moved out.
+  SpanData data = span->ConsumeToSpanData();
+  const absl::Time end_time = data.end_time();
+  const absl::Duration latency = end_time - data.start_time();
+  const bool is_error = data.status().CanonicalCode() != StatusCode::OK;
+  const bool is_local_root =
+      data.has_remote_parent() || !data.parent_span_id().IsValid();
+  const TraceId trace_id = data.context().trace_id();
+  const TraceKey key = KeyFor(trace_id);
+  Shard& shard = shards_[TraceKeyHash()(key) % kNumShards];
+
+  // The end time of the newest Span stands in for the current time.
+  MaybeSweep(end_time);
+
+  std::vector<SpanData> to_export;
+  {
+    absl::MutexLock l(&shard.mu);
+    // Disable() may have cleared this shard since the check above.
+    if (!Enabled()) return;
+    EvictExpired(&shard, end_time);
+
+    auto it = shard.traces.find(key);
+    if (it == shard.traces.end()) {
+      while (shard.traces.size() >= shard.max_traces) EvictOldest(&shard);
+      it = shard.traces.emplace(key, Trace()).first;
+      it->second.first_end_time = end_time;
+      shard.order.push_back(key);
+    }
+    Trace& trace = it->second;
+
+    switch (trace.decision) {
+      case Trace::Decision::kKept:
+        to_export.push_back(std::move(data));
+        break;
+      case Trace::Decision::kDropped:
+        break;
+      case Trace::Decision::kPending:
+        trace.has_error |= is_error;
+        if (trace.spans.size() <
+            static_cast<size_t>(shard.options.max_spans_per_trace)) {
+          const size_t bytes = EstimateBytes(data);
+          trace.spans.push_back(std::move(data));
+          trace.bytes += bytes;
+          shard.buffered_bytes += bytes;
+        } else {
+          dropped_spans_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (is_local_root) {
+          const bool keep =
+              trace.has_error ||
+              latency >= shard.options.latency_threshold ||
+              ProbabilitySampler(shard.options.keep_probability)
+                  .ShouldSample(nullptr, false, trace_id, SpanId(), "", {});
+          shard.buffered_bytes -= trace.bytes;
+          trace.bytes = 0;
+          if (keep) {
+            trace.decision = Trace::Decision::kKept;
+            to_export = std::move(trace.spans);
+            kept_traces_.fetch_add(1, std::memory_order_relaxed);
+          } else {
+            trace.decision = Trace::Decision::kDropped;
+            dropped_traces_.fetch_add(1, std::memory_order_relaxed);
+          }
+          trace.spans.clear();
+          trace.spans.shrink_to_fit();
+        } else {
+          while (shard.buffered_bytes > shard.max_buffered_bytes) {
+            EvictOldest(&shard);
+          }
+        }
+        break;
+    }
+  }
+  if (!to_export.empty()) {
+    SpanExporterImpl::Get()->AddTailSampledSpans(std::move(to_export));
+  }
+}
+
+void TailSamplerImpl::EvictOldest(Shard* shard) {
+  auto it = shard->traces.find(shard->order.front());
+  if (it->second.decision == Trace::Decision::kPending) {
+    evicted_traces_.fetch_add(1, std::memory_order_relaxed);
+    shard->buffered_bytes -= it->second.bytes;
+  }
+  shard->order.pop_front();
+  shard->traces.erase(it);
+}
+
+void TailSamplerImpl::EvictExpired(Shard* shard, absl::Time now) {
+  while (!shard->order.empty() &&
+         shard->traces.find(shard->order.front())->second.first_end_time +
+                 shard->options.trace_timeout <=
+             now) {
+    EvictOldest(shard);
+  }
+}
+
+void TailSamplerImpl::MaybeSweep(absl::Time now) {
+  const int64_t now_nanos = absl::ToUnixNanos(now);
+  int64_t next_sweep_nanos = next_sweep_nanos_.load(std::memory_order_relaxed);
+  // Only the thread that moves next_sweep_nanos_ forward sweeps.
+  if (now_nanos < next_sweep_nanos ||
+      !next_sweep_nanos_.compare_exchange_strong(
+          next_sweep_nanos, absl::ToUnixNanos(now + kSweepInterval),
+          std::memory_order_relaxed)) {
+    return;
+  }
+  for (Shard& shard : shards_) {
+    absl::MutexLock l(&shard.mu);
+    EvictExpired(&shard, now);
+  }
+}
+
+SpanExporter::TailSamplingStats TailSamplerImpl::GetStats() const {
+  SpanExporter::TailSamplingStats stats;
+  stats.kept_traces = kept_traces_.load(std::memory_order_relaxed);
+  stats.dropped_traces = dropped_traces_.load(std::memory_order_relaxed);
+  stats.evicted_traces = evicted_traces_.load(std::memory_order_relaxed);
+  stats.dropped_spans = dropped_spans_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
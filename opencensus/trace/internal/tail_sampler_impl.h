@@ -0,0 +1,138 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_INTERNAL_TAIL_SAMPLER_IMPL_H_
+#define OPENCENSUS_TRACE_INTERNAL_TAIL_SAMPLER_IMPL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/internal/span_impl.h"
+#include "opencensus/trace/trace_id.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+// TailSamplerImpl implements tail-based sampling (see
+// SpanExporter::TailSamplingOptions). Ended Spans that were not sampled are
+// converted to SpanData and buffered per trace, in shards keyed by TraceId,
+// until the trace's local root ends; then the trace's Spans are passed to
+// SpanExporterImpl or dropped.
+//
+// This class is thread-safe and a singleton.
+class TailSamplerImpl {
+ public:
+  // Returns the global instance of TailSamplerImpl.
+  static TailSamplerImpl* Get();
+
+  // Returns true if Spans that are not sampled should be recorded, so that
+  // they can be tail sampled.
+  static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  void Enable(const SpanExporter::TailSamplingOptions& options);
+  // Stops buffering and forgets all traces.
+  void Disable();
+
+  // Buffers an ended Span that was not sampled, and decides its trace if it is
+  // the local root. Does nothing unless Enabled(). Only Span::End should call
+  // this.
+  void AddSpan(const std::shared_ptr<SpanImpl>& span);
+
+  SpanExporter::TailSamplingStats GetStats() const;
+
+ private:
+  TailSamplerImpl() = default;
+
+  // The TraceId, as two integers.
+  using TraceKey = std::pair<uint64_t, uint64_t>;
+  struct TraceKeyHash {
+    size_t operator()(const TraceKey& key) const {
+      return static_cast<size_t>(key.first ^
+                                 (key.second * 0x9e3779b97f4a7c15));
+    }
+  };
+
+  struct Trace {
+    enum class Decision { kPending, kKept, kDropped };
+    Decision decision = Decision::kPending;
+    bool has_error = false;
+    // When the trace's first Span ended. It is forgotten trace_timeout later.
+    absl::Time first_end_time;
+    std::vector<SpanData> spans;
+    // The estimated size of spans.
+    size_t bytes = 0;
+  };
+
+  struct Shard {
+    absl::Mutex mu;
+    std::unordered_map<TraceKey, Trace, TraceKeyHash> traces GUARDED_BY(mu);
+    // Traces from the oldest to the newest, which is also expiry order, even
+    // if trace_timeout changes.
+    std::deque<TraceKey> order GUARDED_BY(mu);
+    size_t buffered_bytes GUARDED_BY(mu) = 0;
+    // This shard's share of the options.
+    SpanExporter::TailSamplingOptions options GUARDED_BY(mu);
+    size_t max_buffered_bytes GUARDED_BY(mu) = 0;
+    size_t max_traces GUARDED_BY(mu) = 0;
+  };
+
+  static constexpr int kNumShards = 16;
+
+  static TraceKey KeyFor(const TraceId& trace_id);
+
+  // Returns the approximate number of bytes used by span.
+  static size_t EstimateBytes(const SpanData& span);
+
+  // Forgets the oldest trace in the shard.
+  void EvictOldest(Shard* shard) EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
+
+  // Forgets the traces in the shard that expired by 'now'.
+  void EvictExpired(Shard* shard, absl::Time now)
+      EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
+
+  // Forgets expired traces in every shard, if the last sweep was more than
+  // kSweepInterval before 'now', so that traces in shards that no longer see
+  // new Spans still expire.
+  void MaybeSweep(absl::Time now);
+
+  static std::atomic<bool> enabled_;
+
+  Shard shards_[kNumShards];
+
+  // When the next MaybeSweep() is due, in nanoseconds since the Unix epoch.
+  std::atomic<int64_t> next_sweep_nanos_{0};
+
+  std::atomic<uint64_t> kept_traces_{0};
+  std::atomic<uint64_t> dropped_traces_{0};
+  std::atomic<uint64_t> evicted_traces_{0};
+  std::atomic<uint64_t> dropped_spans_{0};
+};
+
+}  // namespace exporter
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_INTERNAL_TAIL_SAMPLER_IMPL_H_
@@ -0,0 +1,279 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/exporter/span_data.h"
+#include "opencensus/trace/exporter/span_exporter.h"
+#include "opencensus/trace/internal/local_span_store.h"
+#include "opencensus/trace/internal/running_span_store.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/status_code.h"
+
+namespace opencensus {
+namespace trace {
+namespace exporter {
+
+class SpanExporterTestPeer {
+ public:
+  static void ExportForTesting() { SpanExporter::ExportForTesting(); }
+};
+
+}  // namespace exporter
+
+namespace {
+
+// Records the names of exported spans, sorted.
+class NameExporter : public exporter::SpanExporter::Handler {
+ public:
+  static NameExporter* Register() {
+    static NameExporter* exporter = [] {
+      auto handler = absl::make_unique<NameExporter>();
+      NameExporter* ptr = handler.get();
+      exporter::SpanExporter::RegisterHandler(std::move(handler));
+      return ptr;
+    }();
+    return exporter;
+  }
+
+  void Export(const std::vector<exporter::SpanData>& spans) override {
+    absl::MutexLock l(&mu_);
+    for (const auto& span : spans) {
+      names_.emplace_back(span.name());
+    }
+  }
+
+  std::vector<std::string> TakeNames() {
+    exporter::SpanExporterTestPeer::ExportForTesting();
+    absl::MutexLock l(&mu_);
+    std::vector<std::string> names;
+    std::swap(names, names_);
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::vector<std::string> names_ GUARDED_BY(mu_);
+};
+
+class TailSamplerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    exporter_ = NameExporter::Register();
+    exporter_->TakeNames();
+    stats_ = exporter::SpanExporter::GetTailSamplingStats();
+  }
+
+  void TearDown() override { exporter::SpanExporter::DisableTailSampling(); }
+
+  // Options that keep only slow or failed traces.
+  static exporter::SpanExporter::TailSamplingOptions Options() {
+    exporter::SpanExporter::TailSamplingOptions options;
+    options.latency_threshold = absl::Hours(1);
+    options.keep_probability = 0;
+    return options;
+  }
+
+  // Returns the stats since SetUp().
+  exporter::SpanExporter::TailSamplingStats StatsDelta() const {
+    const auto stats = exporter::SpanExporter::GetTailSamplingStats();
+    exporter::SpanExporter::TailSamplingStats delta;
+    delta.kept_traces = stats.kept_traces - stats_.kept_traces;
+    delta.dropped_traces = stats.dropped_traces - stats_.dropped_traces;
+    delta.evicted_traces = stats.evicted_traces - stats_.evicted_traces;
+    delta.dropped_spans = stats.dropped_spans - stats_.dropped_spans;
+    return delta;
+  }
+
+  NeverSampler never_sampler_;
+  NameExporter* exporter_;
+  exporter::SpanExporter::TailSamplingStats stats_;
+};
+
+TEST_F(TailSamplerTest, DisabledDoesNotRecord) {
+  auto span = Span::StartSpan("span", nullptr, {&never_sampler_});
+  EXPECT_FALSE(span.IsRecording());
+  span.End();
+  EXPECT_TRUE(exporter_->TakeNames().empty());
+}
+
+TEST_F(TailSamplerTest, KeepsSlowTrace) {
+  auto options = Options();
+  options.latency_threshold = absl::ZeroDuration();
+  exporter::SpanExporter::EnableTailSampling(options);
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  EXPECT_TRUE(root.IsRecording());
+  EXPECT_FALSE(root.IsSampled());
+  auto child = Span::StartSpan("child", &root, {&never_sampler_});
+  child.End();
+  EXPECT_TRUE(exporter_->TakeNames().empty());
+  root.End();
+  EXPECT_EQ(std::vector<std::string>({"child", "root"}),
+            exporter_->TakeNames());
+  EXPECT_EQ(1, StatsDelta().kept_traces);
+}
+
+TEST_F(TailSamplerTest, KeepsFailedTrace) {
+  exporter::SpanExporter::EnableTailSampling(Options());
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  auto child = Span::StartSpan("child", &root, {&never_sampler_});
+  child.SetStatus(StatusCode::INTERNAL);
+  child.End();
+  root.End();
+  EXPECT_EQ(std::vector<std::string>({"child", "root"}),
+            exporter_->TakeNames());
+  EXPECT_EQ(1, StatsDelta().kept_traces);
+}
+
+TEST_F(TailSamplerTest, DropsNormalTrace) {
+  exporter::SpanExporter::EnableTailSampling(Options());
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  auto child = Span::StartSpan("child", &root, {&never_sampler_});
+  child.End();
+  root.End();
+  EXPECT_TRUE(exporter_->TakeNames().empty());
+  EXPECT_EQ(1, StatsDelta().dropped_traces);
+}
+
+TEST_F(TailSamplerTest, LateSpanFollowsDecision) {
+  exporter::SpanExporter::EnableTailSampling(Options());
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  auto late_child = Span::StartSpan("late_child", &root, {&never_sampler_});
+  root.SetStatus(StatusCode::UNKNOWN);
+  root.End();
+  EXPECT_EQ(std::vector<std::string>({"root"}), exporter_->TakeNames());
+  late_child.End();
+  EXPECT_EQ(std::vector<std::string>({"late_child"}), exporter_->TakeNames());
+}
+
+TEST_F(TailSamplerTest, SampledSpansAreExportedDirectly) {
+  exporter::SpanExporter::EnableTailSampling(Options());
+  AlwaysSampler always_sampler;
+  auto root = Span::StartSpan("root", nullptr, {&always_sampler});
+  root.End();
+  EXPECT_EQ(std::vector<std::string>({"root"}), exporter_->TakeNames());
+  EXPECT_EQ(0, StatsDelta().kept_traces);
+  EXPECT_EQ(0, StatsDelta().dropped_traces);
+}
+
+TEST_F(TailSamplerTest, MaxSpansPerTrace) {
+  auto options = Options();
+  options.max_spans_per_trace = 1;
+  exporter::SpanExporter::EnableTailSampling(options);
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  auto child1 = Span::StartSpan("child1", &root, {&never_sampler_});
+  auto child2 = Span::StartSpan("child2", &root, {&never_sampler_});
+  child1.SetStatus(StatusCode::INTERNAL);
+  child1.End();
+  child2.End();
+  root.End();
+  EXPECT_EQ(std::vector<std::string>({"child1"}), exporter_->TakeNames());
+  EXPECT_EQ(2, StatsDelta().dropped_spans);
+}
+
+TEST_F(TailSamplerTest, EvictsWhenBufferIsFull) {
+  auto options = Options();
+  options.latency_threshold = absl::ZeroDuration();
+  // 4 KiB per shard.
+  options.max_buffered_bytes = 16 * 4096;
+  exporter::SpanExporter::EnableTailSampling(options);
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  auto small_child = Span::StartSpan("small_child", &root, {&never_sampler_});
+  auto large_child = Span::StartSpan("large_child", &root, {&never_sampler_});
+  small_child.End();
+  EXPECT_EQ(0, StatsDelta().evicted_traces);
+  const std::string payload(8192, 'x');
+  large_child.AddAttribute("payload", payload);
+  large_child.End();
+  EXPECT_EQ(1, StatsDelta().evicted_traces);
+  // The root is decided on its own.
+  root.End();
+  EXPECT_EQ(std::vector<std::string>({"root"}), exporter_->TakeNames());
+}
+
+TEST_F(TailSamplerTest, EvictsExpiredTraces) {
+  auto options = Options();
+  options.latency_threshold = absl::ZeroDuration();
+  options.trace_timeout = absl::ZeroDuration();
+  exporter::SpanExporter::EnableTailSampling(options);
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  auto child = Span::StartSpan("child", &root, {&never_sampler_});
+  child.End();
+  // Every shard is swept at most once a second, when any Span ends.
+  absl::SleepFor(absl::Milliseconds(1100));
+  auto other = Span::StartSpan("other", nullptr, {&never_sampler_});
+  other.End();
+  EXPECT_EQ(1, StatsDelta().evicted_traces);
+}
+
+TEST_F(TailSamplerTest, TailOnlySpansAreNotInSpanStores) {
+  exporter::SpanExporter::EnableTailSampling(Options());
+  auto root = Span::StartSpan("tail_only", nullptr, {&never_sampler_});
+  EXPECT_EQ(0, exporter::RunningSpanStore::GetSummary()
+                   .per_span_name_summary.count("tail_only"));
+  root.End();
+  for (const auto& span : exporter::LocalSpanStore::GetSpans()) {
+    EXPECT_NE("tail_only", span.name());
+  }
+}
+
+TEST_F(TailSamplerTest, DisableClearsBufferedTraces) {
+  auto options = Options();
+  options.latency_threshold = absl::ZeroDuration();
+  exporter::SpanExporter::EnableTailSampling(options);
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  auto child = Span::StartSpan("child", &root, {&never_sampler_});
+  child.End();
+  exporter::SpanExporter::DisableTailSampling();
+  EXPECT_EQ(1, StatsDelta().evicted_traces);
+  // The root starts a new trace, without the child.
+  exporter::SpanExporter::EnableTailSampling(options);
+  root.End();
+  EXPECT_EQ(std::vector<std::string>({"root"}), exporter_->TakeNames());
+}
+
+TEST_F(TailSamplerTest, SpansEndedAfterDisableAreDropped) {
+  auto options = Options();
+  options.latency_threshold = absl::ZeroDuration();
+  exporter::SpanExporter::EnableTailSampling(options);
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  EXPECT_TRUE(root.IsRecording());
+  exporter::SpanExporter::DisableTailSampling();
+  root.End();
+  EXPECT_TRUE(exporter_->TakeNames().empty());
+  EXPECT_EQ(0, StatsDelta().kept_traces);
+}
+
+TEST_F(TailSamplerTest, DisableStopsRecording) {
+  exporter::SpanExporter::EnableTailSampling(Options());
+  exporter::SpanExporter::DisableTailSampling();
+  auto root = Span::StartSpan("root", nullptr, {&never_sampler_});
+  EXPECT_FALSE(root.IsRecording());
+  root.End();
+  EXPECT_EQ(0, StatsDelta().dropped_traces);
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
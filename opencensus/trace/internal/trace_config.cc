@@ -13,7 +13,12 @@
 // limitations under the License.
 
 #include "opencensus/trace/trace_config.h"
+
+#include <memory>
+#include <utility>
+
 #include "opencensus/trace/internal/trace_config_impl.h"
+#include "opencensus/trace/sampler.h"
 #include "opencensus/trace/trace_params.h"
 
 namespace opencensus {
@@ -23,5 +28,13 @@ void TraceConfig::SetCurrentTraceParams(const TraceParams& params) {
   TraceConfigImpl::Get()->SetCurrentTraceParams(params);
 }
 
+void TraceConfig::SetDefaultSampler(std::shared_ptr<const Sampler> sampler) {
+  TraceConfigImpl::Get()->SetDefaultSampler(std::move(sampler));
+}
+
+void TraceConfig::SetRunningSpanTracking(RunningSpanTracking tracking) {
+  TraceConfigImpl::Get()->SetRunningSpanTracking(tracking);
+}
+
 }  // namespace trace
 }  // namespace opencensus
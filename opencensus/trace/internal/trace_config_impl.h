@@ -15,9 +15,13 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_TRACE_CONFIG_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_TRACE_CONFIG_IMPL_H_
 
+#include <atomic>
 #include <memory>
+#include <utility>
 
+#include "opencensus/common/internal/rcu.h"
 #include "opencensus/trace/internal/trace_params_impl.h"
+#include "opencensus/trace/sampler.h"
 #include "opencensus/trace/trace_config.h"
 #include "opencensus/trace/trace_params.h"
 
@@ -35,14 +39,31 @@ class TraceConfigImpl {
     current_trace_params_.Set(params);
   }
 
-  TraceParams current_trace_params() const {
-    return current_trace_params_.Get();
+  void SetDefaultSampler(std::shared_ptr<const Sampler> sampler) {
+    current_trace_params_.SetSampler(std::move(sampler));
+  }
+
+  // Returns the active TraceParams and default Sampler, which remain valid
+  // while lock is held.
+  const TraceParamsImpl::Snapshot* current_trace_params(
+      const common::RcuReadLock& lock) const {
+    return current_trace_params_.Get(lock);
+  }
+
+  void SetRunningSpanTracking(RunningSpanTracking tracking) {
+    running_span_tracking_.store(tracking, std::memory_order_relaxed);
+  }
+
+  RunningSpanTracking running_span_tracking() const {
+    return running_span_tracking_.load(std::memory_order_relaxed);
   }
 
  private:
   TraceConfigImpl(const TraceParams& params) : current_trace_params_(params) {}
 
   TraceParamsImpl current_trace_params_;
+  std::atomic<RunningSpanTracking> running_span_tracking_{
+      RunningSpanTracking::kSharded};
 };
 
 }  // namespace trace
@@ -15,10 +15,15 @@
 #include "opencensus/trace/trace_config.h"
 
 #include <atomic>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "gtest/gtest.h"
+#include "opencensus/trace/sampler.h"
 #include "opencensus/trace/span.h"
 #include "opencensus/trace/trace_params.h"
 
@@ -62,6 +67,41 @@ TEST(TraceConfigTest, MultiThreaded) {
   }
 }
 
+// Samples Spans by name.
+class NameSampler final : public Sampler {
+ public:
+  explicit NameSampler(absl::string_view name) : name_(name) {}
+
+  bool ShouldSample(const SpanContext* parent_context, bool has_remote_parent,
+                    const TraceId& trace_id, const SpanId& span_id,
+                    absl::string_view name,
+                    const std::vector<Span*>& parent_links) const override {
+    return name == name_;
+  }
+
+ private:
+  const std::string name_;
+};
+
+TEST(TraceConfigTest, SetDefaultSampler) {
+  TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ProbabilitySampler(0.0)});
+  TraceConfig::SetDefaultSampler(std::make_shared<NameSampler>("Sampled"));
+  auto sampled = Span::StartSpan("Sampled");
+  auto not_sampled = Span::StartSpan("NotSampled");
+  EXPECT_TRUE(sampled.IsSampled());
+  EXPECT_FALSE(not_sampled.IsSampled());
+  sampled.End();
+  not_sampled.End();
+
+  // Setting TraceParams restores their ProbabilitySampler.
+  TraceConfig::SetCurrentTraceParams(
+      {32, 32, 128, 128, ProbabilitySampler(0.0)});
+  auto span = Span::StartSpan("Sampled");
+  EXPECT_FALSE(span.IsSampled());
+  span.End();
+}
+
 }  // namespace
 }  // namespace trace
 }  // namespace opencensus
@@ -0,0 +1,227 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/propagation/trace_context.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/internal/hex.h"
+#include "opencensus/trace/span_context.h"
+#include "opencensus/trace/span_id.h"
+#include "opencensus/trace/trace_id.h"
+#include "opencensus/trace/trace_options.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+namespace {
+
+// Offsets of the fields in a traceparent header.
+constexpr size_t kTraceIdOffset = 3;
+constexpr size_t kSpanIdOffset = kTraceIdOffset + 2 * TraceId::kSize + 1;
+constexpr size_t kOptionsOffset = kSpanIdOffset + 2 * SpanId::kSize + 1;
+static_assert(kOptionsOffset + 2 * TraceOptions::kSize == kTraceParentHeaderLen,
+              "Unexpected traceparent layout.");
+
+constexpr uint8_t kInvalidVersion = 0xff;
+// Version 00 defines only the sampled flag.
+constexpr uint8_t kSampledFlag = 0x01;
+
+constexpr size_t kMaxKeyLen = 256;
+constexpr size_t kMaxTenantLen = 241;
+constexpr size_t kMaxSystemLen = 14;
+constexpr size_t kMaxValueLen = 256;
+
+bool IsLowerAlpha(char c) { return c >= 'a' && c <= 'z'; }
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsKeyChar(char c) {
+  return IsLowerAlpha(c) || IsDigit(c) || c == '_' || c == '-' || c == '*' ||
+         c == '/';
+}
+
+// A key is either "name" or "tenant@system".
+bool IsValidKey(absl::string_view key) {
+  if (key.empty() || key.size() > kMaxKeyLen) return false;
+  const size_t at = key.find('@');
+  if (at == absl::string_view::npos) {
+    if (!IsLowerAlpha(key[0])) return false;
+  } else {
+    const absl::string_view tenant = key.substr(0, at);
+    const absl::string_view system = key.substr(at + 1);
+    if (tenant.empty() || tenant.size() > kMaxTenantLen ||
+        !(IsLowerAlpha(tenant[0]) || IsDigit(tenant[0])) || system.empty() ||
+        system.size() > kMaxSystemLen || !IsLowerAlpha(system[0])) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < key.size(); ++i) {
+    if (i != at && !IsKeyChar(key[i])) return false;
+  }
+  return true;
+}
+
+// A value is printable ASCII, except ',' and '=', and does not end with a
+// space.
+bool IsValidValue(absl::string_view value) {
+  if (value.empty() || value.size() > kMaxValueLen || value.back() == ' ') {
+    return false;
+  }
+  for (char c : value) {
+    if (c < 0x20 || c > 0x7e || c == ',' || c == '=') return false;
+  }
+  return true;
+}
+
+bool IsWhitespace(char c) { return c == ' ' || c == '\t'; }
+
+absl::string_view StripWhitespace(absl::string_view s) {
+  while (!s.empty() && IsWhitespace(s.front())) s.remove_prefix(1);
+  while (!s.empty() && IsWhitespace(s.back())) s.remove_suffix(1);
+  return s;
+}
+
+// Returns true if keys[0..n) contains key.
+bool ContainsKey(const absl::string_view* keys, size_t n,
+                 absl::string_view key) {
+  for (size_t i = 0; i < n; ++i) {
+    if (keys[i] == key) return true;
+  }
+  return false;
+}
+
+// Splits a tracestate header into list members, and calls fn for each valid
+// one until an invalid one is found. Returns true if all are valid.
+bool ForEachTraceStateEntry(
+    absl::string_view header,
+    absl::FunctionRef<void(absl::string_view, absl::string_view)> fn) {
+  absl::string_view keys[kMaxTraceStateEntries];
+  size_t num_entries = 0;
+  while (true) {
+    const size_t comma = header.find(',');
+    const absl::string_view member = StripWhitespace(header.substr(0, comma));
+    if (!member.empty()) {
+      const size_t eq = member.find('=');
+      if (eq == absl::string_view::npos) return false;
+      const absl::string_view key = member.substr(0, eq);
+      const absl::string_view value = member.substr(eq + 1);
+      if (num_entries == kMaxTraceStateEntries || !IsValidKey(key) ||
+          !IsValidValue(value) || ContainsKey(keys, num_entries, key)) {
+        return false;
+      }
+      keys[num_entries++] = key;
+      fn(key, value);
+    }
+    if (comma == absl::string_view::npos) return true;
+    header.remove_prefix(comma + 1);
+  }
+}
+
+}  // namespace
+
+SpanContext FromTraceParentHeader(absl::string_view header) {
+  if (header.size() < kTraceParentHeaderLen) return SpanContext();
+  const char* p = header.data();
+  if (p[kTraceIdOffset - 1] != '-' || p[kSpanIdOffset - 1] != '-' ||
+      p[kOptionsOffset - 1] != '-') {
+    return SpanContext();
+  }
+  uint8_t version;
+  uint8_t trace_id[TraceId::kSize];
+  uint8_t span_id[SpanId::kSize];
+  uint8_t options;
+  if (!DecodeHex(p, 1, &version) ||
+      !DecodeHex(p + kTraceIdOffset, TraceId::kSize, trace_id) ||
+      !DecodeHex(p + kSpanIdOffset, SpanId::kSize, span_id) ||
+      !DecodeHex(p + kOptionsOffset, TraceOptions::kSize, &options) ||
+      version == kInvalidVersion) {
+    return SpanContext();
+  }
+  if (header.size() > kTraceParentHeaderLen &&
+      (version == 0 || p[kTraceParentHeaderLen] != '-')) {
+    return SpanContext();
+  }
+  options &= kSampledFlag;
+  return SpanContext(TraceId(trace_id), SpanId(span_id),
+                     TraceOptions(&options));
+}
+
+void ToTraceParentHeader(const SpanContext& ctx, char* out) {
+  uint8_t trace_id[TraceId::kSize];
+  uint8_t span_id[SpanId::kSize];
+  uint8_t options;
+  ctx.trace_id().CopyTo(trace_id);
+  ctx.span_id().CopyTo(span_id);
+  ctx.trace_options().CopyTo(&options);
+  options &= kSampledFlag;
+  out[0] = '0';
+  out[1] = '0';
+  out[kTraceIdOffset - 1] = '-';
+  EncodeHex(trace_id, TraceId::kSize, out + kTraceIdOffset);
+  out[kSpanIdOffset - 1] = '-';
+  EncodeHex(span_id, SpanId::kSize, out + kSpanIdOffset);
+  out[kOptionsOffset - 1] = '-';
+  EncodeHex(&options, TraceOptions::kSize, out + kOptionsOffset);
+}
+
+std::string ToTraceParentHeader(const SpanContext& ctx) {
+  char buf[kTraceParentHeaderLen];
+  ToTraceParentHeader(ctx, buf);
+  return std::string(buf, kTraceParentHeaderLen);
+}
+
+bool ParseTraceStateHeader(
+    absl::string_view header,
+    absl::FunctionRef<void(absl::string_view key, absl::string_view value)>
+        fn) {
+  // Validate the whole header first, so that fn sees all or nothing.
+  if (!ForEachTraceStateEntry(header,
+                              [](absl::string_view, absl::string_view) {})) {
+    return false;
+  }
+  ForEachTraceStateEntry(header, fn);
+  return true;
+}
+
+size_t ToTraceStateHeader(absl::Span<const TraceStateEntry> entries, char* out,
+                          size_t size) {
+  if (entries.size() > kMaxTraceStateEntries) return 0;
+  size_t len = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const TraceStateEntry& entry = entries[i];
+    if (!IsValidKey(entry.first) || !IsValidValue(entry.second)) return 0;
+    for (size_t j = 0; j < i; ++j) {
+      if (entries[j].first == entry.first) return 0;
+    }
+    len += (i == 0 ? 0 : 1) + entry.first.size() + 1 + entry.second.size();
+  }
+  if (len > size) return 0;
+  char* p = out;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i != 0) *p++ = ',';
+    memcpy(p, entries[i].first.data(), entries[i].first.size());
+    p += entries[i].first.size();
+    *p++ = '=';
+    memcpy(p, entries[i].second.data(), entries[i].second.size());
+    p += entries[i].second.size();
+  }
+  return len;
+}
+
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
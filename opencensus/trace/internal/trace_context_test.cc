@@ -0,0 +1,174 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/propagation/trace_context.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+namespace {
+
+constexpr char kHeader[] =
+    "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01";
+
+TEST(TraceContextTest, ParseFull) {
+  SpanContext ctx = FromTraceParentHeader(kHeader);
+  EXPECT_TRUE(ctx.IsValid());
+  EXPECT_EQ("0af7651916cd43dd8448eb211c80319c", ctx.trace_id().ToHex());
+  EXPECT_EQ("b7ad6b7169203331", ctx.span_id().ToHex());
+  EXPECT_TRUE(ctx.trace_options().IsSampled());
+}
+
+TEST(TraceContextTest, ParseNotSampled) {
+  SpanContext ctx = FromTraceParentHeader(
+      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-00");
+  EXPECT_TRUE(ctx.IsValid());
+  EXPECT_FALSE(ctx.trace_options().IsSampled());
+}
+
+TEST(TraceContextTest, RoundTrip) {
+  EXPECT_EQ(kHeader, ToTraceParentHeader(FromTraceParentHeader(kHeader)));
+}
+
+TEST(TraceContextTest, SerializeToBuffer) {
+  char buf[kTraceParentHeaderLen];
+  ToTraceParentHeader(FromTraceParentHeader(kHeader), buf);
+  EXPECT_EQ(kHeader, absl::string_view(buf, sizeof(buf)));
+}
+
+TEST(TraceContextTest, FutureVersion) {
+  EXPECT_TRUE(
+      FromTraceParentHeader(
+          "cc-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01-what")
+          .IsValid());
+  EXPECT_FALSE(
+      FromTraceParentHeader(
+          "cc-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01what")
+          .IsValid());
+}
+
+TEST(TraceContextTest, Malformed) {
+  const std::vector<std::string> headers = {
+      "",
+      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331",
+      // Trailing data in version 00.
+      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01-",
+      // Invalid version.
+      "ff-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01",
+      // Uppercase hex.
+      "00-0AF7651916CD43DD8448EB211C80319C-b7ad6b7169203331-01",
+      // Bad separators.
+      "00_0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01",
+      "00-0af7651916cd43dd8448eb211c80319c_b7ad6b7169203331-01",
+      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331_01",
+      // Non-hex.
+      "00-0af7651916cd43dd8448eb211c80319x-b7ad6b7169203331-01",
+      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b716920333 -01",
+      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-0g",
+      // Zero TraceId or SpanId.
+      "00-00000000000000000000000000000000-b7ad6b7169203331-01",
+      "00-0af7651916cd43dd8448eb211c80319c-0000000000000000-01",
+  };
+  for (const auto& header : headers) {
+    EXPECT_FALSE(FromTraceParentHeader(header).IsValid()) << header;
+  }
+}
+
+std::vector<TraceStateEntry> ParseTraceState(absl::string_view header,
+                                             bool* ok) {
+  std::vector<TraceStateEntry> entries;
+  *ok = ParseTraceStateHeader(
+      header, [&entries](absl::string_view key, absl::string_view value) {
+        entries.emplace_back(key, value);
+      });
+  return entries;
+}
+
+TEST(TraceContextTest, ParseTraceState) {
+  bool ok;
+  const auto entries = ParseTraceState(
+      "rojo=00f067aa0ba902b7, congo=t61rcWkgMzE,,\tfoo@bar=a b ", &ok);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(std::vector<TraceStateEntry>({{"rojo", "00f067aa0ba902b7"},
+                                          {"congo", "t61rcWkgMzE"},
+                                          {"foo@bar", "a b"}}),
+            entries);
+}
+
+TEST(TraceContextTest, ParseEmptyTraceState) {
+  bool ok;
+  EXPECT_TRUE(ParseTraceState("", &ok).empty());
+  EXPECT_TRUE(ok);
+}
+
+TEST(TraceContextTest, MalformedTraceState) {
+  const std::vector<std::string> headers = {
+      "novalue",
+      "key=",
+      "=value",
+      "Upper=value",
+      "1key=value",
+      "key=val,ue=x=y",
+      "@system=value",
+      "tenant@=value",
+      "tenant@1system=value",
+      "a@b@c=value",
+      "dup=1,dup=2",
+      std::string("key=\x7f"),
+  };
+  for (const auto& header : headers) {
+    bool ok;
+    EXPECT_TRUE(ParseTraceState(header, &ok).empty()) << header;
+    EXPECT_FALSE(ok) << header;
+  }
+}
+
+TEST(TraceContextTest, TooManyTraceStateEntries) {
+  std::string header;
+  for (int i = 0; i < 33; ++i) {
+    if (i != 0) header += ",";
+    header += "k" + std::to_string(i) + "=v";
+  }
+  bool ok;
+  ParseTraceState(header, &ok);
+  EXPECT_FALSE(ok);
+  header.resize(header.rfind(','));
+  ParseTraceState(header, &ok);
+  EXPECT_TRUE(ok);
+}
+
+TEST(TraceContextTest, SerializeTraceState) {
+  const std::vector<TraceStateEntry> entries = {{"rojo", "00f067aa0ba902b7"},
+                                                {"foo@bar", "a b"}};
+  char buf[64];
+  const size_t len = ToTraceStateHeader(entries, buf, sizeof(buf));
+  EXPECT_EQ("rojo=00f067aa0ba902b7,foo@bar=a b", absl::string_view(buf, len));
+  // Too small.
+  EXPECT_EQ(0, ToTraceStateHeader(entries, buf, len - 1));
+  // Invalid.
+  EXPECT_EQ(0, ToTraceStateHeader({{"rojo", "a,b"}}, buf, sizeof(buf)));
+  EXPECT_EQ(0, ToTraceStateHeader({{"a", "1"}, {"a", "2"}}, buf, sizeof(buf)));
+}
+
+}  // namespace
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
@@ -15,15 +15,20 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_TRACE_EVENTS_H_
 #define OPENCENSUS_TRACE_INTERNAL_TRACE_EVENTS_H_
 
+#include <algorithm>
 #include <cstdint>
-#include <deque>
 #include <utility>
+#include <vector>
 
 namespace opencensus {
 namespace trace {
 
 // A fixed size FIFO queue of events of type T.  T must have a valid copy
 // constructor. TraceEvents is thread-compatible.
+//
+// Events are stored in a ring buffer that grows geometrically up to max_events
+// and then evicts the oldest event in place, so adding an event does not
+// allocate once the buffer has grown.
 template <typename T>
 class TraceEvents final {
  public:
@@ -42,13 +47,29 @@ class TraceEvents final {
   void AddEvent(const T& event);
   void AddEvent(T&& event);
 
-  // Returns a vector of populate with all the events currently in the queue.
-  const std::deque<T>& events() const;
+  // Returns the number of events currently in the queue.
+  uint32_t size() const { return events_.size(); }
+
+  // Calls fn(event) for each event currently in the queue, oldest first.
+  template <typename F>
+  void ForEach(F fn) const;
+
+  // Moves all the events out of the queue, oldest first, leaving it empty.
+  // num_events_dropped() is unchanged.
+  std::vector<T> TakeEvents();
 
  private:
+  // The initial capacity of events_, if max_events_ allows.
+  static constexpr uint32_t kInitialCapacity = 4;
+
+  template <typename U>
+  void AddEventImpl(U&& event);
+
   uint32_t total_recorded_events_;
   uint32_t max_events_;
-  std::deque<T> events_;
+  // Once events_ holds max_events_ events, head_ is the index of the oldest.
+  uint32_t head_ = 0;
+  std::vector<T> events_;
 };
 
 template <typename T>
@@ -58,40 +79,61 @@ inline uint32_t TraceEvents<T>::num_events_dropped() const {
 
 template <typename T>
 inline uint32_t TraceEvents<T>::num_events_recorded() const {
-  return num_events_recorded;
+  return total_recorded_events_;
 }
 
 template <typename T>
 inline void TraceEvents<T>::AddEvent(const T& event) {
+  AddEventImpl(event);
+}
+
+template <typename T>
+inline void TraceEvents<T>::AddEvent(T&& event) {
+  AddEventImpl(std::move(event));
+}
+
+template <typename T>
+template <typename U>
+inline void TraceEvents<T>::AddEventImpl(U&& event) {
   // Blank span has 0 max events.
   if (max_events_ == 0) {
     return;
   }
 
   if (events_.size() >= max_events_) {
-    events_.pop_front();
+    events_[head_] = std::forward<U>(event);
+    head_ = head_ + 1 == max_events_ ? 0 : head_ + 1;
+  } else {
+    if (events_.size() == events_.capacity()) {
+      // Grow geometrically, but never beyond max_events_.
+      events_.reserve(std::min<uint32_t>(
+          max_events_, std::max<uint32_t>(uint32_t{kInitialCapacity},
+                                          2 * events_.capacity())));
+    }
+    events_.emplace_back(std::forward<U>(event));
   }
-  events_.emplace_back(event);
   total_recorded_events_++;
 }
 
 template <typename T>
-inline void TraceEvents<T>::AddEvent(T&& event) {
-  // Blank span has 0 max events.
-  if (max_events_ == 0) {
-    return;
+template <typename F>
+inline void TraceEvents<T>::ForEach(F fn) const {
+  for (uint32_t i = head_; i < events_.size(); ++i) {
+    fn(events_[i]);
   }
-
-  if (events_.size() >= max_events_) {
-    events_.pop_front();
+  for (uint32_t i = 0; i < head_; ++i) {
+    fn(events_[i]);
   }
-  events_.emplace_back(std::move(event));
-  total_recorded_events_++;
 }
 
 template <typename T>
-inline const std::deque<T>& TraceEvents<T>::events() const {
-  return events_;
+inline std::vector<T> TraceEvents<T>::TakeEvents() {
+  total_recorded_events_ -= events_.size();
+  std::rotate(events_.begin(), events_.begin() + head_, events_.end());
+  head_ = 0;
+  std::vector<T> events;
+  std::swap(events, events_);
+  return events;
 }
 
 }  // namespace trace
@@ -0,0 +1,69 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/internal/trace_events.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+std::vector<int> Events(const TraceEvents<int>& events) {
+  std::vector<int> out;
+  events.ForEach([&out](int event) { out.push_back(event); });
+  return out;
+}
+
+TEST(TraceEventsTest, KeepsEventsInOrder) {
+  TraceEvents<int> events(10);
+  for (int i = 0; i < 7; ++i) events.AddEvent(i);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6}), Events(events));
+  EXPECT_EQ(7, events.size());
+  EXPECT_EQ(0, events.num_events_dropped());
+  EXPECT_EQ(7, events.num_events_recorded());
+}
+
+TEST(TraceEventsTest, EvictsOldestEvents) {
+  TraceEvents<int> events(3);
+  for (int i = 0; i < 8; ++i) events.AddEvent(i);
+  EXPECT_EQ(std::vector<int>({5, 6, 7}), Events(events));
+  EXPECT_EQ(5, events.num_events_dropped());
+  EXPECT_EQ(8, events.num_events_recorded());
+}
+
+TEST(TraceEventsTest, TakeEventsInOrder) {
+  TraceEvents<int> events(4);
+  for (int i = 0; i < 6; ++i) events.AddEvent(i);
+  EXPECT_EQ(std::vector<int>({2, 3, 4, 5}), events.TakeEvents());
+  EXPECT_EQ(0, events.size());
+  EXPECT_EQ(2, events.num_events_dropped());
+
+  // The queue can be reused.
+  events.AddEvent(6);
+  EXPECT_EQ(std::vector<int>({6}), Events(events));
+}
+
+TEST(TraceEventsTest, ZeroMaxEvents) {
+  TraceEvents<int> events(0);
+  events.AddEvent(1);
+  EXPECT_EQ(0, events.size());
+  EXPECT_EQ(0, events.num_events_recorded());
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
@@ -15,9 +15,13 @@
 #ifndef OPENCENSUS_TRACE_INTERNAL_TRACE_PARAMS_IMPL_H_
 #define OPENCENSUS_TRACE_INTERNAL_TRACE_PARAMS_IMPL_H_
 
-#include <atomic>
-#include <cstdint>
+#include <memory>
+#include <utility>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "opencensus/common/internal/rcu.h"
 #include "opencensus/trace/sampler.h"
 #include "opencensus/trace/trace_params.h"
 
@@ -25,42 +29,50 @@ namespace opencensus {
 namespace trace {
 
 // TraceParamsImpl is used by TraceConfigImpl to hold the currently active
-// TraceParams.
+// TraceParams and default Sampler.
 //
-// TraceParamsImpl can be updated or retrieved via a TraceParams object.  Atomic
-// reads or updates of multiple parameters are not supported, because reading
-// from TraceParamsImpl happens on every StartSpan and we don't want to have a
-// global lock.
+// They are published together as an immutable Snapshot, so a reader sees a
+// consistent set of parameters with a single atomic load, and without taking a
+// lock: reading happens on every StartSpan.
 class TraceParamsImpl final {
  public:
-  explicit TraceParamsImpl(const TraceParams& p) { Set(p); }
+  struct Snapshot {
+    TraceParams params;
+    // The Sampler used for Spans that aren't started with one. This is
+    // params.sampler unless it was replaced by SetSampler().
+    std::shared_ptr<const Sampler> sampler;
+  };
 
-  // TraceParamsImpl can be updated non-atomically: the
-  // individual elements are updated separately.
-  void Set(const TraceParams& p) {
-    max_attributes_.store(p.max_attributes, std::memory_order_release);
-    max_annotations_.store(p.max_annotations, std::memory_order_release);
-    max_message_events_.store(p.max_message_events, std::memory_order_release);
-    max_links_.store(p.max_links, std::memory_order_release);
-    probability_threshold_.store(p.sampler.threshold_,
-                                 std::memory_order_release);
+  explicit TraceParamsImpl(const TraceParams& p) : snapshot_(MakeSnapshot(p)) {}
+
+  // Replaces the parameters, including the default Sampler.
+  void Set(const TraceParams& p) LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    snapshot_.Update(MakeSnapshot(p));
+  }
+
+  // Replaces the default Sampler, keeping the other parameters.
+  void SetSampler(std::shared_ptr<const Sampler> sampler) LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    common::RcuReadLock lock;
+    snapshot_.Update(absl::WrapUnique(
+        new Snapshot{snapshot_.Read(lock)->params, std::move(sampler)}));
   }
 
-  TraceParams Get() const {
-    return TraceParams{max_attributes_.load(std::memory_order_acquire),
-                       max_annotations_.load(std::memory_order_acquire),
-                       max_message_events_.load(std::memory_order_acquire),
-                       max_links_.load(std::memory_order_acquire),
-                       ProbabilitySampler(probability_threshold_.load(
-                           std::memory_order_acquire))};
+  // Returns the current Snapshot, which remains valid while lock is held.
+  const Snapshot* Get(const common::RcuReadLock& lock) const {
+    return snapshot_.Read(lock);
   }
 
  private:
-  std::atomic<uint32_t> max_attributes_;
-  std::atomic<uint32_t> max_annotations_;
-  std::atomic<uint32_t> max_message_events_;
-  std::atomic<uint32_t> max_links_;
-  std::atomic<uint64_t> probability_threshold_;
+  static std::unique_ptr<const Snapshot> MakeSnapshot(const TraceParams& p) {
+    return absl::WrapUnique(
+        new Snapshot{p, std::make_shared<ProbabilitySampler>(p.sampler)});
+  }
+
+  // Serializes updates, so that SetSampler() does not lose a concurrent Set().
+  absl::Mutex mu_;
+  common::RcuPtr<Snapshot> snapshot_;
 };
 
 }  // namespace trace
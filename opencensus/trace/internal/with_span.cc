@@ -0,0 +1,39 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/with_span.h"
+
+#include <functional>
+
+#include "opencensus/trace/span.h"
+
+namespace opencensus {
+namespace trace {
+
+const Span& GetCurrentSpan() {
+  static const Span* blank_span = new Span(Span::BlankSpan());
+  const Span* span = WithSpan::current();
+  return span == nullptr ? *blank_span : *span;
+}
+
+std::function<void()> WrapWithCurrentSpan(std::function<void()> fn) {
+  const Span span = GetCurrentSpan();
+  return [span, fn]() {
+    WithSpan ws(span);
+    fn();
+  };
+}
+
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,128 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "opencensus/trace/with_span.h"
+
+#include <functional>
+#include <thread>  // NOLINT
+#include <type_traits>
+
+#include "gtest/gtest.h"
+#include "opencensus/trace/sampler.h"
+#include "opencensus/trace/span.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace {
+
+TEST(WithSpanTest, NoCurrentSpan) {
+  EXPECT_FALSE(GetCurrentSpan().context().IsValid());
+  auto span = Span::StartSpanWithCurrentParent("root");
+  EXPECT_TRUE(span.context().IsValid());
+  span.End();
+}
+
+TEST(WithSpanTest, StartsChildOfCurrentSpan) {
+  AlwaysSampler sampler;
+  auto parent = Span::StartSpan("parent", nullptr, {&sampler});
+  {
+    WithSpan ws(parent);
+    EXPECT_EQ(parent.context(), GetCurrentSpan().context());
+    auto child = Span::StartSpanWithCurrentParent("child");
+    EXPECT_EQ(parent.context().trace_id(), child.context().trace_id());
+    EXPECT_TRUE(child.IsSampled());
+    child.End();
+  }
+  EXPECT_FALSE(GetCurrentSpan().context().IsValid());
+  auto root = Span::StartSpanWithCurrentParent("root");
+  EXPECT_FALSE(parent.context().trace_id() == root.context().trace_id());
+  root.End();
+  parent.End();
+}
+
+TEST(WithSpanTest, Nesting) {
+  auto span1 = Span::StartSpan("span1");
+  auto span2 = Span::StartSpan("span2");
+  {
+    WithSpan ws1(span1);
+    {
+      WithSpan ws2(span2);
+      EXPECT_EQ(span2.context(), GetCurrentSpan().context());
+    }
+    EXPECT_EQ(span1.context(), GetCurrentSpan().context());
+  }
+  EXPECT_FALSE(GetCurrentSpan().context().IsValid());
+  span1.End();
+  span2.End();
+}
+
+TEST(WithSpanTest, Conditional) {
+  auto span1 = Span::StartSpan("span1");
+  auto span2 = Span::StartSpan("span2");
+  WithSpan ws1(span1);
+  {
+    WithSpan ws2(span2, false);
+    EXPECT_EQ(span1.context(), GetCurrentSpan().context());
+  }
+  EXPECT_EQ(span1.context(), GetCurrentSpan().context());
+  span1.End();
+  span2.End();
+}
+
+TEST(WithSpanTest, BlankCurrentSpanStartsRoot) {
+  auto blank = Span::BlankSpan();
+  WithSpan ws(blank);
+  auto span = Span::StartSpanWithCurrentParent("root");
+  EXPECT_TRUE(span.context().IsValid());
+  span.End();
+}
+
+TEST(WithSpanTest, CurrentSpanIsPerThread) {
+  auto span = Span::StartSpan("span");
+  WithSpan ws(span);
+  std::thread t([]() { EXPECT_FALSE(GetCurrentSpan().context().IsValid()); });
+  t.join();
+  span.End();
+}
+
+TEST(WithSpanTest, RejectsTemporarySpans) {
+  static_assert(std::is_constructible<WithSpan, const Span&>::value, "");
+  static_assert(std::is_constructible<WithSpan, Span&>::value, "");
+  static_assert(!std::is_constructible<WithSpan, Span&&>::value,
+                "WithSpan must not refer to a temporary Span");
+  static_assert(!std::is_constructible<WithSpan, Span, bool>::value,
+                "WithSpan must not refer to a temporary Span");
+}
+
+TEST(WithSpanTest, WrapWithCurrentSpan) {
+  auto span = Span::StartSpan("span");
+  std::function<void()> fn;
+  {
+    WithSpan ws(span);
+    fn = WrapWithCurrentSpan([&span]() {
+      EXPECT_EQ(span.context(), GetCurrentSpan().context());
+    });
+  }
+  // Runs on another thread, after the scope has ended.
+  std::thread t(fn);
+  t.join();
+  fn();
+  EXPECT_FALSE(GetCurrentSpan().context().IsValid());
+  span.End();
+}
+
+}  // namespace
+}  // namespace trace
+}  // namespace opencensus
@@ -0,0 +1,80 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_PROPAGATION_B3_H_
+#define OPENCENSUS_TRACE_PROPAGATION_B3_H_
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+
+// Codecs for the B3 headers used by Zipkin, both the multiple "X-B3-*"
+// headers and the single "b3" header. See
+// https://github.com/openzipkin/b3-propagation
+//
+// Parsing and serializing into a caller-provided buffer do not allocate.
+
+// The lengths of the serialized X-B3-TraceId and X-B3-SpanId headers.
+constexpr size_t kB3TraceIdHeaderLen = 32;
+constexpr size_t kB3SpanIdHeaderLen = 16;
+
+// Parses the values of the X-B3-TraceId, X-B3-SpanId, X-B3-Sampled and
+// X-B3-Flags headers; the last two may be empty. A 16-char TraceId is
+// zero-extended to 128 bits. The Span is sampled if Sampled is "1" or "true",
+// or Flags is "1" (debug). Returns an invalid SpanContext if a header is
+// malformed.
+SpanContext FromB3Headers(absl::string_view b3_trace_id,
+                          absl::string_view b3_span_id,
+                          absl::string_view b3_sampled,
+                          absl::string_view b3_flags);
+
+// Writes the X-B3-TraceId header for ctx to out, which must hold
+// kB3TraceIdHeaderLen chars.
+void ToB3TraceIdHeader(const SpanContext& ctx, char* out);
+std::string ToB3TraceIdHeader(const SpanContext& ctx);
+
+// Writes the X-B3-SpanId header for ctx to out, which must hold
+// kB3SpanIdHeaderLen chars.
+void ToB3SpanIdHeader(const SpanContext& ctx, char* out);
+std::string ToB3SpanIdHeader(const SpanContext& ctx);
+
+// Returns the X-B3-Sampled header for ctx: "1" or "0".
+absl::string_view ToB3SampledHeader(const SpanContext& ctx);
+
+// The length of a serialized b3 header, "{TraceId}-{SpanId}-{Sampled}".
+constexpr size_t kB3SingleHeaderLen =
+    kB3TraceIdHeaderLen + 1 + kB3SpanIdHeaderLen + 2;
+
+// Parses a b3 header: "{TraceId}-{SpanId}", optionally followed by
+// "-{SamplingState}" and "-{ParentSpanId}", which is ignored. SamplingState is
+// "1", "0" or "d" (debug, which implies sampled). A header that carries only
+// a SamplingState, or is malformed, gives an invalid SpanContext.
+SpanContext FromB3SingleHeader(absl::string_view header);
+
+// Writes the b3 header for ctx to out, which must hold kB3SingleHeaderLen
+// chars.
+void ToB3SingleHeader(const SpanContext& ctx, char* out);
+std::string ToB3SingleHeader(const SpanContext& ctx);
+
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_PROPAGATION_B3_H_
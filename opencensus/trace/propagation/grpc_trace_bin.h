@@ -0,0 +1,54 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_PROPAGATION_GRPC_TRACE_BIN_H_
+#define OPENCENSUS_TRACE_PROPAGATION_GRPC_TRACE_BIN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+
+// Codec for the OpenCensus binary format, which gRPC carries in the
+// "grpc-trace-bin" metadata. See
+// https://github.com/census-instrumentation/opencensus-specs/blob/master/encodings/BinaryEncoding.md
+//
+// Parsing and serializing into a caller-provided buffer do not allocate.
+
+// The length of a serialized header: a version byte, then the TraceId, SpanId
+// and TraceOptions fields, each preceded by its field id.
+constexpr size_t kGrpcTraceBinHeaderLen = 29;
+
+// Parses a grpc-trace-bin header. Returns an invalid SpanContext if the header
+// is malformed. Trailing bytes, which later versions may add, are ignored.
+SpanContext FromGrpcTraceBinHeader(absl::string_view header);
+
+// Writes the grpc-trace-bin header for ctx to out, which must hold
+// kGrpcTraceBinHeaderLen bytes.
+void ToGrpcTraceBinHeader(const SpanContext& ctx, uint8_t* out);
+
+// Returns the grpc-trace-bin header for ctx.
+std::string ToGrpcTraceBinHeader(const SpanContext& ctx);
+
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_PROPAGATION_GRPC_TRACE_BIN_H_
@@ -0,0 +1,77 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_PROPAGATION_TRACE_CONTEXT_H_
+#define OPENCENSUS_TRACE_PROPAGATION_TRACE_CONTEXT_H_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "absl/functional/function_ref.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "opencensus/trace/span_context.h"
+
+namespace opencensus {
+namespace trace {
+namespace propagation {
+
+// Codecs for the W3C Trace Context headers, "traceparent" and "tracestate".
+// See https://www.w3.org/TR/trace-context/
+//
+// Parsing and serializing into a caller-provided buffer do not allocate.
+
+// The length of a traceparent header, e.g.
+// "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01".
+constexpr size_t kTraceParentHeaderLen = 55;
+
+// Parses a traceparent header. Returns an invalid SpanContext if the header is
+// malformed, or its TraceId or SpanId is all zeros. Headers with a version
+// later than 00 are parsed as version 00, ignoring any trailing fields.
+SpanContext FromTraceParentHeader(absl::string_view header);
+
+// Writes the traceparent header for ctx to out, which must hold
+// kTraceParentHeaderLen chars. It is not NUL-terminated.
+void ToTraceParentHeader(const SpanContext& ctx, char* out);
+
+// Returns the traceparent header for ctx.
+std::string ToTraceParentHeader(const SpanContext& ctx);
+
+// A tracestate list member, as views into the header.
+using TraceStateEntry = std::pair<absl::string_view, absl::string_view>;
+
+// The maximum number of list members in a tracestate header.
+constexpr size_t kMaxTraceStateEntries = 32;
+
+// Parses a tracestate header, and calls fn(key, value) for each list member,
+// in order. Returns false, without calling fn, if the header is malformed:
+// it has an invalid key or value, a duplicate key, or more than
+// kMaxTraceStateEntries members. Empty list members are skipped.
+bool ParseTraceStateHeader(
+    absl::string_view header,
+    absl::FunctionRef<void(absl::string_view key, absl::string_view value)>
+        fn);
+
+// Writes the tracestate header for entries to out, which holds size chars.
+// Returns the number of chars written, or 0 if an entry is invalid or the
+// header does not fit.
+size_t ToTraceStateHeader(absl::Span<const TraceStateEntry> entries, char* out,
+                          size_t size);
+
+}  // namespace propagation
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_PROPAGATION_TRACE_CONTEXT_H_
@@ -0,0 +1,75 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef OPENCENSUS_TRACE_RESOURCE_USAGE_H_
+#define OPENCENSUS_TRACE_RESOURCE_USAGE_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace opencensus {
+namespace trace {
+
+class SpanImpl;
+
+// The attributes that Spans started with
+// StartSpanOptions::record_resource_usage record when they end.
+constexpr char kCpuTimeAttributeKey[] = "opencensus.io/trace/cpu_time_ns";
+constexpr char kAllocatedBytesAttributeKey[] =
+    "opencensus.io/trace/allocated_bytes";
+
+// ResourceUsage accounts for what recording Spans that ask for it (see
+// StartSpanOptions::record_resource_usage) use, besides wall time:
+//   - kCpuTimeAttributeKey: the CPU time, in nanoseconds, that the thread used
+//     between StartSpan() and End().
+//   - kAllocatedBytesAttributeKey: the bytes that the thread allocated in that
+//     time, if an AllocatedBytesFunction is set.
+//
+// Both include the usage of child Spans that ran on the same thread; subtract
+// the children's attributes to get a Span's self time. Neither is recorded if
+// the Span ends on a different thread than it started on, or if the Span
+// already has max_attributes attributes; user attributes are never evicted for
+// them. The AllocatedBytesFunction is called without any Span lock held.
+//
+// ResourceUsage is thread-safe.
+class ResourceUsage final {
+ public:
+  // Returns the total bytes that the calling thread has allocated so far, e.g.
+  // from the allocator's per-thread statistics.
+  using AllocatedBytesFunction = int64_t (*)();
+
+  // Sets the function used for kAllocatedBytesAttributeKey, or stops
+  // recording it if nullptr. Spans that already started are unaffected.
+  static void SetAllocatedBytesFunction(AllocatedBytesFunction function);
+
+  ResourceUsage() = delete;
+
+ private:
+  friend class SpanImpl;
+
+  // Returns the CPU time the calling thread has used, in nanoseconds, or -1 if
+  // it is not available.
+  static int64_t ThreadCpuNanos();
+
+  // Returns the function set by SetAllocatedBytesFunction().
+  static AllocatedBytesFunction allocated_bytes_function() {
+    return allocated_bytes_function_.load(std::memory_order_acquire);
+  }
+
+  static std::atomic<AllocatedBytesFunction> allocated_bytes_function_;
+};
+
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_RESOURCE_USAGE_H_
@@ -15,7 +15,9 @@
 #ifndef OPENCENSUS_TRACE_SAMPLER_H_
 #define OPENCENSUS_TRACE_SAMPLER_H_
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "absl/base/attributes.h"
@@ -58,13 +60,101 @@ class ProbabilitySampler final : public Sampler {
                     const std::vector<Span*>& parent_links) const override;
 
  private:
-  friend class TraceParamsImpl;  // For the global ProbabilitySampler.
-  explicit ProbabilitySampler(uint64_t threshold) : threshold_(threshold) {}
-
   // Probability is converted to a value between [0, UINT64_MAX].
   const uint64_t threshold_;
 };
 
+// Samples at most max_traces_per_second new traces per second, using a
+// lock-free token bucket that holds up to one second's worth of traces. This
+// bounds the number of sampled Spans independently of the request rate.
+//
+// Spans with a valid parent context (local or remote) follow the parent's
+// sampling decision and consume no tokens; only Spans that start a trace are
+// rate-limited. A root Span is sampled if a ProbabilitySampler with the given
+// probability samples its TraceId, which is consistent across processes, and
+// a token is available.
+class RateLimitingSampler final : public Sampler {
+ public:
+  explicit RateLimitingSampler(double max_traces_per_second,
+                               double probability = 1.0);
+
+  bool ShouldSample(const SpanContext* parent_context, bool has_remote_parent,
+                    const TraceId& trace_id, const SpanId& span_id,
+                    absl::string_view name,
+                    const std::vector<Span*>& parent_links) const override;
+
+ private:
+  // Returns true and takes a token if one is available at now_nanos.
+  bool TryAcquire(int64_t now_nanos) const;
+
+  const ProbabilitySampler probability_sampler_;
+  // The time it takes to accumulate one token, or -1 to never sample.
+  const int64_t interval_nanos_;
+  // How far ahead of the current time the bucket may be drained.
+  const int64_t burst_nanos_;
+  // The time at which the bucket will be full (the "theoretical arrival time"
+  // of the generic cell rate algorithm). Each sampled trace moves it forward by
+  // interval_nanos_.
+  mutable std::atomic<int64_t> full_time_nanos_;
+};
+
+// Samples root Spans with a per-name probability that adapts to each span
+// name's traffic, so that about target_traces_per_second traces are sampled in
+// total. The target is shared fairly between names: names with little traffic
+// are sampled in full, and the remainder is divided among the busier names.
+// Every name is sampled at up to min_traces_per_second_per_name even if that
+// exceeds the target, so that rare names are not starved by busy ones.
+//
+// Per-name rates are estimated from lock-free counters, and the probabilities
+// are recomputed about once per second by a thread calling ShouldSample. Names
+// are sampled in full until their first recomputation, which is brought
+// forward when a new name appears. Up to 1024 names are tracked separately;
+// further names share a single estimate, and names that are not seen for a
+// minute give up their slot. Decisions are consistent per TraceId
+// for a given probability, like ProbabilitySampler, and Spans with a valid
+// parent context follow the parent's decision.
+class AdaptiveSampler final : public Sampler {
+ public:
+  explicit AdaptiveSampler(double target_traces_per_second,
+                           double min_traces_per_second_per_name = 0);
+  ~AdaptiveSampler() override;
+
+  AdaptiveSampler(const AdaptiveSampler&) = delete;
+  AdaptiveSampler& operator=(const AdaptiveSampler&) = delete;
+
+  bool ShouldSample(const SpanContext* parent_context, bool has_remote_parent,
+                    const TraceId& trace_id, const SpanId& span_id,
+                    absl::string_view name,
+                    const std::vector<Span*>& parent_links) const override;
+
+ private:
+  friend class AdaptiveSamplerTestPeer;
+
+  struct Slot;
+
+  // Returns the slot for name, adding it if needed.
+  Slot* FindSlot(absl::string_view name) const;
+
+  // Recomputes the probabilities if it is time to, and no other thread is.
+  void MaybeAdjust(int64_t now_nanos) const;
+  void Adjust(int64_t now_nanos) const;
+
+  // Returns the current sampling probability for name.
+  double Probability(absl::string_view name) const;
+
+  const double target_traces_per_second_;
+  const double min_traces_per_second_per_name_;
+  // kNumSlots name slots, followed by one shared by names that don't fit.
+  const std::unique_ptr<Slot[]> slots_;
+  // The number of slots in use; at most kMaxNames.
+  mutable std::atomic<size_t> num_names_;
+  // Set while a thread is recomputing probabilities.
+  mutable std::atomic<bool> adjusting_;
+  mutable std::atomic<int64_t> next_adjust_nanos_;
+  // Only accessed while adjusting_ is held.
+  mutable int64_t last_adjust_nanos_;
+};
+
 // Always samples.
 class AlwaysSampler final : public Sampler {
  public:
@@ -15,6 +15,8 @@
 #ifndef OPENCENSUS_TRACE_SPAN_H_
 #define OPENCENSUS_TRACE_SPAN_H_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -40,6 +42,7 @@ class RunningSpanStoreImpl;
 class Span;
 class SpanGenerator;
 class SpanImpl;
+class SpanMetricsEntry;
 class SpanTestPeer;
 
 // AttributesRef is an initializer list of key-value pairs, used to pass
@@ -51,8 +54,11 @@ using AttributesRef =
 // Options for Starting a Span.
 struct StartSpanOptions {
   StartSpanOptions(Sampler* sampler = nullptr,  // Default Sampler.
-                   const std::vector<Span*>& parent_links = {})
-      : sampler(sampler), parent_links(parent_links) {}
+                   const std::vector<Span*>& parent_links = {},
+                   bool record_resource_usage = false)
+      : sampler(sampler),
+        parent_links(parent_links),
+        record_resource_usage(record_resource_usage) {}
 
   // The Sampler to use. It must remain valid for the duration of the
   // StartSpan() call. If nullptr, use the default Sampler from TraceConfig.
@@ -64,6 +70,11 @@ struct StartSpanOptions {
   // Pointers to Spans in *other Traces* that are parents of this Span. They
   // must remain valid for the duration of the StartSpan() call.
   const std::vector<Span*> parent_links;
+
+  // If true, and the Span records events, it records the CPU time and
+  // allocations of its thread between StartSpan() and End() as attributes.
+  // See resource_usage.h.
+  const bool record_resource_usage;
 };
 
 // Span represents a trace span. It has a SpanContext. Span is thread-safe.
@@ -73,6 +84,10 @@ class Span final {
   // attributes, etc, will all be no-ops.
   static Span BlankSpan();
 
+  // Span is copyable and movable; copies share the Span's data.
+  Span(const Span& other);
+  Span(Span&& other);
+
   // Constructs a root Span (if parent is nullptr) or a Span with a local
   // parent.
   //
@@ -87,6 +102,12 @@ class Span final {
   static Span StartSpan(absl::string_view name, const Span* parent = nullptr,
                         const StartSpanOptions& options = StartSpanOptions());
 
+  // Constructs a child of the thread's current Span (see with_span.h), or a
+  // root Span if there is no current Span or its context is invalid.
+  static Span StartSpanWithCurrentParent(
+      absl::string_view name,
+      const StartSpanOptions& options = StartSpanOptions());
+
   // Constructs a span with a remote parent.
   static Span StartSpanWithRemoteParent(
       absl::string_view name, const SpanContext& parent_ctx,
@@ -126,7 +147,9 @@ class Span final {
   void SetStatus(StatusCode canonical_code, absl::string_view message = "");
 
   // Marks the end of a Span. No further changes can be made to the Span after
-  // End is called.
+  // End is called. If span metrics are enabled (see span_metrics.h), End()
+  // should be called on only one copy of a Span that is not recording, since
+  // such copies do not share their status or whether they have ended.
   void End();
 
   // Returns the SpanContext associated with this Span.
@@ -143,7 +166,12 @@ class Span final {
 
  private:
   Span() {}
-  Span(const SpanContext& context, SpanImpl* impl);
+  // Constructs a Span that is not recording events. It records span metrics
+  // if metrics_entry is not nullptr.
+  explicit Span(const SpanContext& context,
+                const SpanMetricsEntry* metrics_entry = nullptr);
+  Span(const SpanContext& context, std::shared_ptr<SpanImpl> impl,
+       const SpanMetricsEntry* metrics_entry = nullptr);
 
   // Returns span_impl_, only used for testing.
   std::shared_ptr<SpanImpl> span_impl_for_test() { return span_impl_; }
@@ -156,6 +184,14 @@ class Span final {
   // Spans which are not recording events.
   std::shared_ptr<SpanImpl> span_impl_;
 
+  // The span metrics entry for the Span's name, if span metrics were enabled
+  // when it started.
+  const SpanMetricsEntry* const metrics_entry_ = nullptr;
+  // What span metrics need when a Span that is not recording ends: its start
+  // time in common::TscClock ticks, and its StatusCode or kMetricsEnded.
+  const int64_t metrics_start_ticks_ = 0;
+  std::atomic<uint8_t> metrics_status_{StatusCode::OK};
+
   friend class ::opencensus::trace::exporter::RunningSpanStoreImpl;
   friend class ::opencensus::trace::exporter::LocalSpanStoreImpl;
   friend class ::opencensus::trace::SpanTestPeer;
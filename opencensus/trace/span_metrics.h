@@ -0,0 +1,74 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_SPAN_METRICS_H_
+#define OPENCENSUS_TRACE_SPAN_METRICS_H_
+
+#include "opencensus/stats/measure.h"
+#include "opencensus/stats/tag_key.h"
+
+namespace opencensus {
+namespace trace {
+
+// The name of the measure that span metrics record to.
+constexpr char kSpanLatencyMeasureName[] = "opencensus.io/trace/span_latency";
+
+// SpanMetrics derives rate, error and duration metrics from Spans. When it is
+// enabled, every Span that ends, whether sampled or not, records its latency
+// in milliseconds to the kSpanLatencyMeasureName measure, tagged with the
+// Span's name ("span_name") and the name of its canonical status code
+// ("span_status", e.g. "OK" or "DEADLINE_EXCEEDED").
+//
+// Nothing is exported until views are registered on the measure. For example,
+// to export latency distributions and, through their counts, rates and errors:
+//   ::opencensus::trace::SpanMetrics::Enable();
+//   ::opencensus::stats::ViewDescriptor()
+//       .set_name("example.com/span_latency")
+//       .set_measure(::opencensus::trace::kSpanLatencyMeasureName)
+//       .set_aggregation(::opencensus::stats::Aggregation::Distribution(
+//           ::opencensus::stats::BucketBoundaries::Exponential(20, 1, 2)))
+//       .add_column(::opencensus::trace::SpanMetrics::NameTagKey())
+//       .add_column(::opencensus::trace::SpanMetrics::StatusTagKey())
+//       .RegisterForExport();
+//
+// The tags for each Span name are built once, when a Span with that name
+// first starts, so ending a Span costs one stats record. Spans that are not
+// sampled keep just their start time and status for this. Up to 1000 distinct
+// Span names are tagged; later names are recorded under "other".
+//
+// SpanMetrics is thread-safe.
+class SpanMetrics final {
+ public:
+  // Registers the measure and tag keys, if needed, and records Spans that
+  // start from now on.
+  static void Enable();
+
+  // Stops recording Spans that start from now on. Spans that already started
+  // are still recorded when they end.
+  static void Disable();
+
+  // Returns the latency measure, registering it if needed.
+  static stats::MeasureDouble LatencyMeasure();
+
+  // Return the tag keys, "span_name" and "span_status".
+  static stats::TagKey NameTagKey();
+  static stats::TagKey StatusTagKey();
+
+  SpanMetrics() = delete;
+};
+
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_SPAN_METRICS_H_
@@ -15,18 +15,45 @@
 #ifndef OPENCENSUS_TRACE_TRACE_CONFIG_H_
 #define OPENCENSUS_TRACE_TRACE_CONFIG_H_
 
+#include <memory>
+
+#include "opencensus/trace/sampler.h"
 #include "opencensus/trace/trace_params.h"
 
 namespace opencensus {
 namespace trace {
 
+// How sampled spans are tracked for RunningSpanStore while they are running.
+enum class RunningSpanTracking {
+  // Running spans are not tracked, and RunningSpanStore only reports spans
+  // started while tracking was enabled. This has no per-span cost.
+  kDisabled,
+  // Running spans are kept in a sharded hash map. This is the default.
+  kSharded,
+  // Running spans are linked into per-thread intrusive lists. Starting and
+  // ending a span does not allocate, but RunningSpanStore queries block spans
+  // on a thread from starting or ending while that thread's spans are copied.
+  kPerThreadLists,
+};
+
 // TraceConfig holds the currently active TraceParams.
 // TraceConfig is thread-safe.
 class TraceConfig {
  public:
-  // Sets the currently active TraceParams. Doing this is not atomic: individual
-  // parts of the active TraceParams are updated separately.
+  // Sets the currently active TraceParams. The update is atomic: a Span is
+  // started with either the previous or the new TraceParams. This also resets
+  // the default Sampler to params.sampler.
   static void SetCurrentTraceParams(const TraceParams& params);
+
+  // Sets the Sampler used for Spans that are started without one, which may be
+  // any Sampler implementation, keeping the other TraceParams. It remains in
+  // effect until the next call to SetDefaultSampler() or
+  // SetCurrentTraceParams().
+  static void SetDefaultSampler(std::shared_ptr<const Sampler> sampler);
+
+  // Sets how spans started from now on are tracked while running. Spans that
+  // are already running remain tracked until they end.
+  static void SetRunningSpanTracking(RunningSpanTracking tracking);
 };
 
 }  // namespace trace
@@ -0,0 +1,95 @@
+// Copyright 2018, OpenCensus Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef OPENCENSUS_TRACE_WITH_SPAN_H_
+#define OPENCENSUS_TRACE_WITH_SPAN_H_
+
+#include <functional>
+
+#include "opencensus/trace/span.h"
+
+namespace opencensus {
+namespace trace {
+
+// WithSpan makes a Span the current Span of the thread for the lifetime of
+// the WithSpan object, and restores the previous one when it is destroyed.
+// Span::StartSpanWithCurrentParent() starts children of the current Span.
+// Scopes must be destroyed in the reverse order of their construction, on the
+// thread that constructed them, so they should only be stack-allocated.
+//
+// WithSpan refers to the Span rather than copying it, so it takes no
+// references and does not allocate; the Span must outlive the WithSpan, and
+// temporary Spans are rejected at compile time.
+//
+// Example:
+//   auto span = ::opencensus::trace::Span::StartSpan("MyOperation");
+//   {
+//     ::opencensus::trace::WithSpan ws(span);
+//     DoWork();  // Can call Span::StartSpanWithCurrentParent("SubOperation").
+//   }
+//   span.End();
+class WithSpan final {
+ public:
+  // If cond is false, the WithSpan does nothing.
+  explicit WithSpan(const Span& span, bool cond = true)
+      : previous_(current()), cond_(cond) {
+    if (cond_) current() = &span;
+  }
+  // A temporary would be destroyed while it is still the current Span.
+  explicit WithSpan(Span&& span, bool cond = true) = delete;
+
+  ~WithSpan() {
+    if (cond_) current() = previous_;
+  }
+
+  WithSpan(const WithSpan&) = delete;
+  WithSpan(WithSpan&&) = delete;
+  WithSpan& operator=(const WithSpan&) = delete;
+  WithSpan& operator=(WithSpan&&) = delete;
+
+ private:
+  friend class Span;
+  friend const Span& GetCurrentSpan();
+
+  // The thread's current Span, or nullptr. The pointer is constant-initialized,
+  // so accessing it needs no initialization check.
+  static const Span*& current() {
+    static thread_local const Span* current_span = nullptr;
+    return current_span;
+  }
+
+  const Span* const previous_;
+  const bool cond_;
+};
+
+// Returns the thread's current Span, or a blank Span if there is none. The
+// reference is valid until the current WithSpan is destroyed.
+//
+// A Span that is not recording keeps its span metrics state (see
+// span_metrics.h) in each copy: SetStatus() and End() on a copy are not seen by
+// the original, and ending both records the Span twice. Set the status of and
+// end the original Span instead of a copy.
+const Span& GetCurrentSpan();
+
+// Returns a function that runs fn with the Span that is current now as the
+// current Span, on whichever thread it is called. Use it to carry the current
+// Span across a hop to a thread pool or callback. The returned function keeps
+// a copy of the Span, so within fn the current Span is that copy: as with
+// GetCurrentSpan(), status set on a copy of it does not reach span metrics.
+std::function<void()> WrapWithCurrentSpan(std::function<void()> fn);
+
+}  // namespace trace
+}  // namespace opencensus
+
+#endif  // OPENCENSUS_TRACE_WITH_SPAN_H_